@@ -0,0 +1,114 @@
+#include "background_writer.h"
+
+#include <exception>
+#include <ostream>
+
+#include "fstream_utils.h"
+#include "string_formatter.h"
+
+background_writer::~background_writer()
+{
+    {
+        std::lock_guard<std::mutex> lock( mutex );
+        stopping = true;
+    }
+    queue_changed.notify_all();
+    if( worker.joinable() ) {
+        worker.join();
+    }
+}
+
+void background_writer::write( const std::string &path, std::string data )
+{
+    write( path, std::move( data ), [path]( const std::string & contents ) {
+        write_to_file( path, [&contents]( std::ostream & fout ) {
+            fout.write( contents.data(), contents.size() );
+        } );
+    } );
+}
+
+void background_writer::write( const std::string &key, std::string data, write_function writer )
+{
+    {
+        std::lock_guard<std::mutex> lock( mutex );
+        const uint64_t generation = next_generation++;
+        contents[key] = entry{ generation, std::make_shared<const std::string>( std::move( data ) ),
+                               std::move( writer ) };
+        queue.emplace_back( key, generation );
+        if( !worker.joinable() ) {
+            worker = std::thread( &background_writer::run, this );
+        }
+    }
+    queue_changed.notify_one();
+}
+
+std::shared_ptr<const std::string> background_writer::pending( const std::string &key ) const
+{
+    std::lock_guard<std::mutex> lock( mutex );
+    const auto iter = contents.find( key );
+    if( iter == contents.end() ) {
+        return nullptr;
+    }
+    return iter->second.data;
+}
+
+void background_writer::flush()
+{
+    std::unique_lock<std::mutex> lock( mutex );
+    write_done.wait( lock, [this] {
+        return queue.empty() && !busy;
+    } );
+}
+
+std::vector<std::string> background_writer::take_errors()
+{
+    std::lock_guard<std::mutex> lock( mutex );
+    std::vector<std::string> result;
+    result.swap( errors );
+    return result;
+}
+
+void background_writer::run()
+{
+    std::unique_lock<std::mutex> lock( mutex );
+    while( true ) {
+        queue_changed.wait( lock, [this] {
+            return stopping || !queue.empty();
+        } );
+        if( queue.empty() ) {
+            return;
+        }
+        const std::pair<std::string, uint64_t> job = queue.front();
+        queue.pop_front();
+        const auto iter = contents.find( job.first );
+        if( iter == contents.end() || iter->second.generation != job.second ) {
+            // Superseded by newer data that is queued further back.
+            write_done.notify_all();
+            continue;
+        }
+        const std::shared_ptr<const std::string> data = iter->second.data;
+        const write_function writer = iter->second.writer;
+        busy = true;
+        lock.unlock();
+
+        std::string error;
+        try {
+            writer( *data );
+        } catch( const std::exception &err ) {
+            error = err.what();
+        }
+
+        lock.lock();
+        busy = false;
+        if( !error.empty() ) {
+            // Keep the data around so readers still get it for the rest of the session.
+            errors.push_back( string_format( "%s: %s", job.first, error ) );
+        } else {
+            const auto written = contents.find( job.first );
+            if( written != contents.end() && written->second.generation == job.second ) {
+                contents.erase( written );
+            }
+        }
+        write_done.notify_all();
+    }
+}
@@ -0,0 +1,75 @@
+#pragma once
+#ifndef CATA_SRC_BACKGROUND_WRITER_H
+#define CATA_SRC_BACKGROUND_WRITER_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(_WIN32) && !defined(_MSC_VER)
+#   include "mingw.thread.h"
+#endif
+
+/**
+ * Writes files on a dedicated worker thread.
+ *
+ * Files are handed over already serialized, so the worker never touches game state.
+ * Until a queued file has reached the disk its contents can be retrieved with @ref pending,
+ * so readers always see the newest data without having to wait for the worker.
+ */
+class background_writer
+{
+    public:
+        background_writer() = default;
+        background_writer( const background_writer & ) = delete;
+        background_writer &operator=( const background_writer & ) = delete;
+        /** Writes all queued files before returning. */
+        ~background_writer();
+
+        using write_function = std::function<void( const std::string &data )>;
+
+        /** Queue @p data to be written to @p path, replacing any older queued data for it. */
+        void write( const std::string &path, std::string data );
+        /**
+         * Queue @p data under @p key, @p writer stores it on the worker thread.
+         * Like above, older data queued under the same key is replaced and never stored.
+         * @p writer reports failure by throwing.
+         */
+        void write( const std::string &key, std::string data, write_function writer );
+        /** Contents queued for @p key that have not been written yet, or nullptr. */
+        std::shared_ptr<const std::string> pending( const std::string &key ) const;
+        /** Block until all queued files have been written. */
+        void flush();
+        /** Descriptions of writes that failed since the last call. */
+        std::vector<std::string> take_errors();
+
+    private:
+        struct entry {
+            uint64_t generation;
+            std::shared_ptr<const std::string> data;
+            write_function writer;
+        };
+
+        void run();
+
+        mutable std::mutex mutex;
+        std::condition_variable queue_changed;
+        std::condition_variable write_done;
+        std::deque<std::pair<std::string, uint64_t>> queue;
+        std::map<std::string, entry> contents;
+        std::vector<std::string> errors;
+        uint64_t next_generation = 0;
+        bool busy = false;
+        bool stopping = false;
+        std::thread worker;
+};
+
+#endif // CATA_SRC_BACKGROUND_WRITER_H
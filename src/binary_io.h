@@ -0,0 +1,79 @@
+#pragma once
+#ifndef CATA_SRC_BINARY_IO_H
+#define CATA_SRC_BINARY_IO_H
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+/**
+ * Helpers for compact binary save formats.
+ *
+ * Integers are always stored little-endian with a fixed width, regardless of the
+ * host byte order, so files can be moved between platforms. Strings are stored
+ * with a 32 bit length prefix.
+ *
+ * All read functions throw std::runtime_error on truncated or malformed input.
+ */
+namespace binary_io
+{
+
+template<typename T>
+inline void write( std::ostream &out, T value )
+{
+    static_assert( std::is_integral<T>::value && !std::is_same<T, bool>::value,
+                   "binary_io::write only supports integral types" );
+    using U = std::make_unsigned_t<T>;
+    const U v = static_cast<U>( value );
+    char buf[sizeof( T )];
+    for( size_t i = 0; i < sizeof( T ); i++ ) {
+        buf[i] = static_cast<char>( ( v >> ( 8 * i ) ) & 0xFF );
+    }
+    out.write( buf, sizeof( T ) );
+}
+
+template<typename T>
+inline T read( std::istream &in )
+{
+    static_assert( std::is_integral<T>::value && !std::is_same<T, bool>::value,
+                   "binary_io::read only supports integral types" );
+    using U = std::make_unsigned_t<T>;
+    char buf[sizeof( T )];
+    if( !in.read( buf, sizeof( T ) ) ) {
+        throw std::runtime_error( "unexpected end of binary data" );
+    }
+    U v = 0;
+    for( size_t i = 0; i < sizeof( T ); i++ ) {
+        v |= static_cast<U>( static_cast<U>( static_cast<unsigned char>( buf[i] ) ) << ( 8 * i ) );
+    }
+    return static_cast<T>( v );
+}
+
+inline void write_string( std::ostream &out, const std::string &str )
+{
+    write<uint32_t>( out, static_cast<uint32_t>( str.size() ) );
+    out.write( str.data(), str.size() );
+}
+
+inline std::string read_string( std::istream &in )
+{
+    // Guards against allocating gigabytes because of a corrupted length prefix.
+    static constexpr uint32_t max_len = 256 * 1024 * 1024;
+    const uint32_t len = read<uint32_t>( in );
+    if( len > max_len ) {
+        throw std::runtime_error( "binary string length out of range" );
+    }
+    std::string result( len, '\0' );
+    if( len > 0 && !in.read( &result[0], len ) ) {
+        throw std::runtime_error( "unexpected end of binary data" );
+    }
+    return result;
+}
+
+} // namespace binary_io
+
+#endif // CATA_SRC_BINARY_IO_H
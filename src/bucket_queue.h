@@ -0,0 +1,81 @@
+#pragma once
+#ifndef CATA_SRC_BUCKET_QUEUE_H
+#define CATA_SRC_BUCKET_QUEUE_H
+
+#include <algorithm>
+#include <cassert>
+#include <climits>
+#include <cstddef>
+#include <vector>
+
+namespace cata
+{
+
+/**
+ * @brief Priority queue for small non-negative integer priorities, lowest first.
+ *
+ * Every priority has its own bucket, so pushing and popping is O(1) as long as
+ * the popped priorities mostly increase, like they do in A* searches.
+ * Elements of equal priority are popped in LIFO order.
+ * @ref clear keeps all memory, so a queue can be reused without allocating.
+ */
+template<typename T>
+class bucket_queue
+{
+    public:
+        bool empty() const {
+            return count == 0;
+        }
+        size_t size() const {
+            return count;
+        }
+
+        void push( int priority, const T &value ) {
+            assert( priority >= 0 );
+            if( static_cast<size_t>( priority ) >= buckets.size() ) {
+                buckets.resize( priority + 1 );
+            }
+            buckets[priority].push_back( value );
+            lowest = std::min( lowest, priority );
+            highest = std::max( highest, priority );
+            count++;
+        }
+
+        /** Priority of the element @ref pop would return. The queue must not be empty. */
+        int top_priority() {
+            assert( !empty() );
+            while( buckets[lowest].empty() ) {
+                lowest++;
+            }
+            return lowest;
+        }
+
+        /** Remove and return an element with the lowest priority. The queue must not be empty. */
+        T pop() {
+            std::vector<T> &bucket = buckets[top_priority()];
+            T result = bucket.back();
+            bucket.pop_back();
+            count--;
+            return result;
+        }
+
+        void clear() {
+            for( int i = lowest; i <= highest; i++ ) {
+                buckets[i].clear();
+            }
+            count = 0;
+            lowest = INT_MAX;
+            highest = -1;
+        }
+
+    private:
+        std::vector<std::vector<T>> buckets;
+        size_t count = 0;
+        // All non-empty buckets are within this range.
+        int lowest = INT_MAX;
+        int highest = -1;
+};
+
+} // namespace cata
+
+#endif // CATA_SRC_BUCKET_QUEUE_H
@@ -74,6 +74,7 @@
 #include "pathfinding.h"
 #include "player.h"
 #include "profession.h"
+#include "recipe_availability.h"
 #include "recipe_dictionary.h"
 #include "ret_val.h"
 #include "rng.h"
@@ -62,6 +62,7 @@ class ma_technique;
 class known_magic;
 class player;
 class player_morale;
+class recipe_availability_cache;
 class recipe_subset;
 class vehicle;
 class monster;
@@ -2011,6 +2012,12 @@ class Character : public Creature, public visitable<Character>
         const inventory &crafting_inventory( const tripoint &src_pos = tripoint_zero,
                                              int radius = PICKUP_RANGE, bool clear_path = true );
         void invalidate_crafting_inventory();
+        /** Changes each time @ref crafting_inventory is formed anew. */
+        uint64_t crafting_inventory_generation() const {
+            return cached_crafting_generation;
+        }
+        /** Availability of recipes for the items of @ref crafting_inventory. */
+        recipe_availability_cache &get_crafting_availability();
 
         /** Returns all known recipes. */
         const recipe_subset &get_learned_recipes() const;
@@ -2240,6 +2247,8 @@ class Character : public Creature, public visitable<Character>
         int cached_moves = 0;
         tripoint cached_position;
         inventory cached_crafting_inventory;
+        uint64_t cached_crafting_generation = 0;
+        pimpl<recipe_availability_cache> crafting_availability;
 
         mutable std::map<std::string, double> npc_ai_info_cache;
 
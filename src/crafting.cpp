@@ -58,6 +58,7 @@
 #include "player_activity.h"
 #include "point.h"
 #include "recipe.h"
+#include "recipe_availability.h"
 #include "recipe_dictionary.h"
 #include "requirements.h"
 #include "ret_val.h"
@@ -588,6 +589,9 @@ const inventory &Character::crafting_inventory( const tripoint &src_pos, int rad
     cached_moves = moves;
     cached_time = calendar::turn;
     cached_position = inv_pos;
+    // Shared by all characters, so a cache never sees the same generation for another inventory.
+    static uint64_t last_generation = 0;
+    cached_crafting_generation = ++last_generation;
     // cache the qualities of the items in cached_crafting_inventory
     cached_crafting_inventory.update_quality_cache();
     return cached_crafting_inventory;
@@ -599,6 +603,11 @@ void Character::invalidate_crafting_inventory()
     cached_position = tripoint_min;
 }
 
+recipe_availability_cache &Character::get_crafting_availability()
+{
+    return *crafting_availability;
+}
+
 void player::make_craft( const recipe_id &id_to_make, int batch_size, const tripoint &loc )
 {
     make_craft_with_command( id_to_make, batch_size, false, loc );
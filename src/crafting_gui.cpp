@@ -31,6 +31,7 @@
 #include "output.h"
 #include "point.h"
 #include "recipe.h"
+#include "recipe_availability.h"
 #include "recipe_dictionary.h"
 #include "requirements.h"
 #include "string_formatter.h"
@@ -45,6 +46,8 @@
 static const std::string flag_BLIND_EASY( "BLIND_EASY" );
 static const std::string flag_BLIND_HARD( "BLIND_HARD" );
 
+static const trait_id trait_DEBUG_HS( "DEBUG_HS" );
+
 class inventory;
 class npc;
 
@@ -244,20 +247,12 @@ const recipe *select_crafting_recipe( int &batch_size )
     std::vector<const recipe *> current;
 
     struct availability {
-        availability( const recipe *r, int batch_size, bool known ) {
+        availability( const recipe_availability &avail, bool known ) {
             this->known = known;
-            const inventory &inv = get_avatar().crafting_inventory();
-            auto all_items_filter = r->get_component_filter( recipe_filter_flags::none );
-            auto no_rotten_filter = r->get_component_filter( recipe_filter_flags::no_rotten );
-            const deduped_requirement_data &req = r->deduped_requirements();
-            could_craft_if_knew = req.can_make_with_inventory(
-                                      inv, all_items_filter, batch_size, cost_adjustment::start_only );
+            could_craft_if_knew = avail.can_craft;
             can_craft = known && could_craft_if_knew;
-            can_craft_non_rotten = req.can_make_with_inventory(
-                                       inv, no_rotten_filter, batch_size, cost_adjustment::start_only );
-            const requirement_data &simple_req = r->simple_requirements();
-            apparently_craftable = simple_req.can_make_with_inventory(
-                                       inv, all_items_filter, batch_size, cost_adjustment::start_only );
+            can_craft_non_rotten = avail.can_craft_non_rotten;
+            apparently_craftable = avail.apparently_craftable;
         }
         bool can_craft;
         bool can_craft_non_rotten;
@@ -329,6 +324,14 @@ const recipe *select_crafting_recipe( int &batch_size )
     }
     const auto &all_recipes = recipe_subset( {}, all_recipes_flat );
 
+    // Only recipes using items that changed since the menu was last open are checked again.
+    // The debug trait meets all requirements without looking at the items.
+    recipe_availability_cache &craftable = u.get_crafting_availability();
+    if( u.has_trait( trait_DEBUG_HS ) ) {
+        craftable.clear();
+    }
+    craftable.update( crafting_inv, u.crafting_inventory_generation(), all_recipes );
+
     int recipe_scroll_window_min = 0;
     ui.on_redraw( [&]( const ui_adaptor & ) {
         const TAB_MODE m = ( batch ) ? BATCH : ( filterstring.empty() ) ? NORMAL : FILTERED;
@@ -629,7 +632,8 @@ const recipe *select_crafting_recipe( int &batch_size )
                 current.clear();
                 for( int i = 1; i <= 50; i++ ) {
                     current.push_back( chosen );
-                    available.push_back( availability( chosen, i,
+                    const recipe_availability batch_avail( *chosen, crafting_inv, i );
+                    available.push_back( availability( batch_avail,
                                                        !show_unavailable || available_recipes.contains( *chosen ) ) );
                 }
             } else {
@@ -730,8 +734,9 @@ const recipe *select_crafting_recipe( int &batch_size )
                 // cache recipe availability on first display
                 for( const recipe *e : current ) {
                     if( availability_cache.count( e ) == 0 ) {
-                        availability_cache.emplace( e, availability( e, 1,
-                                                    !show_unavailable || available_recipes.contains( *e ) ) );
+                        const bool known = !show_unavailable || available_recipes.contains( *e );
+                        const recipe_availability &avail = craftable.get( *e, crafting_inv );
+                        availability_cache.emplace( e, availability( avail, known ) );
                     }
                 }
 
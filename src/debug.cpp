@@ -16,9 +16,11 @@
 #include <locale>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <set>
 #include <sstream>
 #include <sys/stat.h>
+#include <thread>
 #include <type_traits>
 #include <utility>
 #include <vector>
@@ -160,6 +162,57 @@ static std::vector<buffered_prompt_info> &buffered_prompts()
     return buffered_prompts;
 }
 
+namespace
+{
+struct deferred_debugmsg {
+    std::string filename;
+    std::string line;
+    std::string funcname;
+    std::string text;
+};
+
+// Statics are initialized before main runs, so this is the game thread.
+const std::thread::id game_thread_id = std::this_thread::get_id();
+} // namespace
+
+bool on_game_thread()
+{
+    // Not initialized yet when called from the initializers of other statics.
+    return game_thread_id == std::thread::id() || std::this_thread::get_id() == game_thread_id;
+}
+
+// debugmsgs of worker threads, they can't prompt and wait for the game thread
+static std::vector<deferred_debugmsg> &deferred_debugmsgs()
+{
+    static std::vector<deferred_debugmsg> deferred;
+    return deferred;
+}
+
+static std::mutex &deferred_debugmsgs_mutex()
+{
+    static std::mutex mutex;
+    return mutex;
+}
+
+// Workers write to the debug log too, see DebugLogGuard
+static std::recursive_mutex &debug_log_mutex()
+{
+    static std::recursive_mutex mutex;
+    return mutex;
+}
+
+void report_deferred_debugmsgs()
+{
+    std::vector<deferred_debugmsg> deferred;
+    {
+        std::lock_guard<std::mutex> lock( deferred_debugmsgs_mutex() );
+        deferred.swap( deferred_debugmsgs() );
+    }
+    for( const deferred_debugmsg &msg : deferred ) {
+        realDebugmsg( msg.filename.c_str(), msg.line.c_str(), msg.funcname.c_str(), msg.text );
+    }
+}
+
 static void debug_error_prompt(
     const char *filename,
     const char *line,
@@ -386,6 +439,14 @@ void realDebugmsg( const char *filename, const char *line, const char *funcname,
     assert( line != nullptr );
     assert( funcname != nullptr );
 
+    if( !on_game_thread() ) {
+        std::lock_guard<std::mutex> lock( deferred_debugmsgs_mutex() );
+        deferred_debugmsgs().push_back( { filename, line, funcname, text } );
+        return;
+    }
+    // Whatever workers reported before is older than this.
+    report_deferred_debugmsgs();
+
     if( capturing ) {
         captured += text;
     } else {
@@ -1158,11 +1219,11 @@ detail::DebugLogGuard::~DebugLogGuard()
 detail::DebugLogGuard detail::realDebugLog( DL lev, DC cl, const char *filename,
         const char *line, const char *funcname )
 {
-    if( lev == DL::Error ) {
-        error_observed = true;
-    }
-
     if( checkDebugLevelClass( lev, cl ) ) {
+        std::unique_lock<std::recursive_mutex> lock( debug_log_mutex() );
+        if( lev == DL::Error ) {
+            error_observed = true;
+        }
         std::ostream &out = debugFile().get_file();
 
         output_repetitions( out );
@@ -1203,11 +1264,11 @@ detail::DebugLogGuard detail::realDebugLog( DL lev, DC cl, const char *filename,
         }
 #endif
 
-        return DebugLogGuard( out );
+        return DebugLogGuard( out, std::move( lock ) );
     }
 
-    static NullBuf nullBuf;
-    static std::ostream nullStream( &nullBuf );
+    static thread_local NullBuf nullBuf;
+    static thread_local std::ostream nullStream( &nullBuf );
     return DebugLogGuard( nullStream );
 }
 
@@ -48,6 +48,7 @@
 // Includes                                                         {{{1
 // ---------------------------------------------------------------------
 #include <iostream>
+#include <mutex>
 #include <string>
 #include <type_traits>
 #include <utility>
@@ -232,6 +233,16 @@ void debug_reset_ignored_messages();
  */
 std::string capture_debugmsg_during( const std::function<void()> &func );
 
+/**
+ * debugmsg calls on other threads than the game thread are only queued, this reports
+ * them on the game thread. Called by every debugmsg on the game thread, and by code
+ * that collects the results of worker threads.
+ */
+void report_deferred_debugmsgs();
+
+/** Whether this is the thread the game runs on, the one that initialized the statics. */
+bool on_game_thread();
+
 /**
  * Should be called after catacurses::stdscr is initialized.
  * If catacurses::stdscr is available, shows all buffered debugmsg prompts.
@@ -252,8 +263,12 @@ namespace detail
 class DebugLogGuard
 {
         std::ostream *s;
+        // Keeps the lines of other threads out until this one is done.
+        std::unique_lock<std::recursive_mutex> lock;
     public:
         explicit DebugLogGuard( std::ostream &s ) : s( &s ) {}
+        DebugLogGuard( std::ostream &s, std::unique_lock<std::recursive_mutex> &&lock ) :
+            s( &s ), lock( std::move( lock ) ) {}
         ~DebugLogGuard();
 
         std::ostream &operator*() {
@@ -56,6 +56,7 @@
 #include "map.h"
 #include "map_extras.h"
 #include "map_iterator.h"
+#include "mapbuffer.h"
 #include "mapgen.h"
 #include "mapgendata.h"
 #include "martialarts.h"
@@ -182,6 +183,7 @@ enum debug_menu_index {
     DEBUG_NESTED_MAPGEN,
     DEBUG_RESET_IGNORED_MESSAGES,
     DEBUG_RELOAD_TILES,
+    DEBUG_CONVERT_MAP_SAVES,
 };
 
 class mission_debug
@@ -301,6 +303,7 @@ static int map_uilist()
         { uilist_entry( DEBUG_OM_EDITOR, true, 'O', _( "Overmap editor" ) ) },
         { uilist_entry( DEBUG_MAP_EXTRA, true, 'm', _( "Spawn map extra" ) ) },
         { uilist_entry( DEBUG_NESTED_MAPGEN, true, 'n', _( "Spawn nested mapgen" ) ) },
+        { uilist_entry( DEBUG_CONVERT_MAP_SAVES, true, 'c', _( "Convert saved map files to world's format" ) ) },
     };
 
     return uilist( _( "Map…" ), uilist_initializer );
@@ -1368,7 +1371,7 @@ void debug()
             for( int i = 0; i < OMAPX; i++ ) {
                 for( int j = 0; j < OMAPY; j++ ) {
                     for( int k = -OVERMAP_DEPTH; k <= OVERMAP_HEIGHT; k++ ) {
-                        cur_om.seen( { i, j, k } ) = true;
+                        cur_om.set_seen( { i, j, k }, true );
                     }
                 }
             }
@@ -1935,6 +1938,11 @@ void debug()
         case DEBUG_NESTED_MAPGEN:
             debug_menu::spawn_nested_mapgen();
             break;
+        case DEBUG_CONVERT_MAP_SAVES: {
+            const int converted = MAPBUFFER.convert_saved_quads();
+            add_msg( m_info, _( "Converted %d saved map files." ), converted );
+            break;
+        }
         case DEBUG_DISPLAY_NPC_PATH:
             g->debug_pathfinding = !g->debug_pathfinding;
             break;
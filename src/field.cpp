@@ -145,6 +145,39 @@ field::field()
 {
 }
 
+field::field( const field &other )
+    : inline_fields( other.inline_fields ),
+      more_fields( other.more_fields ? std::make_unique<overflow_list>( *other.more_fields ) :
+                   nullptr ),
+      _displayed_field_type( other._displayed_field_type ), inline_used( other.inline_used )
+{
+}
+
+field &field::operator=( const field &other )
+{
+    if( this != &other ) {
+        *this = field( other );
+    }
+    return *this;
+}
+
+field::entry *field::find_entry( const field_type_id &field_type_to_find )
+{
+    for( int i = 0; i < inline_slots; i++ ) {
+        if( ( inline_used & ( 1 << i ) ) && inline_fields[i].first == field_type_to_find ) {
+            return &inline_fields[i];
+        }
+    }
+    if( more_fields ) {
+        for( entry &e : *more_fields ) {
+            if( e.first == field_type_to_find ) {
+                return &e;
+            }
+        }
+    }
+    return nullptr;
+}
+
 /*
 Function: find_field
 Returns a field entry corresponding to the field_type_id parameter passed in. If no fields are found then returns NULL.
@@ -155,23 +188,13 @@ field_entry *field::find_field( const field_type_id &field_type_to_find )
     if( !_displayed_field_type ) {
         return nullptr;
     }
-    const auto it = _field_type_list.find( field_type_to_find );
-    if( it != _field_type_list.end() ) {
-        return &it->second;
-    }
-    return nullptr;
+    entry *const e = find_entry( field_type_to_find );
+    return e != nullptr ? &e->second : nullptr;
 }
 
 const field_entry *field::find_field_c( const field_type_id &field_type_to_find ) const
 {
-    if( !_displayed_field_type ) {
-        return nullptr;
-    }
-    const auto it = _field_type_list.find( field_type_to_find );
-    if( it != _field_type_list.end() ) {
-        return &it->second;
-    }
-    return nullptr;
+    return const_cast<field *>( this )->find_field( field_type_to_find );
 }
 
 const field_entry *field::find_field( const field_type_id &field_type_to_find ) const
@@ -195,8 +218,7 @@ bool field::add_field( const field_type_id &field_type_to_add, const int new_int
         debugmsg( "Tried to add null field" );
         return false;
     }
-    auto it = _field_type_list.find( field_type_to_add );
-    if( it != _field_type_list.end() ) {
+    if( entry *const it = find_entry( field_type_to_add ) ) {
         // Most fields stack intensities, but some add duration instead
         if( it->first->stacking_type == fields::stacking_type::intensity ) {
             it->second.set_field_intensity( it->second.get_field_intensity() + new_intensity );
@@ -212,29 +234,50 @@ bool field::add_field( const field_type_id &field_type_to_add, const int new_int
         field_type_to_add.obj().priority >= _displayed_field_type.obj().priority ) {
         _displayed_field_type = field_type_to_add;
     }
-    _field_type_list[field_type_to_add] = field_entry( field_type_to_add, new_intensity, new_age );
+    entry added( field_type_to_add, field_entry( field_type_to_add, new_intensity, new_age ) );
+    for( int i = 0; i < inline_slots; i++ ) {
+        if( !( inline_used & ( 1 << i ) ) ) {
+            inline_fields[i] = added;
+            inline_used |= 1 << i;
+            return true;
+        }
+    }
+    if( !more_fields ) {
+        more_fields = std::make_unique<overflow_list>();
+    }
+    auto pos = more_fields->begin();
+    while( pos != more_fields->end() && pos->first < field_type_to_add ) {
+        ++pos;
+    }
+    more_fields->insert( pos, added );
     return true;
 }
 
 bool field::remove_field( const field_type_id &field_to_remove )
 {
-    const auto it = _field_type_list.find( field_to_remove );
-    if( it == _field_type_list.end() ) {
-        return false;
+    for( iterator it = begin(); it != end(); ++it ) {
+        if( it->first == field_to_remove ) {
+            remove_field( it );
+            return true;
+        }
     }
-    remove_field( it );
-    return true;
+    return false;
 }
 
-void field::remove_field( std::map<field_type_id, field_entry>::iterator const it )
+void field::remove_field( const iterator it )
 {
-    _field_type_list.erase( it );
+    if( it.slot < inline_slots ) {
+        inline_used &= ~( 1 << it.slot );
+    } else {
+        more_fields->erase( it.list_it );
+        if( more_fields->empty() ) {
+            more_fields.reset();
+        }
+    }
     _displayed_field_type = fd_null;
-    if( !_field_type_list.empty() ) {
-        for( auto &fld : _field_type_list ) {
-            if( !_displayed_field_type || fld.first.obj().priority >= _displayed_field_type.obj().priority ) {
-                _displayed_field_type = fld.first;
-            }
+    for( auto &fld : *this ) {
+        if( !_displayed_field_type || fld.first.obj().priority >= _displayed_field_type.obj().priority ) {
+            _displayed_field_type = fld.first;
         }
     }
 }
@@ -245,33 +288,35 @@ Returns the number of fields existing on the current tile.
 */
 unsigned int field::field_count() const
 {
-    return _field_type_list.size();
+    unsigned int count = more_fields ? more_fields->size() : 0;
+    for( int i = 0; i < inline_slots; i++ ) {
+        if( inline_used & ( 1 << i ) ) {
+            count++;
+        }
+    }
+    return count;
 }
 
-std::map<field_type_id, field_entry>::iterator field::begin()
+field::iterator field::begin()
 {
-    return _field_type_list.begin();
+    return iterator( this, 0 );
 }
 
-std::map<field_type_id, field_entry>::const_iterator field::begin() const
+field::const_iterator field::begin() const
 {
-    return _field_type_list.begin();
+    return const_iterator( this, 0 );
 }
 
-std::map<field_type_id, field_entry>::iterator field::end()
+field::iterator field::end()
 {
-    return _field_type_list.end();
+    return iterator( this, iterator::end_slot );
 }
 
-std::map<field_type_id, field_entry>::const_iterator field::end() const
+field::const_iterator field::end() const
 {
-    return _field_type_list.end();
+    return const_iterator( this, const_iterator::end_slot );
 }
 
-/*
-Function: displayed_field_type
-Returns the last added field type from the tile for drawing purposes.
-*/
 field_type_id field::displayed_field_type() const
 {
     return _displayed_field_type;
@@ -285,7 +330,7 @@ description_affix field::displayed_description_affix() const
 int field::total_move_cost() const
 {
     int current_cost = 0;
-    for( auto &fld : _field_type_list ) {
+    for( const entry &fld : *this ) {
         current_cost += fld.second.move_cost();
     }
     return current_cost;
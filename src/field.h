@@ -2,8 +2,14 @@
 #ifndef CATA_SRC_FIELD_H
 #define CATA_SRC_FIELD_H
 
-#include <map>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <list>
+#include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "calendar.h"
@@ -126,11 +132,111 @@ class field_entry
  * Use @ref find_field to get the field entry of a specific type, or iterate over
  * all entries via @ref begin and @ref end (allows range based iteration).
  * There is @ref displayed_field_type to specific which field should be drawn on the map.
+ *
+ * Almost all tiles have no more than two fields, those are stored in the field itself.
+ * Only further entries need an allocation. Entries never move once added, so adding
+ * fields doesn't invalidate references or iterators, and removing one only invalidates
+ * the iterators pointing to it.
 */
 class field
 {
     public:
+        using entry = std::pair<field_type_id, field_entry>;
+
+    private:
+        static constexpr int inline_slots = 2;
+        using overflow_list = std::list<entry>;
+
+        template<typename Field, typename Entry, typename ListIterator>
+        class iterator_base
+        {
+            public:
+                using iterator_category = std::forward_iterator_tag;
+                using value_type = entry;
+                using difference_type = std::ptrdiff_t;
+                using pointer = Entry *;
+                using reference = Entry &;
+
+                iterator_base() = default;
+
+                reference operator*() const {
+                    return slot < inline_slots ? fld->inline_fields[slot] : *list_it;
+                }
+                pointer operator->() const {
+                    return &**this;
+                }
+                iterator_base &operator++() {
+                    seek( &**this );
+                    return *this;
+                }
+                iterator_base operator++( int ) {
+                    iterator_base old = *this;
+                    ++*this;
+                    return old;
+                }
+                bool operator==( const iterator_base &rhs ) const {
+                    return slot == rhs.slot && ( slot != list_slot || list_it == rhs.list_it );
+                }
+                bool operator!=( const iterator_base &rhs ) const {
+                    return !( *this == rhs );
+                }
+
+            private:
+                friend class field;
+                // Slot of the iterators to entries in @ref field::more_fields.
+                static constexpr int list_slot = inline_slots;
+                static constexpr int end_slot = inline_slots + 1;
+
+                iterator_base( Field *fld, int first_slot ) : fld( fld ) {
+                    if( first_slot == end_slot ) {
+                        slot = end_slot;
+                    } else {
+                        seek( nullptr );
+                    }
+                }
+
+                // Moves to the entry with the lowest type id above the one of @p after,
+                // or the lowest of all if it's null, so entries are visited in type id order.
+                void seek( const entry *after ) {
+                    const entry *best = nullptr;
+                    slot = end_slot;
+                    for( int i = 0; i < inline_slots; i++ ) {
+                        const entry &e = fld->inline_fields[i];
+                        if( ( fld->inline_used & ( 1 << i ) ) && ( !after || after->first < e.first ) &&
+                            ( !best || e.first < best->first ) ) {
+                            best = &e;
+                            slot = i;
+                        }
+                    }
+                    if( fld->more_fields ) {
+                        // The list is sorted, only its first entry past after can come next.
+                        for( auto it = fld->more_fields->begin(); it != fld->more_fields->end(); ++it ) {
+                            if( !after || after->first < it->first ) {
+                                if( !best || it->first < best->first ) {
+                                    slot = list_slot;
+                                    list_it = it;
+                                }
+                                break;
+                            }
+                        }
+                    }
+                }
+
+                Field *fld = nullptr;
+                int slot = end_slot;
+                ListIterator list_it;
+        };
+
+    public:
+        using iterator = iterator_base<field, entry, overflow_list::iterator>;
+        using const_iterator =
+            iterator_base<const field, const entry, overflow_list::const_iterator>;
+
         field();
+        field( const field &other );
+        field( field && ) = default;
+        field &operator=( const field &other );
+        field &operator=( field && ) = default;
 
         /**
          * Returns a field entry corresponding to the field_type_id parameter passed in.
@@ -167,9 +273,9 @@ class field
         bool remove_field( const field_type_id &field_to_remove );
         /**
          * Make sure to decrement the field counter in the submap.
-         * Removes the field entry, the iterator must point into @ref _field_type_list and must be valid.
+         * Removes the field entry, the iterator must point into this field and must be valid.
          */
-        void remove_field( std::map<field_type_id, field_entry>::iterator );
+        void remove_field( iterator );
 
         // Returns the number of fields existing on the current tile.
         unsigned int field_count() const;
@@ -182,12 +288,12 @@ class field
         description_affix displayed_description_affix() const;
 
         //Returns the vector iterator to begin searching through the list.
-        std::map<field_type_id, field_entry>::iterator begin();
-        std::map<field_type_id, field_entry>::const_iterator begin() const;
+        iterator begin();
+        const_iterator begin() const;
 
         //Returns the vector iterator to end searching through the list.
-        std::map<field_type_id, field_entry>::iterator end();
-        std::map<field_type_id, field_entry>::const_iterator end() const;
+        iterator end();
+        const_iterator end() const;
 
         /**
          * Returns the total move cost from all fields.
@@ -195,10 +301,15 @@ class field
         int total_move_cost() const;
 
     private:
-        // A pointer lookup table of all field effects on the current tile.
-        std::map<field_type_id, field_entry> _field_type_list;
+        entry *find_entry( const field_type_id &field_type_to_find );
+
+        // The first field entries of the tile, the bits of @ref inline_used tell which are in use.
+        std::array<entry, inline_slots> inline_fields;
+        // Entries that didn't fit into @ref inline_fields sorted by type, only allocated while there are any.
+        std::unique_ptr<overflow_list> more_fields;
         //_displayed_field_type currently is equal to the last field added to the square. You can modify this behavior in the class functions if you wish.
         field_type_id _displayed_field_type;
+        uint8_t inline_used = 0;
 };
 
 #endif // CATA_SRC_FIELD_H
@@ -0,0 +1,142 @@
+#include "flow_field.h"
+
+#include <algorithm>
+#include <climits>
+
+#include "bucket_queue.h"
+#include "line.h"
+#include "map.h"
+
+// Opposite directions differ only in the lowest bit, diagonals come last.
+static constexpr std::array<point, 8> neighbor_offsets = {{
+        point_west, point_east, point_north, point_south,
+        point_north_east, point_south_west, point_north_west, point_south_east
+    }
+};
+
+// A field is only built once this many creatures asked for it within a turn.
+static constexpr int min_requests = 3;
+static constexpr size_t max_cached_fields = 16;
+
+static int flat_index( point p )
+{
+    return p.x * MAPSIZE_Y + p.y;
+}
+
+flow_field::flow_field( const map &m, const tripoint &target,
+                        const pathfinding_settings &settings ) : target_( target ), settings_( settings )
+{
+    next_step.fill( no_route );
+    const pathfinding_cache &pf_cache = m.get_pathfinding_cache_ref( target.z );
+    std::vector<int> distance( MAPSIZE_X * MAPSIZE_Y, INT_MAX );
+    cata::bucket_queue<point> open;
+    distance[flat_index( target.xy() )] = 0;
+    open.push( 0, target.xy() );
+    while( !open.empty() ) {
+        const int dist = open.top_priority();
+        const point cur = open.pop();
+        if( dist > distance[flat_index( cur )] ) {
+            // Found a shorter way to this tile after it was queued.
+            continue;
+        }
+        for( size_t i = 0; i < neighbor_offsets.size(); i++ ) {
+            const point next = cur + neighbor_offsets[i];
+            if( !m.inbounds( tripoint( next, target.z ) ) ) {
+                continue;
+            }
+            // Routes from next step onto cur.
+            const route_step step = m.route_step_cost( pf_cache, tripoint( next, target.z ),
+                                    tripoint( cur, target.z ), settings );
+            if( step.what != route_step::kind::enter ) {
+                continue;
+            }
+            // Penalize diagonals like map::route does
+            const int next_dist = dist + step.cost + ( i >= 4 ? 1 : 0 );
+            int &known = distance[flat_index( next )];
+            if( next_dist <= settings.max_length && next_dist < known ) {
+                known = next_dist;
+                next_step[flat_index( next )] = static_cast<uint8_t>( i ^ 1 );
+                open.push( next_dist, next );
+            }
+        }
+    }
+}
+
+cata::optional<std::vector<tripoint>> flow_field::route_from( const map &m,
+                                   const tripoint &from ) const
+{
+    std::vector<tripoint> route;
+    if( from == target_ || !m.inbounds( from ) ) {
+        return route;
+    }
+    if( from.z != target_.z ) {
+        return cata::nullopt;
+    }
+    // The same shortcuts as map::route takes before searching.
+    route = plain_line_route( m, from, target_ );
+    if( !route.empty() ) {
+        return route;
+    }
+    if( rl_dist( from, target_ ) > settings_.max_dist ) {
+        return route;
+    }
+    // Longer routes are planned over the submaps by map::route, those are never shorter.
+    const bool bounded = square_dist( from.xy(), target_.xy() ) <= hierarchical_route_dist;
+    const half_open_rectangle<point> bounds = m.route_bounds( from, target_ );
+    point cur = from.xy();
+    while( cur != target_.xy() ) {
+        const uint8_t dir = next_step[flat_index( cur )];
+        if( dir == no_route ) {
+            return std::vector<tripoint>();
+        }
+        cur += neighbor_offsets[dir];
+        if( bounded && !bounds.contains( cur ) ) {
+            return cata::nullopt;
+        }
+        route.emplace_back( cur, target_.z );
+    }
+    return route;
+}
+
+const flow_field *flow_field_cache::get( const map &m, const tripoint &target,
+        const pathfinding_settings &settings )
+{
+    const time_point now = calendar::turn;
+    auto iter = std::find_if( entries.begin(), entries.end(), [&]( const entry & e ) {
+        return e.target == target && e.settings == settings;
+    } );
+    if( iter == entries.end() ) {
+        if( entries.size() >= max_cached_fields ) {
+            entries.erase( std::min_element( entries.begin(), entries.end(),
+            []( const entry & lhs, const entry & rhs ) {
+                return lhs.last_request < rhs.last_request;
+            } ) );
+        }
+        entries.push_back( entry{ target, settings, now, 0, nullptr } );
+        iter = std::prev( entries.end() );
+    }
+
+    if( iter->last_request != now ) {
+        iter->last_request = now;
+        iter->requests = 0;
+    }
+    iter->requests++;
+    if( iter->field == nullptr && iter->requests >= min_requests ) {
+        iter->field = std::make_unique<flow_field>( m, target, settings );
+    }
+    return iter->field.get();
+}
+
+void flow_field_cache::invalidate( const int zlev )
+{
+    for( entry &e : entries ) {
+        if( e.target.z == zlev ) {
+            e.field.reset();
+        }
+    }
+}
+
+void flow_field_cache::clear()
+{
+    entries.clear();
+}
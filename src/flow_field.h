@@ -0,0 +1,85 @@
+#pragma once
+#ifndef CATA_SRC_FLOW_FIELD_H
+#define CATA_SRC_FLOW_FIELD_H
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "calendar.h"
+#include "game_constants.h"
+#include "optional.h"
+#include "pathfinding.h"
+#include "point.h"
+
+class map;
+
+/**
+ * Routes from every tile of a z-level to a single target.
+ *
+ * Built once with Dijkstra's algorithm, backwards from the target, using the same
+ * step costs as @ref map::route (see @ref map::route_step_cost). After that, any number
+ * of creatures with the same @ref pathfinding_settings can follow it at the cost of one
+ * lookup per step. Unlike @ref map::route, dropping down ledges is not considered.
+ */
+class flow_field
+{
+    public:
+        flow_field( const map &m, const tripoint &target, const pathfinding_settings &settings );
+
+        const tripoint &target() const {
+            return target_;
+        }
+        const pathfinding_settings &settings() const {
+            return settings_;
+        }
+
+        /**
+         * Route from @p from to the target, in the same form as returned by
+         * @ref map::route. Empty if the target can't be reached from there. Nothing if
+         * the route leaves the tiles @ref map::route would search, use that then.
+         */
+        cata::optional<std::vector<tripoint>> route_from( const map &m, const tripoint &from ) const;
+
+    private:
+        static constexpr uint8_t no_route = 0xFF;
+
+        tripoint target_;
+        pathfinding_settings settings_;
+        // Index into the neighbor offsets of the next step towards the target, or no_route.
+        std::array<uint8_t, MAPSIZE_X *MAPSIZE_Y> next_step;
+};
+
+/**
+ * The flow fields of a map.
+ *
+ * A field is only built once enough creatures asked for the same one during a turn,
+ * for single creatures @ref map::route is cheaper.
+ */
+class flow_field_cache
+{
+    public:
+        /**
+         * The field to @p target for @p settings, or nullptr if it is not (yet) worth
+         * building it. The result stays valid until the next call of any member.
+         */
+        const flow_field *get( const map &m, const tripoint &target,
+                               const pathfinding_settings &settings );
+        /** Drop all fields on @p zlev, because the map changed there. */
+        void invalidate( int zlev );
+        void clear();
+
+    private:
+        struct entry {
+            tripoint target;
+            pathfinding_settings settings;
+            time_point last_request;
+            int requests = 0;
+            std::unique_ptr<flow_field> field;
+        };
+
+        std::vector<entry> entries;
+};
+
+#endif // CATA_SRC_FLOW_FIELD_H
@@ -136,6 +136,7 @@
 #include "overmapbuffer.h"
 #include "panels.h"
 #include "path_info.h"
+#include "pathfinding.h"
 #include "pickup.h"
 #include "player.h"
 #include "player_activity.h"
@@ -1182,6 +1183,9 @@ bool game::cleanup_at_end()
                 }
             }
 
+            // Queued map files must not end up in the deleted world.
+            MAPBUFFER.flush_writes();
+            overmap_buffer.flush_writes();
             if( queryDelete || get_option<std::string>( "WORLD_END" ) == "delete" ) {
                 world_generator->delete_world( world_generator->active_world->world_name, true );
 
@@ -10608,6 +10612,26 @@ void game::vertical_notes( int z_before, int z_after )
     }
 }
 
+// Start reading the submaps that the player is heading towards from disk, so
+// shifting the map into them later does not have to wait for it.
+static void prefetch_submaps_ahead( const map &m, const player &p, point shift )
+{
+    // NOLINTNEXTLINE(cata-use-named-point-constants)
+    point dir = clamp( shift, inclusive_rectangle<point>( point( -1, -1 ), point( 1, 1 ) ) );
+    int distance = 1;
+    const vehicle *veh = p.in_vehicle ? veh_pointer_or_null( m.veh_at( p.pos() ) ) : nullptr;
+    if( veh != nullptr && veh->velocity != 0 ) {
+        const units::angle facing = veh->face.dir();
+        dir = point( std::lround( units::cos( facing ) ), std::lround( units::sin( facing ) ) );
+        if( veh->velocity < 0 ) {
+            dir = -dir;
+        }
+        // One more row for each 40 mph, fast vehicles cross a submap in very few turns.
+        distance = std::min( 1 + std::abs( veh->velocity ) / 4000, 3 );
+    }
+    m.prefetch_submaps( dir, distance );
+}
+
 point game::update_map( player &p )
 {
     point p2( p.posx(), p.posy() );
@@ -10642,6 +10666,7 @@ point game::update_map( int &x, int &y )
         // We need this call because even if the map hasn't shifted we may have changed z-level and can now see farther
         // TODO: only make this call if we changed z-level
         update_overmap_seen();
+        prefetch_submaps_ahead( m, u, shift );
         // Not actually shifting the submaps, all the stuff below would do nothing
         return point_zero;
     }
@@ -10657,6 +10682,8 @@ point game::update_map( int &x, int &y )
     }
 
     grid_tracker_ptr->load( m );
+    prefetch_submaps_ahead( m, u, shift );
+    overmap_buffer.generate_around( get_cur_om().pos() );
 
     // Shift monsters
     shift_monsters( tripoint( shift, 0 ) );
@@ -11171,8 +11198,11 @@ void game::debug_hour_timer::print_time()
         if( calendar::once_every( time_duration::from_hours( 1 ) ) ) {
             const IRLTimeMs now = std::chrono::time_point_cast<std::chrono::milliseconds>(
                                       std::chrono::system_clock::now() );
+            const pathfinding_cache_stats pf_stats = get_map().take_pathfinding_cache_stats();
             if( start_time ) {
                 add_msg( "in-game hour took: %d ms", ( now - *start_time ).count() );
+                add_msg( "pathfinding caches: %d full rebuilds, %d submaps rebuilt, %d kept",
+                         pf_stats.full_rebuilds, pf_stats.submaps_rebuilt, pf_stats.submaps_kept );
             } else {
                 add_msg( "starting debug timer" );
             }
@@ -2,8 +2,10 @@
 
 #include <cassert>
 #include <cstddef>
+#include <deque>
 #include <exception>
 #include <fstream>
+#include <future>
 #include <iterator>
 #include <memory>
 #include <sstream> // for throwing errors
@@ -95,6 +97,7 @@
 #include "start_location.h"
 #include "string_formatter.h"
 #include "text_snippets.h"
+#include "thread_pool.h"
 #include "translations.h"
 #include "trap.h"
 #include "type_id.h"
@@ -482,53 +485,90 @@ void DynamicDataLoader::load_data_from_path( const std::string &path, const std:
             files.push_back( path );
         }
     }
-    // iterate over each file
-    for( auto &files_i : files ) {
-        const std::string &file = files_i;
-        // open the file as a stream
-        cata_ifstream infile = std::move( cata_ifstream().mode( cata_ios_mode::binary ).open( file ) );
-        // and stuff it into ram
-        std::istringstream iss(
-            std::string(
-                ( std::istreambuf_iterator<char>( *infile ) ),
-                std::istreambuf_iterator<char>()
-            )
-        );
+    // Files are read and parsed on worker threads a few files ahead, and loaded here
+    // in order, since later files may depend on data from earlier ones.
+    thread_pool &pool = get_thread_pool();
+    const size_t max_files_ahead = 2 * ( pool.size() + 1 );
+    std::deque<std::future<std::unique_ptr<parsed_json_file>>> parsed;
+    size_t next_file = 0;
+    for( const std::string &file : files ) {
+        while( next_file < files.size() && parsed.size() < max_files_ahead ) {
+            const std::string &to_parse = files[next_file++];
+            parsed.push_back( pool.submit( [to_parse]() {
+                return parse_json_file( to_parse );
+            } ) );
+        }
+        std::unique_ptr<parsed_json_file> objects = parsed.front().get();
+        parsed.pop_front();
         try {
-            // parse it
-            JsonIn jsin( iss, file );
-            load_all_from_json( jsin, src, ui, path, file );
+            load_all_from_json( *objects, src, ui, path, file );
         } catch( const JsonError &err ) {
             throw std::runtime_error( err.what() );
         }
     }
 }
 
-void DynamicDataLoader::load_all_from_json( JsonIn &jsin, const std::string &src, loading_ui &,
-        const std::string &base_path, const std::string &full_path )
+/** The objects of a json file, indexed as JsonObjects. */
+struct DynamicDataLoader::parsed_json_file {
+    std::string data;
+    std::unique_ptr<JsonIn> jsin;
+    // Objects are never moved, a JsonObject seeks its JsonIn when destroyed.
+    std::deque<JsonObject> objects;
+    size_t loaded = 0;
+    // Error found after the last of @ref objects.
+    std::exception_ptr error;
+
+    ~parsed_json_file() {
+        // Objects not loaded because of an earlier error aren't reported.
+        for( size_t i = loaded; i < objects.size(); i++ ) {
+            objects[i].allow_omitted_members();
+        }
+    }
+};
+
+std::unique_ptr<DynamicDataLoader::parsed_json_file> DynamicDataLoader::parse_json_file(
+    const std::string &full_path )
+{
+    std::unique_ptr<parsed_json_file> file = std::make_unique<parsed_json_file>();
+    file->data = read_entire_file( full_path );
+    file->jsin = std::make_unique<JsonIn>( file->data, full_path );
+    JsonIn &jsin = *file->jsin;
+    try {
+        // TEMPORARY until 0.G: Remove single object support for consistency
+        if( jsin.test_object() ) {
+            file->objects.emplace_back( jsin );
+            // if there's anything else in the file, it's an error.
+            jsin.eat_whitespace();
+            if( jsin.good() ) {
+                jsin.error( string_format( "expected single-object file but found '%c'", jsin.peek() ) );
+            }
+        } else if( jsin.test_array() ) {
+            jsin.start_array();
+            // index each object until array close
+            while( !jsin.end_array() ) {
+                file->objects.emplace_back( jsin );
+            }
+        } else {
+            // not an object or an array?
+            jsin.error( "expected object or array" );
+        }
+    } catch( ... ) {
+        file->error = std::current_exception();
+    }
+    return file;
+}
+
+void DynamicDataLoader::load_all_from_json( parsed_json_file &file, const std::string &src,
+        loading_ui &, const std::string &base_path, const std::string &full_path )
 {
-    // TEMPORARY until 0.G: Remove single object support for consistency
-    if( jsin.test_object() ) {
-        // find type and dispatch single object
-        JsonObject jo = jsin.get_object();
+    // find type and dispatch each object
+    for( JsonObject &jo : file.objects ) {
+        file.loaded++;
         load_object( jo, src, base_path, full_path );
         jo.finish();
-        // if there's anything else in the file, it's an error.
-        jsin.eat_whitespace();
-        if( jsin.good() ) {
-            jsin.error( string_format( "expected single-object file but found '%c'", jsin.peek() ) );
-        }
-    } else if( jsin.test_array() ) {
-        jsin.start_array();
-        // find type and dispatch each object until array close
-        while( !jsin.end_array() ) {
-            JsonObject jo = jsin.get_object();
-            load_object( jo, src, base_path, full_path );
-            jo.finish();
-        }
-    } else {
-        // not an object or an array?
-        jsin.error( "expected object or array" );
+    }
+    if( file.error ) {
+        std::rethrow_exception( file.error );
     }
     inp_mngr.pump_events();
 }
@@ -669,9 +709,9 @@ void DynamicDataLoader::finalize_loaded_data( loading_ui &ui )
             { _( "Furniture" ), &finalize_furn },
             { _( "Overmap land use codes" ), &overmap_land_use_codes::finalize },
             { _( "Overmap terrain" ), &overmap_terrains::finalize },
-            { _( "Overmap connections" ), &overmap_connections::finalize },
             { _( "Overmap specials" ), &overmap_specials::finalize },
             { _( "Overmap locations" ), &overmap_locations::finalize },
+            { _( "Overmap connections" ), &overmap_connections::finalize },
             { _( "Start locations" ), &start_locations::finalize_all },
             { _( "Zone manager" ), &zone_manager::reset_manager },
             { _( "Vehicle prototypes" ), &vehicle_prototype::finalize },
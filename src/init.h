@@ -84,16 +84,22 @@ class DynamicDataLoader
         void add( const std::string &type,
                   std::function<void( const JsonObject &, const std::string &, const std::string &, const std::string & )>
                   f );
+        struct parsed_json_file;
+        /**
+         * Read a json file and index its objects, without loading them.
+         * Doesn't touch any game data, so it runs on worker threads.
+         */
+        static std::unique_ptr<parsed_json_file> parse_json_file( const std::string &full_path );
         /**
          * Load all the types from that json data.
-         * @param jsin Might contain single object,
-         * or an array of objects. Each object must have a
+         * @param file Objects of a file that might contain a single
+         * object, or an array of objects. Each object must have a
          * "type", that is part of the @ref type_function_map
          * @param src String identifier for mod this data comes from
          * @param ui Finalization status display.
          * @throws std::exception on all kind of errors.
          */
-        void load_all_from_json( JsonIn &jsin, const std::string &src, loading_ui &ui,
+        void load_all_from_json( parsed_json_file &file, const std::string &src, loading_ui &ui,
                                  const std::string &base_path, const std::string &full_path );
         /**
          * Load a single object from a json object.
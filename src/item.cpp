@@ -87,6 +87,7 @@
 #include "requirements.h"
 #include "ret_val.h"
 #include "rng.h"
+#include "rot.h"
 #include "skill.h"
 #include "stomach.h"
 #include "string_formatter.h"
@@ -5667,7 +5668,7 @@ time_duration item::calc_rot( time_point time, int temp ) const
     }
 
     time_duration time_delta = time - last_rot_check;
-    added_rot += factor * time_delta / 1_hours * get_hourly_rotpoints_at_temp( temp ) * 1_turns;
+    added_rot += rot::rot_over( time_delta, temp, factor );
     return added_rot;
 }
 
@@ -8940,29 +8941,29 @@ bool item::process_rot( const tripoint &pos )
     return process_rot( false, pos, nullptr, temperature_flag::TEMP_NORMAL, get_weather() );
 }
 
-static units::temperature clip_by_temperature_flag( units::temperature temperature,
-        temperature_flag flag )
-{
-    switch( flag ) {
-        case temperature_flag::TEMP_NORMAL:
-            // Just use the temperature normally
-            return temperature;
-        case temperature_flag::TEMP_FRIDGE:
-            return std::min( temperature, temperatures::fridge );
-        case temperature_flag::TEMP_FREEZER:
-            return std::min( temperature, temperatures::freezer );
-        case temperature_flag::TEMP_HEATER:
-            return std::max( temperature, temperatures::normal );
-        case temperature_flag::TEMP_ROOT_CELLAR:
-            return temperatures::root_cellar;
-        default:
-            debugmsg( "Temperature flag enum not valid: %d.  Using current temperature.",
-                      static_cast<int>( flag ) );
-            break;
+/**
+ * First value in [from, to] for which @p pred is true, or to + 1 if there is none.
+ * @p pred has to be false up to some value and true from there on.
+ */
+template<typename Predicate>
+static int first_hour_where( int from, int to, Predicate pred )
+{
+    int count = to - from + 1;
+    while( count > 0 ) {
+        const int step = count / 2;
+        if( pred( from + step ) ) {
+            count = step;
+        } else {
+            from += step + 1;
+            count -= step + 1;
+        }
     }
-    return temperature;
+    return from;
 }
 
+// Below this many hours, items outside the reality bubble are processed one hour at a time.
+static constexpr int min_hours_for_rot_timeline = 4;
+
 bool item::process_rot( const bool seals, const tripoint &pos,
                         player *carrier, const temperature_flag flag,
                         const weather_manager &weather )
@@ -8981,7 +8982,7 @@ bool item::process_rot( const bool seals, const tripoint &pos,
     time_duration smallest_interval = 10_minutes;
 
     units::temperature temp = units::from_fahrenheit( weather.get_temperature( pos ) );
-    temp = clip_by_temperature_flag( temp, flag );
+    temp = rot::clip_by_temperature_flag( temp, flag );
 
     time_point time = last_rot_check;
     item_internal::scoped_goes_bad_cache _cache( this );
@@ -8998,6 +8999,50 @@ bool item::process_rot( const bool seals, const tripoint &pos,
 
         // Process the past of this item since the last time it was processed
         while( now - time > 1_hours ) {
+            const int full_hours = to_turns<int>( now - 1_hours - time ) / to_turns<int>( 1_hours );
+            if( full_hours >= min_hours_for_rot_timeline &&
+                last_rot_check > calendar::start_of_cataclysm ) {
+                // Other items here share the hourly rot, so most of the hours are skipped at once.
+                rot::storage_conditions conditions;
+                conditions.location = tripoint_abs_ms( get_map().getabs( pos ) ).xy();
+                conditions.underground = pos.z < 0;
+                conditions.local_mod = local_mod;
+                conditions.flag = flag;
+                conditions.factor = is_corpse() && has_flag( flag_FIELD_DRESS ) ? 0.75f : 1.0f;
+                const rot::hourly_rot hourly = rot::rot_for_hours( conditions, time, full_hours, wgen,
+                                               seed );
+                const time_duration rot_before = rot;
+                // Rot doesn't decrease, so the hour at which calc_rot stops adding rot and the one
+                // the item rots away at are found by binary search.
+                int growing_hours = full_hours;
+                if( !is_corpse() ) {
+                    growing_hours = std::min( full_hours, first_hour_where( 0, full_hours, [&]( int h ) {
+                        rot = rot_before + hourly.first_hours( h );
+                        return get_relative_rot() > 2.0;
+                    } ) );
+                }
+                const auto rot_after = [&]( int h ) {
+                    return rot_before + hourly.first_hours( std::min( h, growing_hours ) );
+                };
+                int hours = full_hours;
+                if( carrier == nullptr && !seals ) {
+                    hours = first_hour_where( 1, full_hours, [&]( int h ) {
+                        rot = rot_after( h );
+                        return has_rotten_away();
+                    } );
+                }
+                const bool rotten_away = hours <= full_hours;
+                hours = std::min( hours, full_hours );
+                rot = rot_after( hours );
+                time += hours * 1_hours;
+                last_rot_check = time;
+                if( rotten_away ) {
+                    // No need to track item that will be gone
+                    return true;
+                }
+                continue;
+            }
+
             // Get the environment temperature
             time_duration time_delta = std::min( 1_hours, now - 1_hours - time );
             time += time_delta;
@@ -9013,7 +9058,8 @@ bool item::process_rot( const bool seals, const tripoint &pos,
                 env_temperature_raw = units::from_fahrenheit( AVERAGE_ANNUAL_TEMPERATURE ) + local_mod;
             }
 
-            units::temperature env_temperature_clipped = clip_by_temperature_flag( env_temperature_raw, flag );
+            units::temperature env_temperature_clipped = rot::clip_by_temperature_flag( env_temperature_raw,
+                    flag );
 
             // Lookup table is in F
             int final_temperature_in_fahrenheit = static_cast<int>( std::round( units::to_fahrenheit<float>
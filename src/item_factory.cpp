@@ -834,6 +834,7 @@ void Item_factory::add_actor( std::unique_ptr<iuse_actor> ptr )
 
 void Item_factory::add_item_type( const itype &def )
 {
+    std::lock_guard<std::recursive_mutex> lock( m_runtimes_mutex );
     if( m_runtimes.count( def.id ) > 0 ) {
         // Do NOT allow overwriting it, it's undefined behavior
         debugmsg( "Tried to add runtime type %s, but it exists already", def.id.c_str() );
@@ -1532,6 +1533,7 @@ const itype *Item_factory::find_template( const itype_id &id ) const
         return &found->second;
     }
 
+    std::lock_guard<std::recursive_mutex> lock( m_runtimes_mutex );
     auto rt = m_runtimes.find( id );
     if( rt != m_runtimes.end() ) {
         return rt->second.get();
@@ -3253,6 +3255,7 @@ void item_group::debug_spawn()
 
 bool Item_factory::has_template( const itype_id &id ) const
 {
+    std::lock_guard<std::recursive_mutex> lock( m_runtimes_mutex );
     return m_templates.count( id ) || m_runtimes.count( id );
 }
 
@@ -3260,6 +3263,7 @@ std::vector<const itype *> Item_factory::all() const
 {
     assert( frozen );
 
+    std::lock_guard<std::recursive_mutex> lock( m_runtimes_mutex );
     std::vector<const itype *> res;
     res.reserve( m_templates.size() + m_runtimes.size() );
 
@@ -3275,6 +3279,7 @@ std::vector<const itype *> Item_factory::all() const
 
 std::vector<const itype *> Item_factory::get_runtime_types() const
 {
+    std::lock_guard<std::recursive_mutex> lock( m_runtimes_mutex );
     std::vector<const itype *> res;
     res.reserve( m_runtimes.size() );
     for( const auto &e : m_runtimes ) {
@@ -3289,6 +3294,7 @@ std::vector<const itype *> Item_factory::find( const std::function<bool( const i
 {
     assert( frozen );
 
+    std::lock_guard<std::recursive_mutex> lock( m_runtimes_mutex );
     std::vector<const itype *> res;
 
     for( const auto &e : m_templates ) {
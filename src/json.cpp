@@ -31,6 +31,63 @@ static bool is_whitespace( char ch )
     return ( ch == ' ' || ch == '\n' || ch == '\t' || ch == '\r' );
 }
 
+// Characters that are copied from a string as they are, without any checks.
+static bool is_plain_string_char( char ch )
+{
+    const unsigned char uc = static_cast<unsigned char>( ch );
+    return uc >= 0x20 && uc < 0x80 && ch != '"' && ch != '\\';
+}
+
+/**
+ * Stream buffer over memory that JsonIn does not own.  JsonIn moves through
+ * it directly for the common cases, the stream reading from it handles the
+ * rest (mostly end of file and error reporting) the same as any other stream.
+ */
+class json_memory_buffer : public std::streambuf
+{
+    public:
+        explicit json_memory_buffer( std::string_view data ) {
+            // Never written to, putting back a different character fails.
+            char *first = const_cast<char *>( data.data() );
+            setg( first, first, first + data.size() );
+        }
+
+        const char *begin() const {
+            return eback();
+        }
+        const char *cur() const {
+            return gptr();
+        }
+        const char *end() const {
+            return egptr();
+        }
+        void set_cur( const char *p ) {
+            setg( eback(), const_cast<char *>( p ), egptr() );
+        }
+
+    protected:
+        pos_type seekoff( off_type off, std::ios_base::seekdir dir,
+                          std::ios_base::openmode which ) override {
+            if( !( which & std::ios_base::in ) ) {
+                return pos_type( off_type( -1 ) );
+            }
+            off_type pos = off;
+            if( dir == std::ios_base::cur ) {
+                pos += gptr() - eback();
+            } else if( dir == std::ios_base::end ) {
+                pos += egptr() - eback();
+            }
+            if( pos < 0 || pos > egptr() - eback() ) {
+                return pos_type( off_type( -1 ) );
+            }
+            set_cur( eback() + pos );
+            return pos_type( pos );
+        }
+        pos_type seekpos( pos_type pos, std::ios_base::openmode which ) override {
+            return seekoff( off_type( pos ), std::ios_base::beg, which );
+        }
+};
+
 // for parsing \uxxxx escapes
 static std::string utf16_to_utf8( uint32_t ch )
 {
@@ -792,12 +849,83 @@ void add_array_to_set( std::set<std::string> &s, const JsonObject &json, const s
     }
 }
 
+JsonIn::JsonIn( std::istream &s ) : stream( &s ) {}
+
+JsonIn::JsonIn( std::istream &s, const std::string &path )
+    : stream( &s ), path( make_shared_fast<std::string>( path ) ) {}
+
+JsonIn::JsonIn( std::istream &s, const json_source_location &loc )
+    : stream( &s ), path( loc.path )
+{
+    seek( loc.offset );
+}
+
+JsonIn::JsonIn( std::string_view data )
+    : buffer( std::make_unique<json_memory_buffer>( data ) )
+    , buffer_stream( std::make_unique<std::istream>( buffer.get() ) )
+{
+    stream = buffer_stream.get();
+}
+
+JsonIn::JsonIn( std::string_view data, const std::string &path ) : JsonIn( data )
+{
+    this->path = make_shared_fast<std::string>( path );
+}
+
+JsonIn::~JsonIn() = default;
+
+json_memory_buffer *JsonIn::fast_buffer()
+{
+    if( buffer && stream->rdstate() == std::ios_base::goodbit ) {
+        return buffer.get();
+    }
+    return nullptr;
+}
+
+void JsonIn::get_char( char &ch )
+{
+    json_memory_buffer *buf = fast_buffer();
+    if( buf && buf->cur() != buf->end() ) {
+        ch = *buf->cur();
+        buf->set_cur( buf->cur() + 1 );
+    } else {
+        stream->get( ch );
+    }
+}
+
+void JsonIn::skip_char()
+{
+    json_memory_buffer *buf = fast_buffer();
+    if( buf && buf->cur() != buf->end() ) {
+        buf->set_cur( buf->cur() + 1 );
+    } else {
+        stream->get();
+    }
+}
+
+void JsonIn::unget_char()
+{
+    json_memory_buffer *buf = fast_buffer();
+    if( buf && buf->cur() != buf->begin() ) {
+        buf->set_cur( buf->cur() - 1 );
+    } else {
+        stream->unget();
+    }
+}
+
 int JsonIn::tell()
 {
+    if( json_memory_buffer *buf = fast_buffer() ) {
+        return buf->cur() - buf->begin();
+    }
     return stream->tellg();
 }
 char JsonIn::peek()
 {
+    json_memory_buffer *buf = fast_buffer();
+    if( buf && buf->cur() != buf->end() ) {
+        return *buf->cur();
+    }
     return static_cast<char>( stream->peek() );
 }
 bool JsonIn::good()
@@ -808,14 +936,26 @@ bool JsonIn::good()
 void JsonIn::seek( int pos )
 {
     stream->clear();
-    stream->seekg( pos );
+    if( buffer && pos >= 0 && pos <= buffer->end() - buffer->begin() ) {
+        buffer->set_cur( buffer->begin() + pos );
+    } else {
+        stream->seekg( pos );
+    }
     ate_separator = false;
 }
 
 void JsonIn::eat_whitespace()
 {
+    if( json_memory_buffer *buf = fast_buffer() ) {
+        const char *p = buf->cur();
+        while( p != buf->end() && is_whitespace( *p ) ) {
+            ++p;
+        }
+        buf->set_cur( p );
+    }
+    // At the end of the buffer this lets the stream reach EOF.
     while( is_whitespace( peek() ) ) {
-        stream->get();
+        skip_char();
     }
 }
 
@@ -850,7 +990,7 @@ void JsonIn::skip_separator()
         if( ate_separator ) {
             error( "duplicate comma" );
         }
-        stream->get();
+        skip_char();
         ate_separator = true;
     } else if( ch == ']' || ch == '}' || ch == ':' ) {
         // okay
@@ -879,7 +1019,7 @@ void JsonIn::skip_pair_separator()
 {
     char ch;
     eat_whitespace();
-    stream->get( ch );
+    get_char( ch );
     if( ch != ':' ) {
         std::stringstream err;
         err << "expected pair separator ':', not '" << ch << "'";
@@ -894,16 +1034,23 @@ void JsonIn::skip_string()
 {
     char ch;
     eat_whitespace();
-    stream->get( ch );
+    get_char( ch );
     if( ch != '"' ) {
         std::stringstream err;
         err << "expecting string but found '" << ch << "'";
         error( err.str(), -1 );
     }
     while( stream->good() ) {
-        stream->get( ch );
+        if( json_memory_buffer *buf = fast_buffer() ) {
+            const char *p = buf->cur();
+            while( p != buf->end() && *p != '"' && *p != '\\' && *p != '\r' && *p != '\n' ) {
+                ++p;
+            }
+            buf->set_cur( p );
+        }
+        get_char( ch );
         if( ch == '\\' ) {
-            stream->get( ch );
+            get_char( ch );
             continue;
         } else if( ch == '"' ) {
             break;
@@ -964,10 +1111,25 @@ void JsonIn::skip_array()
     // end_value called by end_array
 }
 
+// Moves past @p literal if the buffer continues with it.
+static bool skip_literal( json_memory_buffer *buf, std::string_view literal )
+{
+    if( !buf || static_cast<size_t>( buf->end() - buf->cur() ) < literal.size() ||
+        std::string_view( buf->cur(), literal.size() ) != literal ) {
+        return false;
+    }
+    buf->set_cur( buf->cur() + literal.size() );
+    return true;
+}
+
 void JsonIn::skip_true()
 {
     char text[5];
     eat_whitespace();
+    if( skip_literal( fast_buffer(), "true" ) ) {
+        end_value();
+        return;
+    }
     stream->get( text, 5 );
     if( strcmp( text, "true" ) != 0 ) {
         std::stringstream err;
@@ -981,6 +1143,10 @@ void JsonIn::skip_false()
 {
     char text[6];
     eat_whitespace();
+    if( skip_literal( fast_buffer(), "false" ) ) {
+        end_value();
+        return;
+    }
     stream->get( text, 6 );
     if( strcmp( text, "false" ) != 0 ) {
         std::stringstream err;
@@ -994,6 +1160,10 @@ void JsonIn::skip_null()
 {
     char text[5];
     eat_whitespace();
+    if( skip_literal( fast_buffer(), "null" ) ) {
+        end_value();
+        return;
+    }
     stream->get( text, 5 );
     if( strcmp( text, "null" ) != 0 ) {
         std::stringstream err;
@@ -1009,10 +1179,10 @@ void JsonIn::skip_number()
     eat_whitespace();
     // skip all of (+-0123456789.eE)
     while( stream->good() ) {
-        stream->get( ch );
+        get_char( ch );
         if( ch != '+' && ch != '-' && ( ch < '0' || ch > '9' ) &&
             ch != 'e' && ch != 'E' && ch != '.' ) {
-            stream->unget();
+            unget_char();
             break;
         }
     }
@@ -1169,7 +1339,7 @@ std::string JsonIn::get_string()
     bool success = false;
     do {
         // the first character had better be a '"'
-        stream->get( ch );
+        get_char( ch );
         if( !stream->good() ) {
             err = "read operation failed";
             break;
@@ -1180,13 +1350,23 @@ std::string JsonIn::get_string()
         }
         // add chars to the string, one at a time
         do {
-            ch = stream->peek();
+            if( json_memory_buffer *buf = fast_buffer() ) {
+                // or a whole run of them at once when reading from memory
+                const char *first = buf->cur();
+                const char *p = first;
+                while( p != buf->end() && is_plain_string_char( *p ) ) {
+                    ++p;
+                }
+                s.append( first, p );
+                buf->set_cur( p );
+            }
+            ch = peek();
             if( !stream->good() ) {
                 err = "read operation failed";
                 break;
             }
             if( ch == '"' ) {
-                stream->ignore();
+                skip_char();
                 success = true;
                 break;
             }
@@ -1341,9 +1521,9 @@ number_sci_notation JsonIn::get_any_number()
     number_sci_notation ret;
     int mod_e = 0;
     eat_whitespace();
-    stream->get( ch );
+    get_char( ch );
     if( ( ret.negative = ch == '-' ) ) {
-        stream->get( ch );
+        get_char( ch );
     } else if( ch != '.' && ( ch < '0' || ch > '9' ) ) {
         // not a valid float
         std::stringstream err;
@@ -1352,7 +1532,7 @@ number_sci_notation JsonIn::get_any_number()
     }
     if( ch == '0' ) {
         // allow a single leading zero in front of a '.' or 'e'/'E'
-        stream->get( ch );
+        get_char( ch );
         if( ch >= '0' && ch <= '9' ) {
             error( "leading zeros not allowed", -1 );
         }
@@ -1360,36 +1540,36 @@ number_sci_notation JsonIn::get_any_number()
     while( ch >= '0' && ch <= '9' ) {
         ret.number *= 10;
         ret.number += ( ch - '0' );
-        stream->get( ch );
+        get_char( ch );
     }
     if( ch == '.' ) {
-        stream->get( ch );
+        get_char( ch );
         while( ch >= '0' && ch <= '9' ) {
             ret.number *= 10;
             ret.number += ( ch - '0' );
             mod_e -= 1;
-            stream->get( ch );
+            get_char( ch );
         }
     }
     if( ch == 'e' || ch == 'E' ) {
-        stream->get( ch );
+        get_char( ch );
         bool neg;
         if( ( neg = ch == '-' ) ) {
-            stream->get( ch );
+            get_char( ch );
         } else if( ch == '+' ) {
-            stream->get( ch );
+            get_char( ch );
         }
         while( ch >= '0' && ch <= '9' ) {
             ret.exp *= 10;
             ret.exp += ( ch - '0' );
-            stream->get( ch );
+            get_char( ch );
         }
         if( neg ) {
             ret.exp *= -1;
         }
     }
     // unget the final non-number character (probably a separator)
-    stream->unget();
+    unget_char();
     end_value();
     ret.exp += mod_e;
     return ret;
@@ -1401,6 +1581,14 @@ bool JsonIn::get_bool()
     char text[5];
     std::stringstream err;
     eat_whitespace();
+    json_memory_buffer *buf = fast_buffer();
+    if( skip_literal( buf, "true" ) ) {
+        end_value();
+        return true;
+    } else if( skip_literal( buf, "false" ) ) {
+        end_value();
+        return false;
+    }
     stream->get( ch );
     if( ch == 't' ) {
         stream->get( text, 4 );
@@ -1441,7 +1629,7 @@ void JsonIn::start_array()
 {
     eat_whitespace();
     if( peek() == '[' ) {
-        stream->get();
+        skip_char();
         ate_separator = false;
         return;
     } else {
@@ -1461,7 +1649,7 @@ bool JsonIn::end_array()
             uneat_whitespace();
             error( "comma not allowed at end of array" );
         }
-        stream->get();
+        skip_char();
         end_value();
         return true;
     } else {
@@ -1474,7 +1662,7 @@ void JsonIn::start_object()
 {
     eat_whitespace();
     if( peek() == '{' ) {
-        stream->get();
+        skip_char();
         ate_separator = false; // not that we want to
         return;
     } else {
@@ -1494,7 +1682,7 @@ bool JsonIn::end_object()
             uneat_whitespace();
             error( "comma not allowed at end of object" );
         }
-        stream->get();
+        skip_char();
         end_value();
         return true;
     } else {
@@ -8,9 +8,11 @@
 #include <cstdint>
 #include <iostream>
 #include <map>
+#include <memory>
 #include <set>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <type_traits>
 #include <utility>
 #include <vector>
@@ -117,6 +119,13 @@ struct number_sci_notation {
  * verbose error messages are provided, indicating the problem,
  * and the exact line number and byte offset within the istream.
  *
+ * A JsonIn can also read from a buffer in memory, such as the contents of a
+ * whole file.  It then scans whitespace, strings and numbers directly in the
+ * buffer instead of going through the stream one character at a time:
+ *
+ *     std::string data = read_entire_file( path );
+ *     JsonIn jsin( data, path );
+ *
  *
  * Single-Pass Loading
  * -------------------
@@ -169,10 +178,15 @@ struct number_sci_notation {
  * If an if;else if;... is missing the "else", it /will/ cause bugs,
  * so preindexing as a JsonObject is safer, as well as tidier.
  */
+class json_memory_buffer;
+
 class JsonIn
 {
     private:
         std::istream *stream;
+        // Set when reading from memory, @ref stream then reads from the same buffer.
+        std::unique_ptr<json_memory_buffer> buffer;
+        std::unique_ptr<std::istream> buffer_stream;
         shared_ptr_fast<std::string> path;
         bool ate_separator = false;
 
@@ -180,14 +194,21 @@ class JsonIn
         void skip_pair_separator();
         void end_value();
 
+        // The buffer, if reading from memory and the stream is fine.
+        json_memory_buffer *fast_buffer();
+        // Same as the stream functions, but without the stream when reading from memory.
+        void get_char( char &ch );
+        void skip_char();
+        void unget_char();
+
     public:
-        JsonIn( std::istream &s ) : stream( &s ) {}
-        JsonIn( std::istream &s, const std::string &path )
-            : stream( &s ), path( make_shared_fast<std::string>( path ) ) {}
-        JsonIn( std::istream &s, const json_source_location &loc )
-            : stream( &s ), path( loc.path ) {
-            seek( loc.offset );
-        }
+        JsonIn( std::istream &s );
+        JsonIn( std::istream &s, const std::string &path );
+        JsonIn( std::istream &s, const json_source_location &loc );
+        /** Reads from @p data, which has to outlive this JsonIn. */
+        explicit JsonIn( std::string_view data );
+        JsonIn( std::string_view data, const std::string &path );
+        ~JsonIn();
         JsonIn( const JsonIn & ) = delete;
         JsonIn &operator=( const JsonIn & ) = delete;
 
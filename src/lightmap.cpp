@@ -1,6 +1,9 @@
 #include "lightmap.h" // IWYU pragma: associated
 #include "shadowcasting.h" // IWYU pragma: associated
 
+#include <algorithm>
+#include <array>
+#include <bitset>
 #include <cmath>
 #include <cstdlib>
 #include <cstring>
@@ -34,6 +37,7 @@
 #include "point.h"
 #include "string_formatter.h"
 #include "submap.h"
+#include "thread_pool.h"
 #include "tileray.h"
 #include "type_id.h"
 #include "veh_type.h"
@@ -397,6 +401,9 @@ void map::build_sunlight_cache( int pzlev )
     }
 }
 
+static void apply_buffered_light_sources( level_cache &cache,
+        const std::vector<std::pair<point, float>> &sources );
+
 void map::generate_lightmap( const int zlev )
 {
     auto &map_cache = get_cache( zlev );
@@ -598,13 +605,15 @@ void map::generate_lightmap( const int zlev )
         unbuffered: (12^2)*(160*4) = apply_light_ray x 92160
         buffered:   (12*4)*(160)   = apply_light_ray x 7680
     */
-    const tripoint cache_start( 0, 0, zlev );
-    const tripoint cache_end( LIGHTMAP_CACHE_X, LIGHTMAP_CACHE_Y, zlev );
-    for( const tripoint &p : points_in_rectangle( cache_start, cache_end ) ) {
-        if( light_source_buffer[p.x][p.y] > 0.0 ) {
-            apply_light_source( p, light_source_buffer[p.x][p.y] );
+    std::vector<std::pair<point, float>> buffered_sources;
+    for( int x = 0; x < LIGHTMAP_CACHE_X; x++ ) {
+        for( int y = 0; y < LIGHTMAP_CACHE_Y; y++ ) {
+            if( light_source_buffer[x][y] > 0.0 ) {
+                buffered_sources.emplace_back( point( x, y ), light_source_buffer[x][y] );
+            }
         }
     }
+    apply_buffered_light_sources( map_cache, buffered_sources );
     for( const std::pair<tripoint, float> &elem : lm_override ) {
         lm[elem.first.x][elem.first.y].fill( elem.second );
     }
@@ -1189,6 +1198,11 @@ void castLight( Out( &output_cache )[MAPSIZE_X][MAPSIZE_Y],
         delta.y = -distance;
         bool started_row = false;
         T current_transparency = 0.0;
+        // The cumulative transparency only changes between rows, so the intensity only has
+        // to be calculated again when the distance changes, which it never does within a row
+        // unless trigdist is on.
+        int row_dist = -1;
+        T row_intensity = 0.0;
         float away = start - ( -distance + 0.5f ) / ( -distance -
                      0.5f ); //The distance between our first leadingEdge and start
 
@@ -1216,7 +1230,11 @@ void castLight( Out( &output_cache )[MAPSIZE_X][MAPSIZE_Y],
             }
 
             const int dist = rl_dist( tripoint_zero, delta ) + offsetDistance;
-            last_intensity = calc( numerator, cumulative_transparency, dist );
+            if( dist != row_dist ) {
+                row_dist = dist;
+                row_intensity = calc( numerator, cumulative_transparency, dist );
+            }
+            last_intensity = row_intensity;
 
             T new_transparency = input_array[ current.x ][ current.y ];
 
@@ -1309,6 +1327,118 @@ castLightAll<float, float, shrapnel_calc, shrapnel_check,
     point offset, int offsetDistance, float numerator );
 
 
+// The {xx, xy, yx, yy} transforms of the octants cast by castLightAll, in the same order.
+static constexpr std::array<std::array<int, 4>, 8> sight_octants = {{
+        {{ 0, 1, 1, 0 }}, {{ 1, 0, 0, 1 }}, {{ 0, -1, 1, 0 }}, {{ -1, 0, 0, 1 }},
+        {{ 0, 1, -1, 0 }}, {{ 1, 0, 0, -1 }}, {{ 0, -1, -1, 0 }}, {{ -1, 0, 0, -1 }}
+    }
+};
+
+// Whether castLight can reach the tile at delta from its origin in the given octant.
+static bool in_sight_octant( const std::array<int, 4> &octant, point delta )
+{
+    const int across = octant[0] * delta.x + octant[2] * delta.y;
+    const int row = octant[1] * delta.x + octant[3] * delta.y;
+    return row < 0 && row >= -60 && across <= 0 && across >= row;
+}
+
+static void cast_sight_octant( size_t octant, level_cache &cache, point origin )
+{
+    auto &seen = cache.seen_cache;
+    const auto &transparency = cache.transparency_cache;
+    const auto &blocked = cache.vehicle_obscured_cache;
+    switch( octant ) {
+        case 0:
+            castLight<0, 1, 1, 0, float, float, sight_calc, sight_check, update_light,
+                      accumulate_transparency>( seen, transparency, blocked, origin, 0, 1.0f );
+            break;
+        case 1:
+            castLight<1, 0, 0, 1, float, float, sight_calc, sight_check, update_light,
+                      accumulate_transparency>( seen, transparency, blocked, origin, 0, 1.0f );
+            break;
+        case 2:
+            castLight < 0, -1, 1, 0, float, float, sight_calc, sight_check, update_light,
+                      accumulate_transparency > ( seen, transparency, blocked, origin, 0, 1.0f );
+            break;
+        case 3:
+            castLight < -1, 0, 0, 1, float, float, sight_calc, sight_check, update_light,
+                      accumulate_transparency > ( seen, transparency, blocked, origin, 0, 1.0f );
+            break;
+        case 4:
+            castLight < 0, 1, -1, 0, float, float, sight_calc, sight_check, update_light,
+                      accumulate_transparency > ( seen, transparency, blocked, origin, 0, 1.0f );
+            break;
+        case 5:
+            castLight < 1, 0, 0, -1, float, float, sight_calc, sight_check, update_light,
+                      accumulate_transparency > ( seen, transparency, blocked, origin, 0, 1.0f );
+            break;
+        case 6:
+            castLight < 0, -1, -1, 0, float, float, sight_calc, sight_check, update_light,
+                      accumulate_transparency > ( seen, transparency, blocked, origin, 0, 1.0f );
+            break;
+        case 7:
+            castLight < -1, 0, 0, -1, float, float, sight_calc, sight_check, update_light,
+                      accumulate_transparency > ( seen, transparency, blocked, origin, 0, 1.0f );
+            break;
+    }
+}
+
+/**
+ * Updates the seen cache cast from @p origin for the changes on the dirty submaps.
+ * Each octant only reads tiles inside of it, so only the octants that contain changed
+ * tiles (or their neighbors, for the blocked corners) are cleared and cast again. Tiles
+ * on the edge of an octant are shared with its neighbor, which is cast again too, without
+ * clearing it first, to restore its part of those tiles.
+ */
+static void recast_seen_octants( level_cache &cache, point origin )
+{
+    std::bitset<sight_octants.size()> dirty;
+    for( int smx = 0; smx < MAPSIZE; smx++ ) {
+        for( int smy = 0; smy < MAPSIZE; smy++ ) {
+            if( !cache.seen_cache_dirty_submaps[smx * MAPSIZE + smy] ) {
+                continue;
+            }
+            for( int x = smx * SEEX - 1; x <= ( smx + 1 ) * SEEX; x++ ) {
+                for( int y = smy * SEEY - 1; y <= ( smy + 1 ) * SEEY; y++ ) {
+                    for( size_t i = 0; i < sight_octants.size(); i++ ) {
+                        if( in_sight_octant( sight_octants[i], point( x, y ) - origin ) ) {
+                            dirty.set( i );
+                        }
+                    }
+                }
+            }
+        }
+    }
+    if( dirty.none() ) {
+        return;
+    }
+
+    std::bitset<sight_octants.size()> recast = dirty;
+    for( int x = 0; x < MAPSIZE_X; x++ ) {
+        for( int y = 0; y < MAPSIZE_Y; y++ ) {
+            const point delta = point( x, y ) - origin;
+            bool cleared = false;
+            for( size_t i = 0; i < sight_octants.size(); i++ ) {
+                cleared |= dirty[i] && in_sight_octant( sight_octants[i], delta );
+            }
+            if( !cleared ) {
+                continue;
+            }
+            cache.seen_cache[x][y] = LIGHT_TRANSPARENCY_SOLID;
+            for( size_t i = 0; i < sight_octants.size(); i++ ) {
+                if( in_sight_octant( sight_octants[i], delta ) ) {
+                    recast.set( i );
+                }
+            }
+        }
+    }
+    for( size_t i = 0; i < sight_octants.size(); i++ ) {
+        if( recast[i] ) {
+            cast_sight_octant( i, cache, origin );
+        }
+    }
+}
+
 //Alters the vision caches to the player specific version, the restore caches will be filled so it can be undone with restore_vision_transparency_cache
 void map::apply_vision_transparency_cache( const tripoint &center, int target_z,
         float ( &vision_restore_cache )[9], bool ( &blocked_restore_cache )[8] )
@@ -1411,18 +1541,27 @@ void map::build_seen_cache( const tripoint &origin, const int target_z )
     }
 
     if( !fov_3d ) {
+        // Mirrors and cameras are cast from the vehicle every time, so they aren't worth it.
+        const bool incremental = !map_cache.seen_cache_dirty &&
+                                 map_cache.seen_cache_origin == origin && !veh_at( origin );
         for( int z = -OVERMAP_DEPTH; z <= OVERMAP_HEIGHT; z++ ) {
             auto &cur_cache = get_cache( z );
-            if( z == target_z || cur_cache.seen_cache_dirty ) {
+            if( z == target_z && incremental ) {
+                recast_seen_octants( map_cache, origin.xy() );
+            } else if( z == target_z || cur_cache.seen_cache_dirty ||
+                       cur_cache.seen_cache_dirty_submaps.any() ) {
                 std::uninitialized_fill_n(
                     &cur_cache.seen_cache[0][0], map_dimensions, light_transparency_solid );
                 cur_cache.seen_cache_dirty = false;
+                cur_cache.seen_cache_origin = tripoint_min;
             }
+            cur_cache.seen_cache_dirty_submaps.reset();
 
-            if( z == target_z ) {
+            if( z == target_z && !incremental ) {
                 seen_cache[origin.x][origin.y] = VISIBILITY_FULL;
                 castLightAll<float, float, sight_calc, sight_check, update_light, accumulate_transparency>(
                     seen_cache, transparency_cache, blocked_cache, origin.xy(), 0 );
+                map_cache.seen_cache_origin = origin;
             }
         }
     } else {
@@ -1440,6 +1579,8 @@ void map::build_seen_cache( const tripoint &origin, const int target_z )
             std::uninitialized_fill_n(
                 &cur_cache.seen_cache[0][0], map_dimensions, light_transparency_solid );
             cur_cache.seen_cache_dirty = false;
+            cur_cache.seen_cache_dirty_submaps.reset();
+            cur_cache.seen_cache_origin = tripoint_min;
         }
         if( origin.z == target_z ) {
             get_cache( origin.z ).seen_cache[origin.x][origin.y] = VISIBILITY_FULL;
@@ -1540,22 +1681,21 @@ static bool light_check( const float &transparency, const float &intensity )
     return transparency > LIGHT_TRANSPARENCY_SOLID && intensity > LIGHT_AMBIENT_LOW;
 }
 
-void map::apply_light_source( const tripoint &p, float luminance )
+static void light_source_tile( level_cache &cache, point p, float luminance )
 {
-    auto &cache = get_cache( p.z );
-    four_quadrants( &lm )[MAPSIZE_X][MAPSIZE_Y] = cache.lm;
-    float ( &sm )[MAPSIZE_X][MAPSIZE_Y] = cache.sm;
-    float ( &transparency_cache )[MAPSIZE_X][MAPSIZE_Y] = cache.transparency_cache;
-    float ( &light_source_buffer )[MAPSIZE_X][MAPSIZE_Y] = cache.light_source_buffer;
-    diagonal_blocks( &blocked_cache )[MAPSIZE_X][MAPSIZE_Y] = cache.vehicle_obscured_cache;
+    const float min_light = std::max( static_cast<float>( lit_level::LOW ), luminance );
+    cache.lm[p.x][p.y] = elementwise_max( cache.lm[p.x][p.y], min_light );
+    cache.sm[p.x][p.y] = std::max( cache.sm[p.x][p.y], luminance );
+}
 
-    const point p2( p.xy() );
+// Casts the light of a source at p into lm, only reads the other caches.
+static void cast_light_source( four_quadrants( &lm )[MAPSIZE_X][MAPSIZE_Y],
+                               const level_cache &cache, point p2, float luminance )
+{
+    const float ( &transparency_cache )[MAPSIZE_X][MAPSIZE_Y] = cache.transparency_cache;
+    const float ( &light_source_buffer )[MAPSIZE_X][MAPSIZE_Y] = cache.light_source_buffer;
+    const diagonal_blocks( &blocked_cache )[MAPSIZE_X][MAPSIZE_Y] = cache.vehicle_obscured_cache;
 
-    if( inbounds( p ) ) {
-        const float min_light = std::max( static_cast<float>( lit_level::LOW ), luminance );
-        lm[p2.x][p2.y] = elementwise_max( lm[p2.x][p2.y], min_light );
-        sm[p2.x][p2.y] = std::max( sm[p2.x][p2.y], luminance );
-    }
     if( luminance <= lit_level::LOW ) {
         return;
     } else if( luminance <= lit_level::BRIGHT_ONLY ) {
@@ -1621,6 +1761,75 @@ void map::apply_light_source( const tripoint &p, float luminance )
     }
 }
 
+void map::apply_light_source( const tripoint &p, float luminance )
+{
+    auto &cache = get_cache( p.z );
+    if( inbounds( p ) ) {
+        light_source_tile( cache, p.xy(), luminance );
+    }
+    cast_light_source( cache.lm, cache, p.xy(), luminance );
+}
+
+using lightmap_grid = four_quadrants[MAPSIZE_X][MAPSIZE_Y];
+
+namespace
+{
+struct lightmap_batch {
+    lightmap_grid lm;
+};
+} // namespace
+
+// A batch of sources has to be at least this big to be worth a worker thread.
+static constexpr size_t min_light_sources_per_batch = 8;
+
+bool parallel_light_sources = true;
+
+static void apply_buffered_light_sources( level_cache &cache,
+        const std::vector<std::pair<point, float>> &sources )
+{
+    for( const std::pair<point, float> &source : sources ) {
+        light_source_tile( cache, source.first, source.second );
+    }
+
+    // Casting only ever raises the light level of a tile, so batches of sources can be cast
+    // into separate buffers and merged by max in any order, the result is the same as
+    // casting all of them one after another. The game thread casts the first batch
+    // directly into the lightmap.
+    thread_pool &pool = get_thread_pool();
+    const size_t num_batches = !parallel_light_sources ? 1 :
+                               std::max<size_t>( 1, std::min( pool.size() + 1,
+                                       sources.size() / min_light_sources_per_batch ) );
+    static std::vector<std::unique_ptr<lightmap_batch>> buffers;
+    while( buffers.size() + 1 < num_batches ) {
+        buffers.push_back( std::make_unique<lightmap_batch>() );
+    }
+    // Sources next to each other are spread over the batches, so big fires don't end up
+    // in a single one.
+    const auto cast_batch = [&cache, &sources, num_batches]( lightmap_grid & lm, size_t batch ) {
+        for( size_t i = batch; i < sources.size(); i += num_batches ) {
+            cast_light_source( lm, cache, sources[i].first, sources[i].second );
+        }
+    };
+    std::vector<std::future<void>> results;
+    for( size_t batch = 1; batch < num_batches; batch++ ) {
+        lightmap_batch &buffer = *buffers[batch - 1];
+        results.push_back( pool.submit( [&buffer, &cast_batch, batch]() {
+            std::fill_n( &buffer.lm[0][0], MAPSIZE_X * MAPSIZE_Y, four_quadrants( 0.0f ) );
+            cast_batch( buffer.lm, batch );
+        } ) );
+    }
+    cast_batch( cache.lm, 0 );
+    for( size_t batch = 1; batch < num_batches; batch++ ) {
+        results[batch - 1].get();
+        const lightmap_batch &buffer = *buffers[batch - 1];
+        for( int x = 0; x < MAPSIZE_X; x++ ) {
+            for( int y = 0; y < MAPSIZE_Y; y++ ) {
+                cache.lm[x][y] = elementwise_max( cache.lm[x][y], buffer.lm[x][y] );
+            }
+        }
+    }
+}
+
 void map::apply_directional_light( const tripoint &p, int direction, float luminance )
 {
     const point p2( p.xy() );
@@ -41,6 +41,7 @@
 #include "field.h"
 #include "field_type.h"
 #include "flat_set.h"
+#include "flow_field.h"
 #include "fragment_cloud.h"
 #include "fungal_effects.h"
 #include "game.h"
@@ -77,6 +78,7 @@
 #include "pathfinding.h"
 #include "player.h"
 #include "point_float.h"
+#include "portal_graph.h"
 #include "projectile.h"
 #include "rng.h"
 #include "safe_reference.h"
@@ -188,6 +190,8 @@ map::map( int mapsize, bool zlev )
     for( auto &ptr : pathfinding_caches ) {
         ptr = std::make_unique<pathfinding_cache>();
     }
+    flow_fields = std::make_unique<flow_field_cache>();
+    portal_graphs = std::make_unique<portal_graph_cache>();
 
     dbg( DL::Info ) << "map::map(): my_MAPSIZE: " << my_MAPSIZE << " z-levels enabled:" << zlevels;
     traplocs.resize( trap::count() );
@@ -212,7 +216,8 @@ void map::set_seen_cache_dirty( const tripoint change_location )
         }
         if( cache.seen_cache[change_location.x][change_location.y] != 0.0 ||
             cache.camera_cache[change_location.x][change_location.y] != 0.0 ) {
-            cache.seen_cache_dirty = true;
+            const point smp = ms_to_sm_copy( change_location.xy() );
+            cache.seen_cache_dirty_submaps.set( smp.x * MAPSIZE + smp.y );
         }
     }
 }
@@ -466,7 +471,6 @@ void map::on_vehicle_moved( const int smz )
     set_transparency_cache_dirty( smz );
     set_floor_cache_dirty( smz );
     set_floor_cache_dirty( smz + 1 );
-    set_pathfinding_cache_dirty( smz );
 }
 
 void map::vehmove()
@@ -1225,6 +1229,8 @@ bool map::displace_vehicle( vehicle &veh, const tripoint &dp )
 
     // Need old coordinates to check for remote control
     const bool remote = veh.remote_controlled( g->u );
+    // Tiles the vehicle leaves need their pathfinding data updated too
+    const std::set<tripoint> old_points = veh.get_points( true );
 
     // record every passenger and pet inside
     std::vector<rider_data> riders = veh.get_riders();
@@ -1331,6 +1337,19 @@ bool map::displace_vehicle( vehicle &veh, const tripoint &dp )
     for( int vsmz : smzs ) {
         on_vehicle_moved( dst.z + vsmz );
     }
+    if( need_update || src.z != dst.z ) {
+        // The map may have moved under the old points
+        for( int vsmz : smzs ) {
+            set_pathfinding_cache_dirty( dst.z + vsmz );
+        }
+    } else {
+        for( const tripoint &p : old_points ) {
+            set_pathfinding_cache_dirty( p );
+        }
+        for( const tripoint &p : veh.get_points( true ) ) {
+            set_pathfinding_cache_dirty( p );
+        }
+    }
     return true;
 }
 
@@ -1474,7 +1493,7 @@ void map::furn_set( const tripoint &p, const furn_id &new_furniture,
     set_memory_seen_cache_dirty( p );
 
     // TODO: Limit to changes that affect move cost, traps and stairs
-    set_pathfinding_cache_dirty( p.z );
+    set_pathfinding_cache_dirty( p );
 
     // Make sure the furniture falls if it needs to
     support_dirty( p );
@@ -1755,7 +1774,7 @@ bool map::ter_set( const tripoint &p, const ter_id &new_terrain )
     set_memory_seen_cache_dirty( p );
 
     // TODO: Limit to changes that affect move cost, traps and stairs
-    set_pathfinding_cache_dirty( p.z );
+    set_pathfinding_cache_dirty( p );
 
     tripoint above( p.xy(), p.z + 1 );
     // Make sure that if we supported something and no longer do so, it falls down
@@ -5271,6 +5290,7 @@ void map::trap_set( const tripoint &p, const trap_id &type )
     if( type != tr_null ) {
         traplocs[type.to_i()].push_back( p );
     }
+    set_pathfinding_cache_dirty( p );
 }
 
 void map::disarm_trap( const tripoint &p )
@@ -5352,6 +5372,7 @@ void map::remove_trap( const tripoint &p )
         if( iter != traps.end() ) {
             traps.erase( iter );
         }
+        set_pathfinding_cache_dirty( p );
     }
 }
 /*
@@ -5490,6 +5511,7 @@ bool map::add_field( const tripoint &p, const field_type_id &type_id, int intens
     invalidate_max_populated_zlev( p.z );
 
     if( current_submap->get_field( l ).add_field( type_id, intensity, age ) ) {
+        current_submap->field_tiles.set( l.x * SEEY + l.y );
         //Only adding it to the count if it doesn't exist.
         if( !current_submap->field_count++ ) {
             get_cache( p.z ).field_cache.set( static_cast<size_t>( p.x / SEEX + ( (
@@ -5512,7 +5534,7 @@ bool map::add_field( const tripoint &p, const field_type_id &type_id, int intens
     }
 
     if( fd_type.is_dangerous() ) {
-        set_pathfinding_cache_dirty( p.z );
+        set_pathfinding_cache_dirty( p );
     }
 
     // Ensure blood type fields don't hang in the air
@@ -5544,7 +5566,7 @@ void map::remove_field( const tripoint &p, const field_type_id &field_to_remove
             set_seen_cache_dirty( p );
         }
         if( fdata.is_dangerous() ) {
-            set_pathfinding_cache_dirty( p.z );
+            set_pathfinding_cache_dirty( p );
         }
     }
 }
@@ -6682,12 +6704,16 @@ void map::save()
 
 void map::load( const tripoint &w, const bool update_vehicle, const bool pump_events )
 {
+    // Fields and graphs are in local coordinates.
+    flow_fields->clear();
+    portal_graphs->clear();
     for( auto &traps : traplocs ) {
         traps.clear();
     }
     field_furn_locs.clear();
     submaps_with_active_items.clear();
     set_abs_sub( w );
+    generate_missing_quads();
     for( int gridx = 0; gridx < my_MAPSIZE; gridx++ ) {
         for( int gridy = 0; gridy < my_MAPSIZE; gridy++ ) {
             loadn( point( gridx, gridy ), update_vehicle );
@@ -6764,6 +6790,36 @@ shift_bitset_cache<MAPSIZE_X, SEEX>( std::bitset<MAPSIZE_X *MAPSIZE_X> &cache,
 template void
 shift_bitset_cache<MAPSIZE, 1>( std::bitset<MAPSIZE *MAPSIZE> &cache, point s );
 
+// Submaps that are loaded by the shift mark themselves dirty.
+static void shift_pathfinding_cache( pathfinding_cache &cache, point sp )
+{
+    if( cache.dirty ) {
+        return;
+    }
+    const std::bitset<MAPSIZE *MAPSIZE> old_dirty = cache.dirty_submaps;
+    cache.dirty_submaps.reset();
+    for( int smx = 0; smx < MAPSIZE; smx++ ) {
+        for( int smy = 0; smy < MAPSIZE; smy++ ) {
+            const point src( smx + sp.x, smy + sp.y );
+            if( src.x >= 0 && src.x < MAPSIZE && src.y >= 0 && src.y < MAPSIZE &&
+                old_dirty[src.x * MAPSIZE + src.y] ) {
+                cache.dirty_submaps.set( smx * MAPSIZE + smy );
+            }
+        }
+    }
+    const std::vector<pf_special> old_special( &cache.special[0][0],
+            &cache.special[0][0] + MAPSIZE_X * MAPSIZE_Y );
+    const point offset( sp.x * SEEX, sp.y * SEEY );
+    for( int x = 0; x < MAPSIZE_X; x++ ) {
+        for( int y = 0; y < MAPSIZE_Y; y++ ) {
+            const point src( x + offset.x, y + offset.y );
+            if( src.x >= 0 && src.x < MAPSIZE_X && src.y >= 0 && src.y < MAPSIZE_Y ) {
+                cache.special[x][y] = old_special[src.x * MAPSIZE_Y + src.y];
+            }
+        }
+    }
+}
+
 static inline void shift_tripoint_set( std::set<tripoint> &set, point offset,
                                        const half_open_rectangle<point> &boundaries )
 {
@@ -6837,6 +6893,32 @@ void map::shift_vehicle_z( vehicle &veh, int z_shift )
 
 }
 
+void map::prefetch_submaps( point dir, int distance ) const
+{
+    if( dir == point_zero ) {
+        return;
+    }
+    const tripoint abs = get_abs_sub();
+    const int zmin = zlevels ? -OVERMAP_DEPTH : abs.z;
+    const int zmax = zlevels ? OVERMAP_HEIGHT : abs.z;
+    // The row or column of the map that the submaps are shifted in behind.
+    const int edge_x = dir.x > 0 ? my_MAPSIZE - 1 : 0;
+    const int edge_y = dir.y > 0 ? my_MAPSIZE - 1 : 0;
+    for( int dist = 1; dist <= distance; dist++ ) {
+        const point offset = abs.xy() + dir * dist;
+        for( int gridz = zmin; gridz <= zmax; gridz++ ) {
+            for( int i = 0; i < my_MAPSIZE; i++ ) {
+                if( dir.x != 0 ) {
+                    MAPBUFFER.prefetch( tripoint( offset + point( edge_x, i ), gridz ) );
+                }
+                if( dir.y != 0 ) {
+                    MAPBUFFER.prefetch( tripoint( offset + point( i, edge_y ), gridz ) );
+                }
+            }
+        }
+    }
+}
+
 void map::shift( point sp )
 {
     // Special case of 0-shift; refresh the map
@@ -6851,6 +6933,9 @@ void map::shift( point sp )
     const tripoint abs = get_abs_sub();
 
     set_abs_sub( abs + sp );
+    // Fields and graphs are in local coordinates.
+    flow_fields->clear();
+    portal_graphs->clear();
 
     // if player is in vehicle, (s)he must be shifted with vehicle too
     if( g->u.in_vehicle ) {
@@ -6884,6 +6969,7 @@ void map::shift( point sp )
         clear_vehicle_list( gridz );
         shift_bitset_cache<MAPSIZE_X, SEEX>( get_cache( gridz ).map_memory_seen_cache, sp );
         shift_bitset_cache<MAPSIZE, 1>( get_cache( gridz ).field_cache, sp );
+        shift_pathfinding_cache( get_pathfinding_cache( gridz ), sp );
         if( sp.x >= 0 ) {
             for( int gridx = 0; gridx < my_MAPSIZE; gridx++ ) {
                 if( sp.y >= 0 ) {
@@ -7040,7 +7126,7 @@ void map::saven( const tripoint &grid )
         }
     }
 
-    submap_to_save->last_touched = calendar::turn;
+    submap_to_save->set_last_touched( calendar::turn );
     MAPBUFFER.add_submap( abs, submap_to_save );
 }
 
@@ -7056,12 +7142,44 @@ static void generate_uniform( const tripoint &p, const ter_id &terrain_type )
             submap *sm = new submap();
             sm->is_uniform = true;
             sm->set_all_ter( terrain_type );
-            sm->last_touched = calendar::turn;
+            sm->set_last_touched( calendar::turn );
             MAPBUFFER.add_submap( p + point( xd, yd ), sm );
         }
     }
 }
 
+void map::generate_missing_quads()
+{
+    static const oter_id rock( "empty_rock" );
+    static const oter_id air( "open_air" );
+
+    std::vector<tripoint> quads;
+    const int zmin = zlevels ? -OVERMAP_DEPTH : abs_sub.z;
+    const int zmax = zlevels ? OVERMAP_HEIGHT : abs_sub.z;
+    for( int gridz = zmin; gridz <= zmax; gridz++ ) {
+        for( int gridx = 0; gridx < my_MAPSIZE; gridx++ ) {
+            for( int gridy = 0; gridy < my_MAPSIZE; gridy++ ) {
+                const tripoint grid_abs_sub( abs_sub.xy() + point( gridx, gridy ), gridz );
+                if( MAPBUFFER.lookup_submap( grid_abs_sub ) != nullptr ) {
+                    continue;
+                }
+                // TODO: fix point types
+                const tripoint_abs_omt grid_abs_omt( sm_to_omt_copy( grid_abs_sub ) );
+                const oter_id terrain_type = overmap_buffer.ter( grid_abs_omt );
+                // Uniform quads are cheap, loadn fills them in
+                if( terrain_type == air || terrain_type == rock ) {
+                    continue;
+                }
+                const tripoint quad = omt_to_sm_copy( grid_abs_omt.raw() );
+                if( std::find( quads.begin(), quads.end(), quad ) == quads.end() ) {
+                    quads.push_back( quad );
+                }
+            }
+        }
+    }
+    generate_quads( quads, calendar::turn );
+}
+
 void map::loadn( const tripoint &grid, const bool update_vehicles )
 {
     // Cache empty overmap types
@@ -7111,7 +7229,12 @@ void map::loadn( const tripoint &grid, const bool update_vehicles )
     set_seen_cache_dirty( grid.z );
     set_outside_cache_dirty( grid.z );
     set_floor_cache_dirty( grid.z );
-    set_pathfinding_cache_dirty( grid.z );
+    if( tmpsub->vehicles.empty() ) {
+        set_pathfinding_cache_dirty( tripoint( grid.x * SEEX, grid.y * SEEY, grid.z ) );
+    } else {
+        // Vehicles can reach into the neighboring submaps
+        set_pathfinding_cache_dirty( grid.z );
+    }
     set_suspension_cache_dirty( grid.z );
     setsubmap( gridn, tmpsub );
     if( !tmpsub->active_items.empty() ) {
@@ -7529,7 +7652,7 @@ void map::actualize( const tripoint &grid )
     }
 
     // the last time we touched the submap, is right now.
-    tmpsub->last_touched = calendar::turn;
+    tmpsub->set_last_touched( calendar::turn );
 }
 
 void map::add_roofs( const tripoint &grid )
@@ -8298,8 +8421,12 @@ void map::build_map_cache( const int zlev, bool skip_lightmap )
         build_outside_cache( z );
         build_transparency_cache( z );
         update_suspension_cache( z );
-        seen_cache_dirty |= ( build_floor_cache( z ) && affects_seen_cache );
-        seen_cache_dirty |= get_cache( z ).seen_cache_dirty && affects_seen_cache;
+        if( build_floor_cache( z ) && affects_seen_cache ) {
+            set_seen_cache_dirty( z );
+        }
+        const level_cache &cache = get_cache( z );
+        seen_cache_dirty |= ( cache.seen_cache_dirty || cache.seen_cache_dirty_submaps.any() ) &&
+                            affects_seen_cache;
         diagonal_blocks fill = {false, false};
         std::uninitialized_fill_n( &( get_cache( z ).vehicle_obscured_cache[0][0] ), MAPSIZE_X * MAPSIZE_Y,
                                    fill );
@@ -8312,7 +8439,10 @@ void map::build_map_cache( const int zlev, bool skip_lightmap )
         do_vehicle_caching( z );
     }
 
-    seen_cache_dirty |= build_vision_transparency_cache( get_player_character() );
+    if( build_vision_transparency_cache( get_player_character() ) ) {
+        set_seen_cache_dirty( zlev );
+        seen_cache_dirty = true;
+    }
 
     if( seen_cache_dirty ) {
         skew_vision_cache.clear();
@@ -8863,9 +8993,30 @@ void map::set_pathfinding_cache_dirty( const int zlev )
 {
     if( inbounds_z( zlev ) ) {
         get_pathfinding_cache( zlev ).dirty = true;
+        flow_fields->invalidate( zlev );
+        portal_graphs->invalidate( zlev );
     }
 }
 
+void map::set_pathfinding_cache_dirty( const tripoint &p )
+{
+    if( inbounds( p ) ) {
+        const tripoint smp = ms_to_sm_copy( p );
+        get_pathfinding_cache( p.z ).dirty_submaps.set( smp.x * MAPSIZE + smp.y );
+        flow_fields->invalidate( p.z );
+        portal_graphs->invalidate( p );
+    }
+}
+
+const flow_field *map::get_flow_field( const tripoint &target,
+                                       const pathfinding_settings &settings ) const
+{
+    if( !inbounds( target ) ) {
+        return nullptr;
+    }
+    return flow_fields->get( *this, target, settings );
+}
+
 bool map::check_seen_cache( const tripoint &p ) const
 {
     std::bitset<MAPSIZE_X *MAPSIZE_Y> &memory_seen_cache =
@@ -8911,7 +9062,7 @@ const pathfinding_cache &map::get_pathfinding_cache_ref( int zlev ) const
         return *pathfinding_caches[ OVERMAP_DEPTH ];
     }
     auto &cache = get_pathfinding_cache( zlev );
-    if( cache.dirty ) {
+    if( cache.dirty || cache.dirty_submaps.any() ) {
         update_pathfinding_cache( zlev );
     }
 
@@ -8921,14 +9072,26 @@ const pathfinding_cache &map::get_pathfinding_cache_ref( int zlev ) const
 void map::update_pathfinding_cache( int zlev ) const
 {
     auto &cache = get_pathfinding_cache( zlev );
-    if( !cache.dirty ) {
+    if( !cache.dirty && cache.dirty_submaps.none() ) {
         return;
     }
 
-    std::uninitialized_fill_n( &cache.special[0][0], MAPSIZE_X * MAPSIZE_Y, PF_NORMAL );
+    const bool rebuild_all = cache.dirty;
+    if( rebuild_all ) {
+        std::uninitialized_fill_n( &cache.special[0][0], MAPSIZE_X * MAPSIZE_Y, PF_NORMAL );
+        cache.stats.full_rebuilds++;
+    }
 
     for( int smx = 0; smx < my_MAPSIZE; ++smx ) {
         for( int smy = 0; smy < my_MAPSIZE; ++smy ) {
+            if( !rebuild_all && !cache.dirty_submaps[smx * MAPSIZE + smy] ) {
+                cache.stats.submaps_kept++;
+                continue;
+            }
+            if( !rebuild_all ) {
+                cache.stats.submaps_rebuilt++;
+            }
+
             const auto cur_submap = get_submap_at_grid( { smx, smy, zlev } );
             if( !cur_submap ) {
                 return;
@@ -8995,6 +9158,19 @@ void map::update_pathfinding_cache( int zlev ) const
     }
 
     cache.dirty = false;
+    cache.dirty_submaps.reset();
+}
+
+pathfinding_cache_stats map::take_pathfinding_cache_stats()
+{
+    pathfinding_cache_stats result;
+    for( std::unique_ptr<pathfinding_cache> &cache : pathfinding_caches ) {
+        result.full_rebuilds += cache->stats.full_rebuilds;
+        result.submaps_rebuilt += cache->stats.submaps_rebuilt;
+        result.submaps_kept += cache->stats.submaps_kept;
+        cache->stats = pathfinding_cache_stats();
+    }
+    return result;
 }
 
 void map::clip_to_bounds( tripoint &p ) const
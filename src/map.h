@@ -22,6 +22,7 @@
 #include "colony.h"
 #include "coordinate_conversions.h"
 #include "coordinates.h"
+#include "cuboid_rectangle.h"
 #include "enums.h"
 #include "filter_utils.h"
 #include "game_constants.h"
@@ -52,6 +53,10 @@ class character_id;
 class computer;
 class field;
 class field_entry;
+class flow_field;
+class flow_field_cache;
+class portal_graph_cache;
+struct route_corridor;
 class item_location;
 class map_cursor;
 class mapgendata;
@@ -86,8 +91,11 @@ using VehicleList = std::vector<wrapped_vehicle>;
 class map;
 
 enum ter_bitflags : int;
+struct field_spread_buffer;
 struct pathfinding_cache;
+struct pathfinding_cache_stats;
 struct pathfinding_settings;
+struct route_step;
 template<typename T>
 struct weighted_int_list;
 struct rl_vec2d;
@@ -95,6 +103,8 @@ struct rl_vec2d;
 
 /** Causes all generated maps to be empty grass and prevents saved maps from being loaded, used by the test suite */
 extern bool disable_mapgen;
+/** Set to false to cast all buffered light sources on the game thread, used by the test suite */
+extern bool parallel_light_sources;
 
 namespace cata
 {
@@ -307,6 +317,11 @@ struct level_cache {
     bool outside_cache_dirty = false;
     bool floor_cache_dirty = false;
     bool seen_cache_dirty = false;
+    // Submaps (x * MAPSIZE + y) with changes that only affect the parts of seen_cache
+    // that can see them, see map::build_seen_cache
+    std::bitset<MAPSIZE *MAPSIZE> seen_cache_dirty_submaps;
+    // Where seen_cache was last cast from without z-levels, tripoint_min if it wasn't
+    tripoint seen_cache_origin = tripoint_min;
     bool suspension_cache_initialized = false;
     bool suspension_cache_dirty = false;
     std::list<point> suspension_cache;
@@ -423,6 +438,8 @@ class map
         void set_suspension_cache_dirty( const int zlev );
 
         void set_pathfinding_cache_dirty( int zlev );
+        // Only rebuilds the submap of p, preferred over the above
+        void set_pathfinding_cache_dirty( const tripoint &p );
         /*@}*/
 
         void set_memory_seen_cache_dirty( const tripoint &p );
@@ -434,6 +451,7 @@ class map
 
         /**
          * Callback invoked when a vehicle has moved.
+         * Pathfinding caches are left to the caller, which knows the tiles that changed.
          */
         void on_vehicle_moved( int smz );
 
@@ -457,7 +475,7 @@ class map
 
         // See field.cpp
         std::tuple<maptile, maptile, maptile> get_wind_blockers( const int &winddirection,
-                const tripoint &pos );
+                const tripoint &pos ) const;
 
         /** Draw a visible part of the map into `w`.
          *
@@ -516,6 +534,11 @@ class map
          * Note: the map must have been loaded before this can be called.
          */
         void shift( point s );
+        /**
+         * Start reading the submaps that @ref shift would load when moving up to
+         * @p distance submaps along @p dir from disk, see @ref mapbuffer::prefetch.
+         */
+        void prefetch_submaps( point dir, int distance ) const;
         /**
          * Moves the map vertically to (not by!) newz.
          * Does not actually shift anything, only forces cache updates.
@@ -533,13 +556,27 @@ class map
         // Versions of the above that don't do bounds checks
         maptile maptile_at_internal( const tripoint &p ) const;
         maptile maptile_at_internal( const tripoint &p );
-        std::pair<tripoint, maptile> maptile_has_bounds( const tripoint &p, bool bounds_checked );
-        std::array<std::pair<tripoint, maptile>, 8> get_neighbors( const tripoint &p );
+        std::pair<tripoint, maptile> maptile_has_bounds( const tripoint &p, bool bounds_checked ) const;
+        std::array<std::pair<tripoint, maptile>, 8> get_neighbors( const tripoint &p ) const;
         void spread_gas( field_entry &cur, const tripoint &p, int percent_spread,
                          const time_duration &outdoor_age_speedup, scent_block &sblk );
+        /** The part of @ref spread_gas that doesn't move any gas: scent neutralization and aging outdoors. */
+        void dissipate_gas( field_entry &cur, const tripoint &p,
+                            const time_duration &outdoor_age_speedup, scent_block &sblk );
+        /** Wind strength for gas at @p p, reads the overmap so only use it on the game thread. */
+        int gas_windpower( const tripoint &p, bool sheltered );
+        /**
+         * Where one unit of @p cur at @p p spreads to this turn, if anywhere. Only reads
+         * the map, so it can run on the thread pool while nothing changes the map.
+         */
+        cata::optional<tripoint> gas_spread_destination( const field_entry &cur, const tripoint &p,
+                int percent_spread, int windpower, int winddirection, bool sheltered ) const;
+        /** Works out on the thread pool where the gas in @p submaps spreads to, see @ref spread_buffer. */
+        void plan_gas_spread( field_spread_buffer &buffer,
+                              const std::vector<std::pair<tripoint, submap *>> &submaps );
         void create_hot_air( const tripoint &p, int intensity );
-        bool gas_can_spread_to( field_entry &cur, const tripoint &src, const tripoint &dst );
-        void gas_spread_to( field_entry &cur, maptile &dst, const tripoint &p );
+        bool gas_can_spread_to( const field_entry &cur, const tripoint &src, const tripoint &dst ) const;
+        void gas_spread_to( field_entry &cur, const tripoint &src, maptile &dst, const tripoint &p );
         int burn_body_part( player &u, field_entry &cur, body_part bp, int scale );
     public:
 
@@ -699,6 +736,21 @@ class map
         std::vector<tripoint> route( const tripoint &f, const tripoint &t,
                                      const pathfinding_settings &settings,
         const std::set<tripoint> &pre_closed = {{ }} ) const;
+        /**
+         * Stepping from @p from onto its neighbor @p to in @ref route, @p cache is the
+         * pathfinding cache of their z-level.
+         */
+        route_step route_step_cost( const pathfinding_cache &cache, const tripoint &from,
+                                    const tripoint &to, const pathfinding_settings &settings ) const;
+        /** Tiles @ref route searches on its way from @p f to @p t, on each z-level in between. */
+        half_open_rectangle<point> route_bounds( const tripoint &f, const tripoint &t ) const;
+        /**
+         * Shared routes to @p target on its z-level, see @ref flow_field.
+         * Null if too few creatures asked for them yet, use @ref route then.
+         * The result stays valid until the next call.
+         */
+        const flow_field *get_flow_field( const tripoint &target,
+                                          const pathfinding_settings &settings ) const;
 
         // Vehicles: Common to 2D and 3D
         VehicleList get_vehicles();
@@ -1521,6 +1573,13 @@ class map
 
         // mapgen.cpp functions
         void generate( const tripoint &p, const time_point &when );
+        /**
+         * Generates the overmap terrain quads whose north west submaps are at @p quads (absolute
+         * submap coordinates), like @ref generate does for each of them. Quads whose mapgen only
+         * changes the map it draws on are drawn on the thread pool, with their own rng, see
+         * @ref draw_map_seeded. The others use the game's rng, as with @ref generate.
+         */
+        static void generate_quads( const std::vector<tripoint> &quads, const time_point &when );
         void place_spawns( const mongroup_id &group, int chance,
                            point p1, point p2, float density,
                            bool individual = false, bool friendly = false, const std::string &name = "NONE",
@@ -1657,6 +1716,8 @@ class map
 
     protected:
         void saven( const tripoint &grid );
+        /** Generates the quads @ref loadn would have to generate for the whole map at once. */
+        void generate_missing_quads();
         void loadn( const tripoint &grid, bool update_vehicles );
         void loadn( point grid, bool update_vehicles ) {
             if( zlevels ) {
@@ -1788,7 +1849,39 @@ class map
         void set_abs_sub( const tripoint &p );
 
     private:
+        /** Creates the submaps for @ref generate and returns the data for @ref draw_map. */
+        std::unique_ptr<mapgendata> start_generating( const tripoint &p, const time_point &when );
+        /** @ref draw_map with the rng seeded by the world seed and the position, for workers. */
+        void draw_map_seeded( mapgendata &dat );
+        /** Places map extras and spawns and saves the generated submaps. */
+        void finish_generating( const oter_id &terrain_type );
+        /** The part of @ref rotate that moves NPCs and zones. */
+        void rotate_npcs_and_zones( int turns, bool setpos_safe );
+        /**
+         * Set while @ref draw_map_seeded runs on a worker thread. @ref rotate leaves NPCs and
+         * zones to the game thread then, see @ref detached_rotation.
+         */
+        bool drawing_detached = false;
+        /** Turns @ref rotate made while @ref drawing_detached. */
+        int detached_rotation = 0;
+
         field &get_field( const tripoint &p );
+        /**
+         * @ref route planned over the submaps first, see @ref portal_graph, then searched
+         * tile by tile through the submaps along the way. Empty if there is no route,
+         * nullopt if only @ref search_route without a corridor can tell.
+         */
+        cata::optional<std::vector<tripoint>> route_through_portals( const tripoint &f,
+                                           const tripoint &t, const pathfinding_settings &settings,
+                                           const std::set<tripoint> &pre_closed ) const;
+        /**
+         * The tile by tile search of @ref route. Only through the submaps of @p corridor
+         * if that isn't null, otherwise within @ref route_bounds.
+         */
+        std::vector<tripoint> search_route( const tripoint &f, const tripoint &t,
+                                            const pathfinding_settings &settings,
+                                            const std::set<tripoint> &pre_closed,
+                                            const route_corridor *corridor ) const;
 
         /**
          * Get the submap pointer with given index in @ref grid, the index must be valid!
@@ -1956,6 +2049,13 @@ class map
         std::array< std::unique_ptr<level_cache>, OVERMAP_LAYERS > caches;
 
         mutable std::array< std::unique_ptr<pathfinding_cache>, OVERMAP_LAYERS > pathfinding_caches;
+        mutable std::unique_ptr<flow_field_cache> flow_fields;
+        mutable std::unique_ptr<portal_graph_cache> portal_graphs;
+        /**
+         * Snapshot and pending gas of the current @ref process_fields call, if gas spreads
+         * buffered (see the BUFFERED_FIELD_SPREAD option), nullptr otherwise.
+         */
+        field_spread_buffer *spread_buffer = nullptr;
         /**
          * Set of submaps that contain active items in absolute coordinates.
          */
@@ -1993,6 +2093,8 @@ class map
         const pathfinding_cache &get_pathfinding_cache_ref( int zlev ) const;
 
         void update_pathfinding_cache( int zlev ) const;
+        /** Counts of all levels since the last call. */
+        pathfinding_cache_stats take_pathfinding_cache_stats();
 
         void update_visibility_cache( int zlev );
         const visibility_variables &get_visibility_variables_cache() const;
@@ -0,0 +1,322 @@
+#include "map_archive.h"
+
+#include <algorithm>
+#include <istream>
+#include <list>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+#include "binary_io.h"
+#include "cata_utility.h"
+#include "filesystem.h"
+#include "string_formatter.h"
+
+static constexpr char archive_magic[] = { 'C', 'B', 'N', 'S' };
+static constexpr uint8_t archive_format_version = 1;
+static constexpr uint64_t archive_header_size = sizeof( archive_magic ) + 1;
+// Coordinates (3 x int32) and payload size (uint32).
+static constexpr uint64_t record_header_size = 16;
+// Files with less garbage than this are never compacted.
+static constexpr uint64_t min_compaction_garbage = 256 * 1024;
+
+namespace
+{
+// Archives that have their file open, the least recently used one first.
+struct open_archive_list {
+    std::mutex mutex;
+    std::list<map_segment_archive *> archives;
+};
+} // namespace
+
+static open_archive_list &open_archives()
+{
+    static open_archive_list list;
+    return list;
+}
+
+map_segment_archive::map_segment_archive( const std::string &path ) : file_path( path )
+{
+}
+
+size_t map_segment_archive::open_archive_count()
+{
+    open_archive_list &open = open_archives();
+    std::lock_guard<std::mutex> lock( open.mutex );
+    return open.archives.size();
+}
+
+map_segment_archive::~map_segment_archive()
+{
+    open_archive_list &open = open_archives();
+    std::lock_guard<std::mutex> lock( open.mutex );
+    open.archives.remove( this );
+}
+
+cata::optional<std::string> map_segment_archive::read( const tripoint &om_addr )
+{
+    std::lock_guard<std::mutex> lock( mutex );
+    load_index();
+    const auto iter = index.find( om_addr );
+    if( iter == index.end() ) {
+        return cata::nullopt;
+    }
+    return read_record( iter->second );
+}
+
+std::vector<tripoint> map_segment_archive::quads()
+{
+    std::lock_guard<std::mutex> lock( mutex );
+    load_index();
+    std::vector<tripoint> result;
+    result.reserve( index.size() );
+    for( const std::pair<const tripoint, record> &elem : index ) {
+        result.push_back( elem.first );
+    }
+    return result;
+}
+
+void map_segment_archive::append( const tripoint &om_addr, const std::string &data )
+{
+    std::lock_guard<std::mutex> lock( mutex );
+    load_index();
+    if( truncated ) {
+        // New records would end up behind the garbage and could never be found again.
+        compact_locked();
+    }
+
+    std::ostringstream buf;
+    if( file_size == 0 ) {
+        buf.write( archive_magic, sizeof( archive_magic ) );
+        binary_io::write<uint8_t>( buf, archive_format_version );
+    }
+    binary_io::write<int32_t>( buf, om_addr.x );
+    binary_io::write<int32_t>( buf, om_addr.y );
+    binary_io::write<int32_t>( buf, om_addr.z );
+    binary_io::write<uint32_t>( buf, data.size() );
+    buf.write( data.data(), data.size() );
+    const std::string bytes = buf.str();
+
+    cata_ofstream fout;
+    fout.mode( static_cast<cata_ios_mode>( static_cast<int>( cata_ios_mode::binary ) |
+                                           static_cast<int>( cata_ios_mode::app ) ) ).open( file_path );
+    if( !fout.is_open() ) {
+        throw std::runtime_error( "opening file failed" );
+    }
+    fout->write( bytes.data(), bytes.size() );
+    fout.flush();
+    if( fout.fail() ) {
+        // Part of the record may have been written, the next append must not rely on file_size.
+        truncated = true;
+        throw std::runtime_error( "writing to file failed" );
+    }
+    fout.close();
+
+    const auto old = index.find( om_addr );
+    if( old != index.end() ) {
+        live_size -= record_header_size + old->second.size;
+    }
+    const uint64_t new_size = file_size + bytes.size();
+    index[om_addr] = record{ new_size - data.size(), static_cast<uint32_t>( data.size() ) };
+    live_size += record_header_size + data.size();
+    file_size = new_size;
+}
+
+bool map_segment_archive::needs_compaction()
+{
+    std::lock_guard<std::mutex> lock( mutex );
+    if( !index_loaded ) {
+        return false;
+    }
+    const uint64_t garbage = file_size - std::min( file_size, archive_header_size + live_size );
+    return truncated || ( garbage > min_compaction_garbage && garbage > live_size );
+}
+
+void map_segment_archive::compact()
+{
+    std::lock_guard<std::mutex> lock( mutex );
+    load_index();
+    compact_locked();
+}
+
+void map_segment_archive::compact_locked()
+{
+    std::vector<std::pair<tripoint, std::string>> records;
+    records.reserve( index.size() );
+    for( const std::pair<const tripoint, record> &elem : index ) {
+        records.emplace_back( elem.first, read_record( elem.second ) );
+    }
+    // The file is replaced, which not all platforms allow while it is open.
+    close_reader();
+
+    if( records.empty() ) {
+        remove_file( file_path );
+        index.clear();
+        file_size = 0;
+        live_size = 0;
+        truncated = false;
+        return;
+    }
+
+    std::map<tripoint, record> new_index;
+    uint64_t offset = archive_header_size;
+    write_to_file( file_path, [&]( std::ostream & fout ) {
+        fout.write( archive_magic, sizeof( archive_magic ) );
+        binary_io::write<uint8_t>( fout, archive_format_version );
+        for( const std::pair<tripoint, std::string> &elem : records ) {
+            binary_io::write<int32_t>( fout, elem.first.x );
+            binary_io::write<int32_t>( fout, elem.first.y );
+            binary_io::write<int32_t>( fout, elem.first.z );
+            binary_io::write<uint32_t>( fout, elem.second.size() );
+            fout.write( elem.second.data(), elem.second.size() );
+            offset += record_header_size;
+            new_index[elem.first] = record{ offset, static_cast<uint32_t>( elem.second.size() ) };
+            offset += elem.second.size();
+        }
+    } );
+    index = std::move( new_index );
+    file_size = offset;
+    live_size = offset - archive_header_size;
+    truncated = false;
+}
+
+void map_segment_archive::load_index()
+{
+    if( index_loaded ) {
+        return;
+    }
+    if( !file_exist( file_path ) ) {
+        index_loaded = true;
+        return;
+    }
+
+    // Nothing half loaded may stay behind, or the next append would take the file for
+    // an empty one and write a new header over it.
+    on_out_of_scope reset_on_error( [this]() {
+        if( !index_loaded ) {
+            close_reader();
+            index.clear();
+            file_size = 0;
+            live_size = 0;
+            truncated = false;
+        }
+    } );
+    open_reader();
+    std::istream &fin = *reader;
+    fin.seekg( 0, std::ios::end );
+    const uint64_t length = static_cast<uint64_t>( fin.tellg() );
+    fin.seekg( 0 );
+
+    char magic[sizeof( archive_magic )];
+    if( !fin.read( magic, sizeof( magic ) ) ||
+        !std::equal( std::begin( magic ), std::end( magic ), std::begin( archive_magic ) ) ) {
+        move_aside( string_format( "%s is not a map segment archive", file_path ) );
+    }
+    const uint8_t format_version = binary_io::read<uint8_t>( fin );
+    if( format_version != archive_format_version ) {
+        move_aside( string_format( "%s has unsupported format version %d", file_path,
+                                   format_version ) );
+    }
+
+    uint64_t offset = archive_header_size;
+    while( offset + record_header_size <= length ) {
+        tripoint om_addr;
+        om_addr.x = binary_io::read<int32_t>( fin );
+        om_addr.y = binary_io::read<int32_t>( fin );
+        om_addr.z = binary_io::read<int32_t>( fin );
+        const uint32_t size = binary_io::read<uint32_t>( fin );
+        if( offset + record_header_size + size > length ) {
+            break;
+        }
+        const auto old = index.find( om_addr );
+        if( old != index.end() ) {
+            live_size -= record_header_size + old->second.size;
+        }
+        index[om_addr] = record{ offset + record_header_size, size };
+        live_size += record_header_size + size;
+        offset += record_header_size + size;
+        fin.seekg( offset );
+    }
+    // Anything behind the last complete record is left over from an interrupted write.
+    truncated = offset != length;
+    file_size = offset;
+    index_loaded = true;
+}
+
+void map_segment_archive::move_aside( const std::string &reason )
+{
+    close_reader();
+    const std::string aside_path = file_path + ".corrupt";
+    if( !rename_file( file_path, aside_path ) ) {
+        throw std::runtime_error( string_format( "%s, moving it to %s failed", reason, aside_path ) );
+    }
+    // The archive starts over empty, so quads generated again are saved as usual.
+    index.clear();
+    file_size = 0;
+    live_size = 0;
+    truncated = false;
+    index_loaded = true;
+    throw std::runtime_error( string_format( "%s, moved it to %s", reason, aside_path ) );
+}
+
+std::string map_segment_archive::read_record( const record &rec )
+{
+    if( reader.is_open() ) {
+        touch_reader();
+    } else {
+        open_reader();
+    }
+    std::istream &fin = *reader;
+    // Records may have been appended since the last read, reset EOF and refill the buffer.
+    fin.clear();
+    fin.seekg( rec.offset );
+    std::string result( rec.size, '\0' );
+    if( rec.size > 0 && !fin.read( &result[0], rec.size ) ) {
+        throw std::runtime_error( string_format( "unexpected end of %s", file_path ) );
+    }
+    return result;
+}
+
+void map_segment_archive::open_reader()
+{
+    reader = std::move( cata_ifstream().mode( cata_ios_mode::binary ).open( file_path ) );
+    if( !reader.is_open() ) {
+        throw std::runtime_error( string_format( "could not open %s", file_path ) );
+    }
+    open_archive_list &open = open_archives();
+    std::lock_guard<std::mutex> lock( open.mutex );
+    open.archives.remove( this );
+    open.archives.push_back( this );
+    // Archives are only ever tried here, never waited for, as their owner may be
+    // waiting for the list while holding its own lock.
+    for( auto iter = open.archives.begin();
+         open.archives.size() > max_open_archives && *iter != this; ) {
+        map_segment_archive &lru = **iter;
+        std::unique_lock<std::mutex> lru_lock( lru.mutex, std::try_to_lock );
+        if( !lru_lock.owns_lock() ) {
+            ++iter;
+            continue;
+        }
+        lru.reader.close();
+        iter = open.archives.erase( iter );
+    }
+}
+
+void map_segment_archive::touch_reader()
+{
+    open_archive_list &open = open_archives();
+    std::lock_guard<std::mutex> lock( open.mutex );
+    if( open.archives.empty() || open.archives.back() != this ) {
+        open.archives.remove( this );
+        open.archives.push_back( this );
+    }
+}
+
+void map_segment_archive::close_reader()
+{
+    reader.close();
+    open_archive_list &open = open_archives();
+    std::lock_guard<std::mutex> lock( open.mutex );
+    open.archives.remove( this );
+}
@@ -0,0 +1,94 @@
+#pragma once
+#ifndef CATA_SRC_MAP_ARCHIVE_H
+#define CATA_SRC_MAP_ARCHIVE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "fstream_utils.h"
+#include "optional.h"
+#include "point.h"
+
+/**
+ * All saved quads of one map segment (32x32 overmap terrain tiles), in a single file.
+ *
+ * The file starts with a short header, followed by records that each hold one
+ * serialized quad and its overmap terrain coordinates. Records are only appended,
+ * saving a quad again turns its previous record into garbage that is dropped by
+ * @ref compact. The index of record offsets is built once by scanning the record
+ * headers, after that loading a quad is a single seek and read.
+ *
+ * The file is kept open for reading, but only the most recently used archives keep
+ * theirs open, see @ref max_open_archives. All members are thread safe, so records
+ * can be appended on a writer thread while the game thread reads other quads.
+ */
+class map_segment_archive
+{
+    public:
+        explicit map_segment_archive( const std::string &path );
+        map_segment_archive( const map_segment_archive & ) = delete;
+        map_segment_archive &operator=( const map_segment_archive & ) = delete;
+        ~map_segment_archive();
+
+        /**
+         * How many archives keep their file open at most. Archives that are busy on
+         * another thread aren't closed, so there may briefly be a few more.
+         */
+        static constexpr size_t max_open_archives = 32;
+        /** How many archives have their file open right now. */
+        static size_t open_archive_count();
+
+        const std::string &path() const {
+            return file_path;
+        }
+
+        /** Serialized quad at @p om_addr, or nothing if it has no record. */
+        cata::optional<std::string> read( const tripoint &om_addr );
+        /** Coordinates of all quads that have a record. */
+        std::vector<tripoint> quads();
+        /** Add a record for @p om_addr, replacing the old one. Throws on I/O errors. */
+        void append( const tripoint &om_addr, const std::string &data );
+
+        /** Whether the file is mostly garbage and should be compacted. */
+        bool needs_compaction();
+        /** Rewrite the file with only the newest record of each quad. Throws on I/O errors. */
+        void compact();
+
+    private:
+        struct record {
+            uint64_t offset;
+            uint32_t size;
+        };
+
+        /**
+         * Throws if the file is corrupt. It is moved aside first, the archive is then
+         * empty and appends to a new file. If that fails, the archive refuses to append.
+         */
+        void load_index();
+        /** Moves the corrupt file out of the way and throws @p reason. */
+        [[noreturn]] void move_aside( const std::string &reason );
+        void compact_locked();
+        std::string read_record( const record &rec );
+        /** Opens @ref reader and closes the reader of the least recently used archive. */
+        void open_reader();
+        /** Marks the archive as the most recently used one. */
+        void touch_reader();
+        void close_reader();
+
+        std::mutex mutex;
+        std::string file_path;
+        cata_ifstream reader;
+        bool index_loaded = false;
+        // The file ends in a partially written record, appending must rewrite it first.
+        bool truncated = false;
+        std::map<tripoint, record> index;
+        uint64_t file_size = 0;
+        // Size of the newest records of all quads, including their headers.
+        uint64_t live_size = 0;
+};
+
+#endif // CATA_SRC_MAP_ARCHIVE_H
@@ -2,7 +2,9 @@
 #include <array>
 #include <bitset>
 #include <cstddef>
+#include <future>
 #include <list>
+#include <map>
 #include <memory>
 #include <queue>
 #include <set>
@@ -45,6 +47,7 @@
 #include "mtype.h"
 #include "npc.h"
 #include "optional.h"
+#include "options.h"
 #include "overmapbuffer.h"
 #include "player.h"
 #include "pldata.h"
@@ -54,6 +57,7 @@
 #include "string_id.h"
 #include "submap.h"
 #include "teleport.h"
+#include "thread_pool.h"
 #include "translations.h"
 #include "type_id.h"
 #include "units.h"
@@ -138,23 +142,206 @@ int map::burn_body_part( player &u, field_entry &cur, body_part bp, const int sc
     return total_damage;
 }
 
+using field_snapshot = std::array<field, SEEX * SEEY>;
+
+/**
+ * Gas spreading of one @ref map::process_fields call, when it is buffered.
+ * Where the gas of each submap goes is worked out on the thread pool from the fields
+ * as they were at the start of the turn. The gas is moved after all submaps were
+ * processed, so the result doesn't depend on the order of the submaps.
+ */
+struct field_spread_buffer {
+    // A gas field that may spread this turn, with what is looked up for it on the game thread.
+    struct gas_source {
+        tripoint p;
+        field_entry gas;
+        int percent_spread;
+        int windpower;
+        bool sheltered;
+    };
+    struct deposit {
+        tripoint src;
+        tripoint p;
+        field_type_id type;
+    };
+
+    // Fields of the submaps that had any at the start of the turn, by grid position.
+    std::map<tripoint, std::unique_ptr<field_snapshot>> snapshots;
+    std::vector<deposit> deposits;
+
+    const field *field_at( const tripoint &p ) const {
+        if( p.x < 0 || p.y < 0 ) {
+            return nullptr;
+        }
+        const auto iter = snapshots.find( tripoint( p.x / SEEX, p.y / SEEY, p.z ) );
+        if( iter == snapshots.end() ) {
+            return nullptr;
+        }
+        return &( *iter->second )[( p.x % SEEX ) * SEEY + p.y % SEEY];
+    }
+};
+
+// Each submap gets its own random numbers, which don't depend on what else used the RNG.
+static unsigned int submap_rng_seed( const tripoint &abs_sm )
+{
+    unsigned int seed = static_cast<unsigned int>( to_turn<int>( calendar::turn ) );
+    for( const int coord : {
+             abs_sm.x, abs_sm.y, abs_sm.z
+         } ) {
+        seed = seed * 2654435761U + static_cast<unsigned int>( coord );
+    }
+    return seed;
+}
+
+static void take_field_snapshots( field_spread_buffer &buffer,
+                                  const std::vector<std::pair<tripoint, submap *>> &submaps )
+{
+    std::vector<std::pair<const submap *, field_snapshot *>> copies;
+    for( const std::pair<tripoint, submap *> &sm : submaps ) {
+        std::unique_ptr<field_snapshot> &snapshot = buffer.snapshots[sm.first];
+        snapshot = std::make_unique<field_snapshot>();
+        copies.emplace_back( sm.second, snapshot.get() );
+    }
+    const auto copy_range = [&copies]( size_t begin, size_t end ) {
+        for( size_t i = begin; i < end; i++ ) {
+            field_snapshot &snapshot = *copies[i].second;
+            for( size_t tile = 0; tile < snapshot.size(); tile++ ) {
+                snapshot[tile] = copies[i].first->get_field( point( tile / SEEY, tile % SEEY ) );
+            }
+        }
+    };
+    // The game thread copies the first share while the pool copies the others.
+    thread_pool &pool = get_thread_pool();
+    const size_t shares = std::min( pool.size() + 1, copies.size() );
+    std::vector<std::future<void>> pending;
+    for( size_t share = 1; share < shares; share++ ) {
+        pending.push_back( pool.submit( [&copy_range, &copies, share, shares]() {
+            copy_range( copies.size() * share / shares, copies.size() * ( share + 1 ) / shares );
+        } ) );
+    }
+    copy_range( 0, shares > 0 ? copies.size() / shares : 0 );
+    for( std::future<void> &share : pending ) {
+        share.get();
+    }
+}
+
 void map::process_fields()
 {
     const int minz = zlevels ? -OVERMAP_DEPTH : abs_sub.z;
     const int maxz = zlevels ? OVERMAP_HEIGHT : abs_sub.z;
+    std::vector<std::pair<tripoint, submap *>> submaps;
     for( int z = minz; z <= maxz; z++ ) {
         auto &field_cache = get_cache( z ).field_cache;
         for( int x = 0; x < my_MAPSIZE; x++ ) {
             for( int y = 0; y < my_MAPSIZE; y++ ) {
                 if( field_cache[ x + y * MAPSIZE ] ) {
-                    submap *const current_submap = get_submap_at_grid( { x, y, z } );
-                    process_fields_in_submap( current_submap, tripoint( x, y, z ) );
+                    submaps.emplace_back( tripoint( x, y, z ), get_submap_at_grid( { x, y, z } ) );
                 }
             }
         }
+    }
 
+    if( !get_option<bool>( "BUFFERED_FIELD_SPREAD" ) ) {
+        for( const std::pair<tripoint, submap *> &sm : submaps ) {
+            process_fields_in_submap( sm.second, sm.first );
+        }
         // no need to invalidate "transparency" and "seen" caches here
         // they are invalidated point by point inside the `process_fields_in_submap`
+        return;
+    }
+
+    field_spread_buffer buffer;
+    take_field_snapshots( buffer, submaps );
+    spread_buffer = &buffer;
+    plan_gas_spread( buffer, submaps );
+    for( const std::pair<tripoint, submap *> &sm : submaps ) {
+        const rng_seed_scope seeded( submap_rng_seed( tripoint( abs_sub.xy() + sm.first.xy(),
+                                     sm.first.z ) ) );
+        process_fields_in_submap( sm.second, sm.first );
+    }
+    spread_buffer = nullptr;
+
+    std::sort( buffer.deposits.begin(), buffer.deposits.end(),
+    []( const field_spread_buffer::deposit & lhs, const field_spread_buffer::deposit & rhs ) {
+        return std::tie( lhs.p, lhs.type, lhs.src ) < std::tie( rhs.p, rhs.type, rhs.src );
+    } );
+    for( const field_spread_buffer::deposit &gas : buffer.deposits ) {
+        field_entry *const src = get_field( gas.src, gas.type );
+        // Like when spreading right away, the last of the gas stays where it is.
+        if( src == nullptr || !src->is_field_alive() || src->get_field_intensity() <= 1 ) {
+            continue;
+        }
+        field_entry *dst = get_field( gas.p, gas.type );
+        if( dst != nullptr ) {
+            if( dst->get_field_intensity() >= dst->get_max_field_intensity() ) {
+                continue;
+            }
+            dst->set_field_intensity( dst->get_field_intensity() + 1 );
+        } else if( !add_field( gas.p, gas.type, 1, 0_turns ) ||
+                   ( dst = get_field( gas.p, gas.type ) ) == nullptr ) {
+            continue;
+        }
+        const time_duration age_fraction = src->get_field_age() / src->get_field_intensity();
+        dst->set_field_age( dst->get_field_age() + age_fraction );
+        src->set_field_intensity( src->get_field_intensity() - 1 );
+        src->set_field_age( src->get_field_age() - age_fraction );
+    }
+}
+
+void map::plan_gas_spread( field_spread_buffer &buffer,
+                           const std::vector<std::pair<tripoint, submap *>> &submaps )
+{
+    // The wind needs the overmap and the vehicles, so it's looked up here on the game thread.
+    std::vector<std::vector<field_spread_buffer::gas_source>> sources( submaps.size() );
+    for( size_t i = 0; i < submaps.size(); i++ ) {
+        const tripoint &grid = submaps[i].first;
+        const field_snapshot &snapshot = *buffer.snapshots.at( grid );
+        for( size_t tile = 0; tile < snapshot.size(); tile++ ) {
+            const tripoint p( grid.x * SEEX + tile / SEEY, grid.y * SEEY + tile % SEEY, grid.z );
+            for( const field::entry &fd : snapshot[tile] ) {
+                field_entry gas = fd.second;
+                // Same as in process_fields_in_submap, which doesn't spread newborn fields.
+                if( gas.get_field_age() == 0_turns || !gas.gas_can_spread() ) {
+                    continue;
+                }
+                const bool sheltered = g->is_sheltered( p );
+                sources[i].push_back( { p, gas, gas.get_field_type()->percent_spread,
+                                        gas_windpower( p, sheltered ), sheltered } );
+            }
+        }
+    }
+
+    // Only reads the map, which nothing changes until all submaps are planned.
+    const int winddirection = get_weather().winddirection;
+    std::vector<std::vector<field_spread_buffer::deposit>> deposits( submaps.size() );
+    const auto plan_range = [&]( size_t begin, size_t end ) {
+        for( size_t i = begin; i < end; i++ ) {
+            const tripoint &grid = submaps[i].first;
+            const rng_seed_scope seeded( submap_rng_seed( tripoint( abs_sub.xy() + grid.xy(),
+                                         grid.z ) ) ^ 0x9e3779b9U );
+            for( field_spread_buffer::gas_source &src : sources[i] ) {
+                const cata::optional<tripoint> dst = gas_spread_destination( src.gas, src.p,
+                                                     src.percent_spread, src.windpower, winddirection, src.sheltered );
+                if( dst ) {
+                    deposits[i].push_back( { src.p, *dst, src.gas.get_field_type() } );
+                }
+            }
+        }
+    };
+    thread_pool &pool = get_thread_pool();
+    const size_t shares = std::min( pool.size() + 1, submaps.size() );
+    std::vector<std::future<void>> pending;
+    for( size_t share = 1; share < shares; share++ ) {
+        pending.push_back( pool.submit( [&plan_range, &submaps, share, shares]() {
+            plan_range( submaps.size() * share / shares, submaps.size() * ( share + 1 ) / shares );
+        } ) );
+    }
+    plan_range( 0, shares > 0 ? submaps.size() / shares : 0 );
+    for( std::future<void> &share : pending ) {
+        share.get();
+    }
+    for( std::vector<field_spread_buffer::deposit> &planned : deposits ) {
+        buffer.deposits.insert( buffer.deposits.end(), planned.begin(), planned.end() );
     }
 }
 
@@ -177,7 +364,8 @@ static int ter_furn_movecost( const ter_t &ter, const furn_t &furn )
 }
 
 // Wrapper to allow skipping bound checks except at the edges of the map
-std::pair<tripoint, maptile> map::maptile_has_bounds( const tripoint &p, const bool bounds_checked )
+std::pair<tripoint, maptile> map::maptile_has_bounds( const tripoint &p,
+        const bool bounds_checked ) const
 {
     if( bounds_checked ) {
         // We know that the point is in bounds
@@ -187,7 +375,7 @@ std::pair<tripoint, maptile> map::maptile_has_bounds( const tripoint &p, const b
     return {p, maptile_at( p )};
 }
 
-std::array<std::pair<tripoint, maptile>, 8> map::get_neighbors( const tripoint &p )
+std::array<std::pair<tripoint, maptile>, 8> map::get_neighbors( const tripoint &p ) const
 {
     // Find out which edges are in the bubble
     // Where possible, do just one bounds check for all the neighbors
@@ -208,10 +396,13 @@ std::array<std::pair<tripoint, maptile>, 8> map::get_neighbors( const tripoint &
     };
 }
 
-bool map::gas_can_spread_to( field_entry &cur, const tripoint &src, const tripoint &dst )
+bool map::gas_can_spread_to( const field_entry &cur, const tripoint &src,
+                             const tripoint &dst ) const
 {
     maptile dst_tile = maptile_at( dst );
-    const field_entry *tmpfld = dst_tile.get_field().find_field( cur.get_field_type() );
+    const field *snapshot = spread_buffer != nullptr ? spread_buffer->field_at( dst ) : nullptr;
+    const field &dst_fields = snapshot != nullptr ? *snapshot : dst_tile.get_field();
+    const field_entry *tmpfld = dst_fields.find_field( cur.get_field_type() );
     // Candidates are existing weaker fields or navigable/flagged tiles with no field.
     if( tmpfld == nullptr || tmpfld->get_field_intensity() < cur.get_field_intensity() ) {
         const ter_t &ter = dst_tile.get_ter_t();
@@ -222,7 +413,7 @@ bool map::gas_can_spread_to( field_entry &cur, const tripoint &src, const tripoi
     return false;
 }
 
-void map::gas_spread_to( field_entry &cur, maptile &dst, const tripoint &p )
+void map::gas_spread_to( field_entry &cur, const tripoint &src, maptile &dst, const tripoint &p )
 {
     const field_type_id current_type = cur.get_field_type();
     const time_duration current_age = cur.get_field_age();
@@ -230,7 +421,10 @@ void map::gas_spread_to( field_entry &cur, maptile &dst, const tripoint &p )
     field_entry *f = dst.find_field( current_type );
     // Nearby gas grows thicker, and ages are shared.
     const time_duration age_fraction = current_age / current_intensity;
-    if( f != nullptr ) {
+    if( spread_buffer != nullptr ) {
+        // The gas only leaves once it has somewhere to go.
+        spread_buffer->deposits.push_back( { src, p, current_type } );
+    } else if( f != nullptr ) {
         f->set_field_intensity( f->get_field_intensity() + 1 );
         cur.set_field_intensity( current_intensity - 1 );
         f->set_field_age( f->get_field_age() + age_fraction );
@@ -248,19 +442,18 @@ void map::gas_spread_to( field_entry &cur, maptile &dst, const tripoint &p )
     }
 }
 
-void map::spread_gas( field_entry &cur, const tripoint &p, int percent_spread,
-                      const time_duration &outdoor_age_speedup, scent_block &sblk )
+int map::gas_windpower( const tripoint &p, const bool sheltered )
 {
-    map &here = get_map();
     // TODO: fix point types
     const oter_id &cur_om_ter =
-        overmap_buffer.ter( tripoint_abs_omt( ms_to_omt_copy( here.getabs( p ) ) ) );
-    const bool sheltered = g->is_sheltered( p );
+        overmap_buffer.ter( tripoint_abs_omt( ms_to_omt_copy( getabs( p ) ) ) );
     const weather_manager &weather = get_weather();
-    const int winddirection = weather.winddirection;
-    const int windpower = get_local_windpower( weather.windspeed, cur_om_ter, p, winddirection,
-                          sheltered );
+    return get_local_windpower( weather.windspeed, cur_om_ter, p, weather.winddirection, sheltered );
+}
 
+void map::dissipate_gas( field_entry &cur, const tripoint &p,
+                         const time_duration &outdoor_age_speedup, scent_block &sblk )
+{
     const int current_intensity = cur.get_field_intensity();
     const field_type_id ft_id = cur.get_field_type();
 
@@ -279,10 +472,29 @@ void map::spread_gas( field_entry &cur, const tripoint &p, int percent_spread,
         const time_duration current_age = cur.get_field_age();
         cur.set_field_age( current_age + outdoor_age_speedup );
     }
+}
+
+void map::spread_gas( field_entry &cur, const tripoint &p, int percent_spread,
+                      const time_duration &outdoor_age_speedup, scent_block &sblk )
+{
+    dissipate_gas( cur, p, outdoor_age_speedup, sblk );
+    const bool sheltered = g->is_sheltered( p );
+    const cata::optional<tripoint> dst = gas_spread_destination( cur, p, percent_spread,
+                                         gas_windpower( p, sheltered ), get_weather().winddirection, sheltered );
+    if( dst ) {
+        maptile dst_tile = maptile_at( *dst );
+        gas_spread_to( cur, p, dst_tile, *dst );
+    }
+}
 
+cata::optional<tripoint> map::gas_spread_destination( const field_entry &cur, const tripoint &p,
+        const int percent_spread, const int windpower, const int winddirection,
+        const bool sheltered ) const
+{
+    const int current_intensity = cur.get_field_intensity();
     // Bail out if we don't meet the spread chance or required intensity.
     if( current_intensity <= 1 || rng( 1, 100 - windpower ) > percent_spread ) {
-        return;
+        return cata::nullopt;
     }
 
     // First check if we can fall
@@ -290,13 +502,11 @@ void map::spread_gas( field_entry &cur, const tripoint &p, int percent_spread,
     if( zlevels && p.z > -OVERMAP_DEPTH ) {
         const tripoint down{ p.xy(), p.z - 1 };
         if( gas_can_spread_to( cur, p, down ) && valid_move( p, down, true, true ) ) {
-            maptile down_tile = maptile_at_internal( down );
-            gas_spread_to( cur, down_tile, down );
-            return;
+            return down;
         }
     }
 
-    auto neighs = get_neighbors( p );
+    const auto neighs = get_neighbors( p );
     size_t end_it = static_cast<size_t>( rng( 0, neighs.size() - 1 ) );
     std::vector<size_t> spread;
     std::vector<size_t> neighbour_vec;
@@ -319,9 +529,8 @@ void map::spread_gas( field_entry &cur, const tripoint &p, int percent_spread,
     const maptile remove_tile3 = std::get<2>( maptiles );
     if( !spread.empty() && ( !zlevels || one_in( spread.size() ) ) ) {
         // Construct the destination from offset and p
-        if( g->is_sheltered( p ) || windpower < 5 ) {
-            std::pair<tripoint, maptile> &n = neighs[ random_entry( spread ) ];
-            gas_spread_to( cur, n.second, n.first );
+        if( sheltered || windpower < 5 ) {
+            return neighs[ random_entry( spread ) ].first;
         } else {
             end_it = static_cast<size_t>( rng( 0, neighs.size() - 1 ) );
             // Start at end_it + 1, then wrap around until all elements have been processed.
@@ -338,17 +547,16 @@ void map::spread_gas( field_entry &cur, const tripoint &p, int percent_spread,
                 }
             }
             if( !neighbour_vec.empty() ) {
-                std::pair<tripoint, maptile> &n = neighs[neighbour_vec[rng( 0, neighbour_vec.size() - 1 )]];
-                gas_spread_to( cur, n.second, n.first );
+                return neighs[neighbour_vec[rng( 0, neighbour_vec.size() - 1 )]].first;
             }
         }
     } else if( zlevels && p.z < OVERMAP_HEIGHT ) {
         const tripoint up{ p.xy(), p.z + 1 };
         if( gas_can_spread_to( cur, p, up ) && valid_move( p, up, true, true ) ) {
-            maptile up_tile = maptile_at_internal( up );
-            gas_spread_to( cur, up_tile, up );
+            return up;
         }
     }
+    return cata::nullopt;
 }
 
 static inline bool check_flammable( const map_data_common_t &t )
@@ -412,9 +620,15 @@ void map::process_fields_in_submap( submap *const current_submap,
     int &locy = map_tile.pos_.y;
     const point sm_offset( submap.x * SEEX, submap.y * SEEY );
 
-    // Loop through all tiles in this submap indicated by current_submap
+    // Loop through the tiles of this submap that have fields, in the same order as the
+    // fields are stored.
+    std::bitset<SEEX * SEEY> &field_tiles = current_submap->field_tiles;
     for( locx = 0; locx < SEEX; locx++ ) {
         for( locy = 0; locy < SEEY; locy++ ) {
+            const size_t tile_index = locx * SEEY + locy;
+            if( !field_tiles[tile_index] ) {
+                continue;
+            }
             // Get a reference to the field variable from the submap;
             // contains all the pointers to the real field effects.
             field &curfield = current_submap->get_field( { static_cast<int>( locx ), static_cast<int>( locy ) } );
@@ -422,6 +636,7 @@ void map::process_fields_in_submap( submap *const current_submap,
             // when displayed_field_type == fd_null it means that `curfield` has no fields inside
             // avoids instantiating (relatively) expensive map iterator
             if( !curfield.displayed_field_type() ) {
+                field_tiles.reset( tile_index );
                 continue;
             }
 
@@ -850,7 +1065,12 @@ void map::process_fields_in_submap( submap *const current_submap,
                     const int gas_percent_spread = cur_fd_type.percent_spread;
                     if( gas_percent_spread > 0 ) {
                         const time_duration outdoor_age_speedup = cur_fd_type.outdoor_age_speedup;
-                        spread_gas( cur, p, gas_percent_spread, outdoor_age_speedup, sblk );
+                        if( spread_buffer != nullptr ) {
+                            // Where it goes was already planned on the thread pool.
+                            dissipate_gas( cur, p, outdoor_age_speedup, sblk );
+                        } else {
+                            spread_gas( cur, p, gas_percent_spread, outdoor_age_speedup, sblk );
+                        }
                     }
                 }
 
@@ -1194,6 +1414,9 @@ void map::process_fields_in_submap( submap *const current_submap,
                 set_transparency_cache_dirty( thep );
                 set_seen_cache_dirty( thep );
             }
+            if( curfield.field_count() == 0 ) {
+                field_tiles.reset( tile_index );
+            }
         }
     }
     const int minz = zlevels ? -OVERMAP_DEPTH : abs_sub.z;
@@ -1892,7 +2115,7 @@ void map::monster_in_field( monster &z )
 }
 
 std::tuple<maptile, maptile, maptile> map::get_wind_blockers( const int &winddirection,
-        const tripoint &pos )
+        const tripoint &pos ) const
 {
     static const std::array<std::pair<int, std::tuple< point, point, point >>, 9> outputs = {{
             { 330, std::make_tuple( point_east, point_north_east, point_south_east ) },
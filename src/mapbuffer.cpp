@@ -1,13 +1,19 @@
 #include "mapbuffer.h"
 
 #include <algorithm>
+#include <cstdint>
+#include <cstdio>
 #include <exception>
 #include <functional>
+#include <iterator>
 #include <set>
 #include <sstream>
+#include <stdexcept>
+#include <thread>
 #include <utility>
 #include <vector>
 
+#include "binary_io.h"
 #include "cata_utility.h"
 #include "coordinate_conversions.h"
 #include "debug.h"
@@ -18,10 +24,12 @@
 #include "game_constants.h"
 #include "json.h"
 #include "map.h"
+#include "options.h"
 #include "output.h"
 #include "popup.h"
 #include "string_formatter.h"
 #include "submap.h"
+#include "thread_pool.h"
 #include "translations.h"
 #include "ui_manager.h"
 
@@ -30,6 +38,7 @@ static std::string find_quad_path( const std::string &dirname, const tripoint &o
     return string_format( "%s/%d.%d.%d.map", dirname, om_addr.x, om_addr.y, om_addr.z );
 }
 
+// Directory of the segment in the old layout, where each quad has its own file.
 static std::string find_dirname( const tripoint &om_addr )
 {
     const tripoint segment_addr = omt_to_seg_copy( om_addr );
@@ -37,6 +46,32 @@ static std::string find_dirname( const tripoint &om_addr )
                           segment_addr.y, segment_addr.z );
 }
 
+static std::string segment_archive_path( const tripoint &segment_addr )
+{
+    return string_format( "%s/maps/%d.%d.%d.seg", g->get_world_base_save_path(), segment_addr.x,
+                          segment_addr.y, segment_addr.z );
+}
+
+static std::string find_archive_path( const tripoint &om_addr )
+{
+    return segment_archive_path( omt_to_seg_copy( om_addr ) );
+}
+
+// Key of a quad in the writer queue.
+static std::string quad_key( const map_segment_archive &archive, const tripoint &om_addr )
+{
+    return string_format( "%s:%d.%d.%d", archive.path(), om_addr.x, om_addr.y, om_addr.z );
+}
+
+// Binary quad files start with this magic number, JSON ones always start with '['.
+static constexpr char binary_quad_magic[] = { 'C', 'B', 'N', 'Q' };
+static constexpr uint8_t binary_quad_format_version = 1;
+
+static bool use_binary_format()
+{
+    return get_option<std::string>( "MAP_SAVE_FORMAT" ) == "binary";
+}
+
 mapbuffer MAPBUFFER;
 
 mapbuffer::mapbuffer() = default;
@@ -48,12 +83,24 @@ mapbuffer::~mapbuffer()
 
 void mapbuffer::reset()
 {
+    // Files of the current world may be deleted or replaced right after this.
+    flush_writes();
+
     for( auto &elem : submaps ) {
         delete elem.second;
     }
     submaps.clear();
 }
 
+map_segment_archive &mapbuffer::get_archive( const std::string &path )
+{
+    std::unique_ptr<map_segment_archive> &archive = archives[path];
+    if( !archive ) {
+        archive = std::make_unique<map_segment_archive>( path );
+    }
+    return *archive;
+}
+
 bool mapbuffer::add_submap( const tripoint &p, submap *sm )
 {
     if( submaps.count( p ) != 0 ) {
@@ -100,8 +147,81 @@ submap *mapbuffer::lookup_submap( const tripoint &p )
     return iter->second;
 }
 
+void mapbuffer::prefetch( const tripoint &p )
+{
+    // At most this many quads are kept around waiting for their lookup.
+    static constexpr size_t max_prefetched = 512;
+
+    // Without a spare hardware thread the worker only takes time from the game thread.
+    if( std::thread::hardware_concurrency() < 2 ) {
+        return;
+    }
+    const tripoint om_addr = sm_to_omt_copy( p );
+    if( submaps.count( p ) != 0 || prefetched.count( om_addr ) != 0 ) {
+        return;
+    }
+    map_segment_archive &archive = get_archive( find_archive_path( om_addr ) );
+    if( quad_writer.pending( quad_key( archive, om_addr ) ) ) {
+        // Already in memory.
+        return;
+    }
+    if( !prefetch_pool ) {
+        prefetch_pool = std::make_unique<thread_pool>( 1 );
+    }
+    const std::string legacy_path = find_quad_path( find_dirname( om_addr ), om_addr );
+    prefetched[om_addr] = prefetch_pool->submit( [&archive, om_addr, legacy_path]() {
+        quad_submaps result;
+        if( cata::optional<std::string> stored = archive.read( om_addr ) ) {
+            std::istringstream fin( *stored );
+            result = deserialize_quad( fin, archive.path() );
+        } else {
+            read_from_file_optional( legacy_path, [&result, &legacy_path]( std::istream & fin ) {
+                result = deserialize_quad( fin, legacy_path );
+            } );
+        }
+        return result;
+    } );
+    prefetch_order.push_back( om_addr );
+    if( prefetch_order.size() > max_prefetched ) {
+        drop_prefetched( prefetch_order.front() );
+        prefetch_order.pop_front();
+    }
+}
+
+void mapbuffer::drop_prefetched( const tripoint &om_addr )
+{
+    const auto iter = prefetched.find( om_addr );
+    if( iter != prefetched.end() ) {
+        // The read must not outlive the archive it uses.
+        iter->second.wait();
+        prefetched.erase( iter );
+        report_deferred_debugmsgs();
+    }
+}
+
+void mapbuffer::flush_writes()
+{
+    quad_writer.flush();
+    report_write_errors();
+    // Reads still in progress use the archives.
+    while( !prefetch_order.empty() ) {
+        drop_prefetched( prefetch_order.front() );
+        prefetch_order.pop_front();
+    }
+    // Closes the archive files, some platforms can't delete them while they are open.
+    archives.clear();
+}
+
+void mapbuffer::report_write_errors()
+{
+    for( const std::string &err : quad_writer.take_errors() ) {
+        debugmsg( "Failed to write map data to %s", err );
+    }
+}
+
 void mapbuffer::save( bool delete_after_save )
 {
+    report_write_errors();
     assure_dir_exist( g->get_world_base_save_path() + "/maps" );
 
     int num_saved_submaps = 0;
@@ -115,6 +235,7 @@ void mapbuffer::save( bool delete_after_save )
 
     // A set of already-saved submaps, in global overmap coordinates.
     std::set<tripoint> saved_submaps;
+    std::set<std::string> saved_archives;
     std::list<tripoint> submaps_to_delete;
     static constexpr std::chrono::milliseconds update_interval( 500 );
     auto last_update = std::chrono::steady_clock::now();
@@ -139,17 +260,13 @@ void mapbuffer::save( bool delete_after_save )
             continue;
         }
         saved_submaps.insert( om_addr );
-
-        // A segment is a chunk of 32x32 submap quads.
-        // We're breaking them into subdirectories so there aren't too many files per directory.
-        // Might want to make a set for this one too so it's only checked once per save().
-        const std::string dirname = find_dirname( om_addr );
-        const std::string quad_path = find_quad_path( dirname, om_addr );
+        // A segment is a chunk of 32x32 submap quads, all of them are stored in one file.
+        saved_archives.insert( find_archive_path( om_addr ) );
 
         // delete_on_save deletes everything, otherwise delete submaps
         // outside the current map.
         const bool zlev_del = !map_has_zlevels && om_addr.z != g->get_levz();
-        save_quad( dirname, quad_path, om_addr, submaps_to_delete,
+        save_quad( om_addr, submaps_to_delete,
                    delete_after_save || zlev_del ||
                    om_addr.x < map_origin.x || om_addr.y < map_origin.y ||
                    om_addr.x > map_origin.x + HALF_MAPSIZE ||
@@ -159,12 +276,20 @@ void mapbuffer::save( bool delete_after_save )
     for( auto &elem : submaps_to_delete ) {
         remove_submap( elem );
     }
+    // Queued after the records, so the archive is compacted once they are written.
+    for( const std::string &path : saved_archives ) {
+        map_segment_archive &archive = get_archive( path );
+        if( archive.needs_compaction() ) {
+            quad_writer.write( path, std::string(), [&archive]( const std::string & ) {
+                archive.compact();
+            } );
+        }
+    }
 
     get_distribution_grid_tracker().on_saved();
 }
 
-void mapbuffer::save_quad( const std::string &dirname, const std::string &filename,
-                           const tripoint &om_addr, std::list<tripoint> &submaps_to_delete,
+void mapbuffer::save_quad( const tripoint &om_addr, std::list<tripoint> &submaps_to_delete,
                            bool delete_after_save )
 {
     std::vector<point> offsets;
@@ -203,44 +328,98 @@ void mapbuffer::save_quad( const std::string &dirname, const std::string &filena
         return;
     }
 
-    // Don't create the directory if it would be empty
-    assure_dir_exist( dirname );
-    write_to_file( filename, [&]( std::ostream & fout ) {
-        JsonOut jsout( fout );
-        jsout.start_array();
-        for( auto &submap_addr : submap_addrs ) {
-            if( submaps.count( submap_addr ) == 0 ) {
-                continue;
-            }
+    const bool changed = std::any_of( submap_addrs.begin(), submap_addrs.end(),
+    [this]( const tripoint & submap_addr ) {
+        const submap *sm = submaps[submap_addr];
+        return sm != nullptr && sm->needs_saving();
+    } );
+    if( changed ) {
+        // The file is written on the writer thread, everything else happens right here,
+        // so the submaps may be modified or deleted as soon as this returns.
+        std::ostringstream fout;
+        if( use_binary_format() ) {
+            serialize_binary( fout, submap_addrs );
+        } else {
+            JsonOut jsout( fout );
+            jsout.start_array();
+            for( auto &submap_addr : submap_addrs ) {
+                if( submaps.count( submap_addr ) == 0 ) {
+                    continue;
+                }
 
-            submap *sm = submaps[submap_addr];
+                submap *sm = submaps[submap_addr];
 
-            if( sm == nullptr ) {
-                continue;
-            }
+                if( sm == nullptr ) {
+                    continue;
+                }
 
-            jsout.start_object();
+                jsout.start_object();
 
-            jsout.member( "version", savegame_version );
-            jsout.member( "coordinates" );
+                jsout.member( "version", savegame_version );
+                jsout.member( "coordinates" );
 
-            jsout.start_array();
-            jsout.write( submap_addr.x );
-            jsout.write( submap_addr.y );
-            jsout.write( submap_addr.z );
-            jsout.end_array();
+                jsout.start_array();
+                jsout.write( submap_addr.x );
+                jsout.write( submap_addr.y );
+                jsout.write( submap_addr.z );
+                jsout.end_array();
+
+                sm->store( jsout );
+
+                jsout.end_object();
+            }
 
-            sm->store( jsout );
+            jsout.end_array();
+        }
 
-            jsout.end_object();
+        map_segment_archive &archive = get_archive( find_archive_path( om_addr ) );
+        const std::string legacy_path = find_quad_path( find_dirname( om_addr ), om_addr );
+        // Anything read ahead is outdated now.
+        drop_prefetched( om_addr );
+        quad_writer.write( quad_key( archive, om_addr ), fout.str(),
+        [&archive, om_addr, legacy_path]( const std::string & data ) {
+            archive.append( om_addr, data );
+            // The quad has been moved out of the old layout.
+            if( file_exist( legacy_path ) ) {
+                remove_file( legacy_path );
+            }
+        } );
+        for( auto &submap_addr : submap_addrs ) {
+            if( submaps[submap_addr] != nullptr ) {
+                submaps[submap_addr]->mark_saved();
+            }
+        }
+    }
 
-            if( delete_after_save ) {
+    if( delete_after_save ) {
+        for( auto &submap_addr : submap_addrs ) {
+            if( submaps.count( submap_addr ) > 0 && submaps[submap_addr] != nullptr ) {
                 submaps_to_delete.push_back( submap_addr );
             }
         }
+    }
+}
 
-        jsout.end_array();
-    } );
+void mapbuffer::serialize_binary( std::ostream &fout, const std::vector<tripoint> &submap_addrs )
+{
+    std::vector<std::pair<tripoint, const submap *>> to_write;
+    for( const tripoint &submap_addr : submap_addrs ) {
+        const auto iter = submaps.find( submap_addr );
+        if( iter != submaps.end() && iter->second != nullptr ) {
+            to_write.emplace_back( submap_addr, iter->second );
+        }
+    }
+
+    fout.write( binary_quad_magic, sizeof( binary_quad_magic ) );
+    binary_io::write<uint8_t>( fout, binary_quad_format_version );
+    binary_io::write<uint8_t>( fout, to_write.size() );
+    for( const std::pair<tripoint, const submap *> &elem : to_write ) {
+        binary_io::write<int32_t>( fout, savegame_version );
+        binary_io::write<int32_t>( fout, elem.first.x );
+        binary_io::write<int32_t>( fout, elem.first.y );
+        binary_io::write<int32_t>( fout, elem.first.z );
+        elem.second->store_binary( fout );
+    }
 }
 
 // We're reading in way too many entities here to mess around with creating sub-objects and
@@ -249,25 +428,66 @@ submap *mapbuffer::unserialize_submaps( const tripoint &p )
 {
     // Map the tripoint to the submap quad that stores it.
     const tripoint om_addr = sm_to_omt_copy( p );
-    const std::string dirname = find_dirname( om_addr );
-    std::string quad_path = find_quad_path( dirname, om_addr );
-
-    if( !file_exist( quad_path ) ) {
-        // Fix for old saves where the path was generated using std::stringstream, which
-        // did format the number using the current locale. That formatting may insert
-        // thousands separators, so the resulting path is "map/1,234.7.8.map" instead
-        // of "map/1234.7.8.map".
-        std::ostringstream buffer;
-        buffer << dirname << "/" << om_addr.x << "." << om_addr.y << "." << om_addr.z << ".map";
-        if( file_exist( buffer.str() ) ) {
-            quad_path = buffer.str();
+    map_segment_archive &archive = get_archive( find_archive_path( om_addr ) );
+    std::string quad_path = quad_key( archive, om_addr );
+    // Saved recently, but not written to disk yet.
+    std::shared_ptr<const std::string> data = quad_writer.pending( quad_path );
+    quad_submaps loaded;
+    const auto prefetch_iter = prefetched.find( om_addr );
+    if( prefetch_iter != prefetched.end() ) {
+        std::future<quad_submaps> fetched = std::move( prefetch_iter->second );
+        prefetched.erase( prefetch_iter );
+        std::exception_ptr failure;
+        try {
+            loaded = fetched.get();
+        } catch( ... ) {
+            failure = std::current_exception();
+        }
+        // Messages of the worker, e.g. about a quad file that could not be read.
+        report_deferred_debugmsgs();
+        if( data ) {
+            // The queued data is newer.
+            loaded.clear();
+        } else if( failure ) {
+            std::rethrow_exception( failure );
         }
     }
+    if( !loaded.empty() ) {
+        add_quad( loaded );
+    } else {
+        if( !data ) {
+            if( cata::optional<std::string> stored = archive.read( om_addr ) ) {
+                data = std::make_shared<const std::string>( std::move( *stored ) );
+            }
+        }
 
-    using namespace std::placeholders;
-    if( !read_from_file_optional_json( quad_path, std::bind( &mapbuffer::deserialize, this, _1 ) ) ) {
-        // If it doesn't exist, trigger generating it.
-        return nullptr;
+        if( data ) {
+            std::istringstream fin( *data );
+            quad_submaps quad = deserialize_quad( fin, quad_path );
+            add_quad( quad );
+        } else {
+            // Saves from before segment archives store each quad in its own file.
+            const std::string dirname = find_dirname( om_addr );
+            quad_path = find_quad_path( dirname, om_addr );
+            if( !file_exist( quad_path ) ) {
+                // Fix for old saves where the path was generated using std::stringstream, which
+                // did format the number using the current locale. That formatting may insert
+                // thousands separators, so the resulting path is "map/1,234.7.8.map" instead
+                // of "map/1234.7.8.map".
+                std::ostringstream buffer;
+                buffer << dirname << "/" << om_addr.x << "." << om_addr.y << "." << om_addr.z << ".map";
+                if( file_exist( buffer.str() ) ) {
+                    quad_path = buffer.str();
+                }
+            }
+            if( !read_from_file_optional( quad_path, [this, &quad_path]( std::istream & fin ) {
+            quad_submaps quad = deserialize_quad( fin, quad_path );
+            add_quad( quad );
+            } ) ) {
+                // If it doesn't exist, trigger generating it.
+                return nullptr;
+            }
+        }
     }
     if( submaps.count( p ) == 0 ) {
         debugmsg( "file %s did not contain the expected submap %d,%d,%d",
@@ -277,7 +497,28 @@ submap *mapbuffer::unserialize_submaps( const tripoint &p )
     return submaps[ p ];
 }
 
-void mapbuffer::deserialize( JsonIn &jsin )
+void mapbuffer::add_quad( quad_submaps &loaded )
+{
+    for( std::pair<tripoint, std::unique_ptr<submap>> &elem : loaded ) {
+        if( !add_submap( elem.first, elem.second ) ) {
+            debugmsg( "submap %d,%d,%d was already loaded", elem.first.x, elem.first.y, elem.first.z );
+        }
+    }
+}
+
+mapbuffer::quad_submaps mapbuffer::deserialize_quad( std::istream &fin, const std::string &path )
+{
+    quad_submaps loaded;
+    if( fin.peek() == binary_quad_magic[0] ) {
+        deserialize_binary( fin, loaded );
+    } else {
+        JsonIn jsin( fin, path );
+        deserialize( jsin, loaded );
+    }
+    return loaded;
+}
+
+void mapbuffer::deserialize( JsonIn &jsin, quad_submaps &loaded )
 {
     jsin.start_array();
     while( !jsin.end_array() ) {
@@ -298,10 +539,99 @@ void mapbuffer::deserialize( JsonIn &jsin )
                 sm->load( jsin, submap_member_name, version );
             }
         }
+        sm->mark_saved();
+        loaded.emplace_back( submap_coordinates, std::move( sm ) );
+    }
+}
+
+void mapbuffer::deserialize_binary( std::istream &fin, quad_submaps &loaded )
+{
+    char magic[sizeof( binary_quad_magic )];
+    if( !fin.read( magic, sizeof( magic ) ) ||
+        !std::equal( std::begin( magic ), std::end( magic ), std::begin( binary_quad_magic ) ) ) {
+        throw std::runtime_error( "not a binary map file" );
+    }
+    const uint8_t format_version = binary_io::read<uint8_t>( fin );
+    if( format_version != binary_quad_format_version ) {
+        throw std::runtime_error( string_format( "unsupported binary map format version %d",
+                                  format_version ) );
+    }
+    const uint8_t num_submaps = binary_io::read<uint8_t>( fin );
+    for( uint8_t i = 0; i < num_submaps; i++ ) {
+        const int version = binary_io::read<int32_t>( fin );
+        tripoint submap_coordinates;
+        submap_coordinates.x = binary_io::read<int32_t>( fin );
+        submap_coordinates.y = binary_io::read<int32_t>( fin );
+        submap_coordinates.z = binary_io::read<int32_t>( fin );
+        std::unique_ptr<submap> sm = std::make_unique<submap>();
+        sm->load_binary( fin, version );
+        sm->mark_saved();
+        loaded.emplace_back( submap_coordinates, std::move( sm ) );
+    }
+}
+
+int mapbuffer::convert_saved_quads()
+{
+    // Quads with queued writes would otherwise be converted from their outdated contents.
+    quad_writer.flush();
+    const bool to_binary = use_binary_format();
+    const std::string maps_dir = g->get_world_base_save_path() + "/maps";
+
+    std::set<tripoint> to_convert;
+    // Everything that is still in the old layout is moved into the archives.
+    for( const std::string &path : get_files_from_path( ".map", maps_dir, true, true ) ) {
+        const size_t name_start = path.find_last_of( '/' ) + 1;
+        tripoint om_addr;
+        if( std::sscanf( path.c_str() + name_start, "%d.%d.%d.map", &om_addr.x, &om_addr.y,
+                         &om_addr.z ) != 3 ) {
+            // Legacy name with locale-specific thousands separators, gets converted when loaded.
+            continue;
+        }
+        to_convert.insert( om_addr );
+    }
+    for( const std::string &path : get_files_from_path( ".seg", maps_dir, false, true ) ) {
+        const size_t name_start = path.find_last_of( '/' ) + 1;
+        tripoint segment_addr;
+        if( std::sscanf( path.c_str() + name_start, "%d.%d.%d.seg", &segment_addr.x, &segment_addr.y,
+                         &segment_addr.z ) != 3 ) {
+            continue;
+        }
+        // Same path as used by save, so there is only one instance per archive.
+        map_segment_archive &archive = get_archive( segment_archive_path( segment_addr ) );
+        for( const tripoint &om_addr : archive.quads() ) {
+            const cata::optional<std::string> data = archive.read( om_addr );
+            const bool is_binary = data && !data->empty() && ( *data )[0] == binary_quad_magic[0];
+            if( is_binary != to_binary ) {
+                to_convert.insert( om_addr );
+            }
+        }
+    }
 
-        if( !add_submap( submap_coordinates, sm ) ) {
-            debugmsg( "submap %d,%d,%d was already loaded", submap_coordinates.x, submap_coordinates.y,
-                      submap_coordinates.z );
+    int num_converted = 0;
+    for( const tripoint &om_addr : to_convert ) {
+        const tripoint sm_addr = omt_to_sm_copy( om_addr );
+        if( submaps.count( sm_addr ) != 0 || unserialize_submaps( sm_addr ) == nullptr ) {
+            continue;
+        }
+        for( const point &offset : { point_zero, point_south, point_east, point_south_east } ) {
+            const auto iter = submaps.find( sm_addr + offset );
+            if( iter != submaps.end() && iter->second != nullptr ) {
+                iter->second->set_modified();
+            }
+        }
+        std::list<tripoint> submaps_to_delete;
+        save_quad( om_addr, submaps_to_delete, true );
+        for( const tripoint &elem : submaps_to_delete ) {
+            remove_submap( elem );
+        }
+        // save_quad leaves null placeholders for members missing from the file.
+        for( const point &offset : { point_zero, point_south, point_east, point_south_east } ) {
+            const auto iter = submaps.find( sm_addr + offset );
+            if( iter != submaps.end() && iter->second == nullptr ) {
+                submaps.erase( iter );
+            }
         }
+        num_converted++;
     }
+    return num_converted;
 }
@@ -2,15 +2,23 @@
 #ifndef CATA_SRC_MAPBUFFER_H
 #define CATA_SRC_MAPBUFFER_H
 
+#include <deque>
+#include <future>
+#include <iosfwd>
 #include <list>
 #include <map>
 #include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
+#include "background_writer.h"
 #include "coordinates.h"
+#include "map_archive.h"
 #include "point.h"
 
 class submap;
+class thread_pool;
 class JsonIn;
 
 /**
@@ -23,14 +31,30 @@ class mapbuffer
         ~mapbuffer();
 
         /** Store all submaps in this instance into savefiles.
+         * Only quads containing a submap that @ref submap::needs_saving are serialized.
+         * Quads are appended to the archive of their segment on a background thread,
+         * until then @ref lookup_submap reads the queued data instead.
          * @param delete_after_save If true, the saved submaps are removed
          * from the mapbuffer (and deleted).
          **/
         void save( bool delete_after_save = false );
 
-        /** Delete all buffered submaps. **/
+        /** Delete all buffered submaps, after waiting for pending writes. **/
         void reset();
 
+        /** Wait until all quads queued by @ref save are on disk and close the archive files. **/
+        void flush_writes();
+
+        /**
+         * Move all quads of the current world that are still stored in their own file
+         * into the segment archives, and rewrite all quads that are not stored in the
+         * format selected by the MAP_SAVE_FORMAT world option.
+         * Quads that are currently loaded are skipped, the next @ref save writes them
+         * in the selected format anyway.
+         * @return The number of converted quads.
+         */
+        int convert_saved_quads();
+
         /** Add a new submap to the buffer.
          *
          * @param x, y, z The absolute world position in submap coordinates.
@@ -58,8 +82,18 @@ class mapbuffer
             return lookup_submap( p.raw() );
         }
 
+        /**
+         * Start loading the quad that contains the submap at @p p on a worker thread,
+         * so a later @ref lookup_submap only has to add the submaps to the buffer.
+         * Does nothing if the submap is loaded or being read already, or if there is
+         * no spare hardware thread to load it on.
+         */
+        void prefetch( const tripoint &p );
+
     private:
         using submap_map_t = std::map<tripoint, submap *>;
+        // Submaps loaded from one quad, not yet added to the buffer.
+        using quad_submaps = std::vector<std::pair<tripoint, std::unique_ptr<submap>>>;
 
     public:
         inline submap_map_t::iterator begin() {
@@ -77,12 +111,29 @@ class mapbuffer
         // There's a very good reason this is private,
         // if not handled carefully, this can erase in-use submaps and crash the game.
         void remove_submap( tripoint addr );
+        void report_write_errors();
         submap *unserialize_submaps( const tripoint &p );
-        void deserialize( JsonIn &jsin );
-        void save_quad( const std::string &dirname, const std::string &filename,
-                        const tripoint &om_addr, std::list<tripoint> &submaps_to_delete,
+        void add_quad( quad_submaps &loaded );
+        // These don't touch the buffer, so they can run on any thread.
+        static quad_submaps deserialize_quad( std::istream &fin, const std::string &path );
+        static void deserialize( JsonIn &jsin, quad_submaps &loaded );
+        static void deserialize_binary( std::istream &fin, quad_submaps &loaded );
+        void serialize_binary( std::ostream &fout, const std::vector<tripoint> &submap_addrs );
+        void save_quad( const tripoint &om_addr, std::list<tripoint> &submaps_to_delete,
                         bool delete_after_save );
+        map_segment_archive &get_archive( const std::string &path );
+        void drop_prefetched( const tripoint &om_addr );
         submap_map_t submaps;
+        // Segment archives by file path, kept until @ref reset so they can be used by the writer.
+        std::map<std::string, std::unique_ptr<map_segment_archive>> archives;
+        // Quads loaded by @ref prefetch, by overmap terrain coordinates. Empty if nothing is stored.
+        std::map<tripoint, std::future<quad_submaps>> prefetched;
+        // Same keys as above, oldest first, used to limit their number.
+        std::deque<tripoint> prefetch_order;
+        // Runs the loads of @ref prefetch, apart from the shared pool so they don't hold up
+        // the light and field jobs the game thread waits for. Created when first needed.
+        std::unique_ptr<thread_pool> prefetch_pool;
+        background_writer quad_writer;
 };
 
 extern mapbuffer MAPBUFFER;
@@ -6,6 +6,7 @@
 #include <cmath>
 #include <cstdlib>
 #include <functional>
+#include <future>
 #include <list>
 #include <map>
 #include <memory>
@@ -15,6 +16,7 @@
 
 #include "basecamp.h"
 #include "calendar.h"
+#include "cata_utility.h"
 #include "catacharset.h"
 #include "character_id.h"
 #include "clzones.h"
@@ -29,6 +31,7 @@
 #include "game.h"
 #include "game_constants.h"
 #include "generic_factory.h"
+#include "hash_utils.h"
 #include "input.h"
 #include "int_id.h"
 #include "item.h"
@@ -64,6 +67,7 @@
 #include "string_utils.h"
 #include "submap.h"
 #include "text_snippets.h"
+#include "thread_pool.h"
 #include "tileray.h"
 #include "translations.h"
 #include "trap.h"
@@ -105,6 +109,66 @@ static void science_room( map *m, point p1, point p2, int z, int rotate );
 // (x,y,z) are absolute coordinates of a submap
 // x%2 and y%2 must be 0!
 void map::generate( const tripoint &p, const time_point &when )
+{
+    const std::unique_ptr<mapgendata> dat = start_generating( p, when );
+    draw_map( *dat );
+    finish_generating( dat->terrain_type() );
+}
+
+void map::generate_quads( const std::vector<tripoint> &quads, const time_point &when )
+{
+    struct quad {
+        std::unique_ptr<tinymap> m;
+        std::unique_ptr<mapgendata> dat;
+        std::future<void> drawn;
+    };
+    std::vector<quad> jobs;
+    jobs.reserve( quads.size() );
+    // The workers draw into maps owned by the jobs, don't let them go away under them.
+    const auto wait_for_workers = [&jobs]() {
+        for( quad &q : jobs ) {
+            if( q.drawn.valid() ) {
+                q.drawn.wait();
+            }
+        }
+    };
+    on_out_of_scope wait_on_exit( wait_for_workers );
+
+    // Reading the overmap may create overmaps, so it's all done before any worker starts.
+    for( const tripoint &p : quads ) {
+        quad q;
+        q.m = std::make_unique<tinymap>();
+        q.dat = q.m->start_generating( p, when );
+        jobs.push_back( std::move( q ) );
+    }
+    if( jobs.size() > 1 ) {
+        for( quad &q : jobs ) {
+            if( !mapgen_is_thread_safe( q.dat->terrain_type()->get_mapgen_id() ) ) {
+                continue;
+            }
+            tinymap &m = *q.m;
+            mapgendata &dat = *q.dat;
+            m.drawing_detached = true;
+            q.drawn = get_thread_pool().submit( [&m, &dat]() {
+                m.draw_map_seeded( dat );
+            } );
+        }
+    }
+    // The rest of mapgen may change anything the workers read, so it only starts once they are done.
+    wait_for_workers();
+    report_deferred_debugmsgs();
+    for( quad &q : jobs ) {
+        if( q.drawn.valid() ) {
+            q.drawn.get();
+            q.m->drawing_detached = false;
+        } else {
+            q.m->draw_map( *q.dat );
+        }
+        q.m->finish_generating( q.dat->terrain_type() );
+    }
+}
+
+std::unique_ptr<mapgendata> map::start_generating( const tripoint &p, const time_point &when )
 {
     dbg( DL::Info ) << "map::generate( g[" << g.get() << "], p[" << p <<
                     "], when[" << to_string( when ) << "] )";
@@ -131,7 +195,6 @@ void map::generate( const tripoint &p, const time_point &when )
     // x, and y are submap coordinates, convert to overmap terrain coordinates
     // TODO: fix point types
     tripoint_abs_omt abs_omt( sm_to_omt_copy( p ) );
-    oter_id terrain_type = overmap_buffer.ter( abs_omt );
 
     // This attempts to scale density of zombies inversely with distance from the nearest city.
     // In other words, make city centers dense and perimeters sparse.
@@ -143,8 +206,26 @@ void map::generate( const tripoint &p, const time_point &when )
     }
     density = density / 100;
 
-    mapgendata dat( abs_omt, *this, density, when, nullptr );
+    return std::make_unique<mapgendata>( abs_omt, *this, density, when, nullptr );
+}
+
+void map::draw_map_seeded( mapgendata &dat )
+{
+    // A quad drawn on a worker comes out the same no matter which quads are drawn with it.
+    std::size_t seed = g->get_seed();
+    cata::hash_combine( seed, abs_sub.x );
+    cata::hash_combine( seed, abs_sub.y );
+    cata::hash_combine( seed, abs_sub.z );
+    rng_seed_scope seeded( static_cast<unsigned int>( seed ) );
     draw_map( dat );
+}
+
+void map::finish_generating( const oter_id &terrain_type )
+{
+    if( detached_rotation % 4 != 0 ) {
+        rotate_npcs_and_zones( detached_rotation % 4, false );
+    }
+    detached_rotation = 0;
 
     // At some point, we should add region information so we can grab the appropriate extras
     map_extras ex = region_settings_map["default"].region_extras[terrain_type->get_extras()];
@@ -198,7 +279,7 @@ void map::generate( const tripoint &p, const time_point &when )
         for( int j = 0; j < my_MAPSIZE; j++ ) {
             dbg( DL::Info ) << "map::generate: submap (" << i << "," << j << ")";
 
-            const tripoint pos( i, j, p.z );
+            const tripoint pos( i, j, abs_sub.z );
             if( i <= 1 && j <= 1 ) {
                 saven( pos );
             } else {
@@ -215,6 +296,17 @@ void mapgen_function_builtin::generate( mapgendata &mgd )
     ( *fptr )( mgd );
 }
 
+bool mapgen_function_builtin::is_thread_safe() const
+{
+    // These only draw terrain.
+    static const std::array<building_gen_pointer, 7> terrain_only = {{
+            mapgen_rock, mapgen_rock_partial, mapgen_open_air, mapgen_river_center,
+            mapgen_river_curved_not, mapgen_river_straight, mapgen_river_curved
+        }
+    };
+    return std::find( terrain_only.begin(), terrain_only.end(), fptr ) != terrain_only.end();
+}
+
 /////////////////////////////////////////////////////////////////////////////////
 /////////////////////////////////////////////////////////////////////////////////
 ///// mapgen_function class.
@@ -279,6 +371,18 @@ class mapgen_basic_container
                 mapgen_function_ptr.obj->check( key );
             }
         }
+        /** Whether @ref generate always runs a function that is @ref mapgen_function::is_thread_safe. */
+        bool is_thread_safe() const {
+            if( weights_.get_weight() < 1 ) {
+                return false;
+            }
+            for( const auto &mapgen_function_ptr : weights_ ) {
+                if( !mapgen_function_ptr.obj->is_thread_safe() ) {
+                    return false;
+                }
+            }
+            return true;
+        }
 };
 
 class mapgen_factory
@@ -350,6 +454,11 @@ class mapgen_factory
             }
             return iter->second.generate( dat, hardcoded_weight );
         }
+        /// @see mapgen_basic_container::is_thread_safe
+        bool is_thread_safe( const std::string &key ) const {
+            const auto iter = mapgens_.find( disable_mapgen ? "test" : key );
+            return iter != mapgens_.end() && iter->second.is_thread_safe();
+        }
 };
 
 static mapgen_factory oter_mapgen;
@@ -2548,11 +2657,39 @@ bool mapgen_function_json_base::setup_common( const JsonObject &jo )
     // Needs to be last as it affects other placed items
     objects.load_objects<jmapgen_faction>( jo, "faction_owner" );
     if( !mapgen_defer::defer ) {
+        lower();
         is_ready = true; // skip setup attempts from any additional pointers
     }
     return true;
 }
 
+void mapgen_function_json_base::lower()
+{
+    program.clear();
+    if( do_format ) {
+        for( int y = 0; y < mapgensize.y; y++ ) {
+            int x = 0;
+            while( x < mapgensize.x ) {
+                const ter_furn_id &tdata = format[calc_index( point( x, y ) )];
+                int length = 1;
+                while( x + length < mapgensize.x ) {
+                    const ter_furn_id &next = format[calc_index( point( x + length, y ) )];
+                    if( next.ter != tdata.ter || next.furn != tdata.furn ) {
+                        break;
+                    }
+                    length++;
+                }
+                program.add_run( point( x, y ), length, tdata.ter, tdata.furn );
+                x += length;
+            }
+        }
+    }
+    for( size_t i = 0; i < setmap_points.size(); i++ ) {
+        program.add_setmap( i );
+    }
+    objects.lower( program );
+}
+
 void mapgen_function_json::check( const std::string &oter_name ) const
 {
     check_common( oter_name );
@@ -2750,27 +2887,6 @@ bool jmapgen_setmap::has_vehicle_collision( mapgendata &dat, point offset ) cons
     return false;
 }
 
-void mapgen_function_json_base::formatted_set_incredibly_simple( map &m, point offset ) const
-{
-    for( int y = 0; y < mapgensize.y; y++ ) {
-        for( int x = 0; x < mapgensize.x; x++ ) {
-            point p( x, y );
-            const size_t index = calc_index( p );
-            const ter_furn_id &tdata = format[index];
-            const point map_pos = p + offset;
-            if( tdata.furn != f_null ) {
-                if( tdata.ter != t_null ) {
-                    m.set( map_pos, tdata.ter, tdata.furn );
-                } else {
-                    m.furn_set( map_pos, tdata.furn );
-                }
-            } else if( tdata.ter != t_null ) {
-                m.ter_set( map_pos, tdata.ter );
-            }
-        }
-    }
-}
-
 bool mapgen_function_json_base::has_vehicle_collision( mapgendata &dat, point offset ) const
 {
     if( do_format ) {
@@ -2823,14 +2939,7 @@ void mapgen_function_json::generate( mapgendata &md )
             m->rotate( ( -static_cast<int>( md.terrain_type()->get_dir() ) + 4 ) % 4 );
         }
     }
-    if( do_format ) {
-        formatted_set_incredibly_simple( *m, point_zero );
-    }
-    for( auto &elem : setmap_points ) {
-        elem.apply( md, point_zero );
-    }
-
-    objects.apply( md, point_zero );
+    program.apply( md, point_zero, setmap_points, objects );
 
     resolve_regional_terrain_and_furniture( md );
 
@@ -2841,20 +2950,17 @@ void mapgen_function_json::generate( mapgendata &md )
     }
 }
 
+bool mapgen_function_json::is_thread_safe() const
+{
+    return predecessor_mapgen == oter_str_id::NULL_ID() && program.is_thread_safe( setmap_points );
+}
+
 void mapgen_function_json_nested::nest( mapgendata &dat, point offset ) const
 {
     // TODO: Make rotation work for submaps, then pass this value into elem & objects apply.
     //int chosen_rotation = rotation.get() % 4;
 
-    if( do_format ) {
-        formatted_set_incredibly_simple( dat.m, offset );
-    }
-
-    for( auto &elem : setmap_points ) {
-        elem.apply( dat, offset );
-    }
-
-    objects.apply( dat, offset );
+    program.apply( dat, offset, setmap_points, objects );
 
     resolve_regional_terrain_and_furniture( dat );
 }
@@ -2911,6 +3017,190 @@ bool jmapgen_objects::has_vehicle_collision( mapgendata &dat, point offset ) con
     return false;
 }
 
+void jmapgen_objects::lower( jmapgen_program &program ) const
+{
+    for( size_t i = 0; i < objects.size(); i++ ) {
+        program.add_object( i, objects[i].first, *objects[i].second );
+    }
+}
+
+void jmapgen_objects::apply_object( size_t index, mapgendata &dat, point offset ) const
+{
+    const jmapgen_obj &obj = objects[index];
+    jmapgen_place where = obj.first;
+    where.offset( -offset );
+    // The user will only specify repeat once in JSON, but it may get loaded both
+    // into the what and where in some cases--we just need the greater value of the two.
+    const int repeat = std::max( where.repeat.get(), obj.second->repeat.get() );
+    for( int i = 0; i < repeat; i++ ) {
+        obj.second->apply( dat, where.x, where.y );
+    }
+}
+
+void jmapgen_program::clear()
+{
+    instructions.clear();
+}
+
+void jmapgen_program::add_run( point start, int length, ter_id ter, furn_id furn )
+{
+    instruction ins;
+    if( furn != f_null ) {
+        ins.op = ter != t_null ? opcode::ter_furn_run : opcode::furn_run;
+    } else if( ter != t_null ) {
+        ins.op = opcode::ter_run;
+    } else {
+        return;
+    }
+    ins.pos = start;
+    ins.count = length;
+    ins.ter = ter;
+    ins.furn = furn;
+    instructions.push_back( ins );
+}
+
+void jmapgen_program::add_setmap( size_t index )
+{
+    instruction ins;
+    ins.op = opcode::setmap;
+    ins.index = index;
+    instructions.push_back( ins );
+}
+
+void jmapgen_program::add_object( size_t index, const jmapgen_place &where,
+                                  const jmapgen_piece &what )
+{
+    instruction ins;
+    // Only placements that don't roll anything can skip the piece, so the rng is
+    // called exactly as often as before.
+    const bool fixed = where.x.val == where.x.valmax && where.y.val == where.y.valmax &&
+                       where.repeat.val == where.repeat.valmax && what.repeat.val == what.repeat.valmax;
+    if( fixed ) {
+        ins.pos = point( where.x.val, where.y.val );
+        ins.count = std::max( where.repeat.val, what.repeat.val );
+        if( const jmapgen_terrain *ter = dynamic_cast<const jmapgen_terrain *>( &what ) ) {
+            ins.op = opcode::place_ter;
+            ins.ter = ter->id;
+            instructions.push_back( ins );
+            return;
+        }
+        if( const jmapgen_furniture *furn = dynamic_cast<const jmapgen_furniture *>( &what ) ) {
+            ins.op = opcode::place_furn;
+            ins.furn = furn->id;
+            instructions.push_back( ins );
+            return;
+        }
+    }
+    ins.op = opcode::piece;
+    ins.index = index;
+    instructions.push_back( ins );
+}
+
+// Active furniture is tracked by the distribution grids, which aren't thread safe.
+static bool is_inactive_furniture( const furn_id &furn )
+{
+    return !furn.obj().active;
+}
+
+static bool is_thread_safe( const jmapgen_setmap &setmap )
+{
+    switch( setmap.op ) {
+        case JMAPGEN_SETMAP_TER:
+        case JMAPGEN_SETMAP_LINE_TER:
+        case JMAPGEN_SETMAP_SQUARE_TER:
+        case JMAPGEN_SETMAP_RADIATION:
+        case JMAPGEN_SETMAP_LINE_RADIATION:
+        case JMAPGEN_SETMAP_SQUARE_RADIATION:
+            return true;
+        case JMAPGEN_SETMAP_FURN:
+        case JMAPGEN_SETMAP_LINE_FURN:
+        case JMAPGEN_SETMAP_SQUARE_FURN:
+            for( int id = setmap.val.val; id <= setmap.val.valmax; id++ ) {
+                if( !is_inactive_furniture( furn_id( id ) ) ) {
+                    return false;
+                }
+            }
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool jmapgen_program::is_thread_safe( const std::vector<jmapgen_setmap> &setmaps ) const
+{
+    for( const instruction &ins : instructions ) {
+        switch( ins.op ) {
+            case opcode::ter_run:
+            case opcode::place_ter:
+                break;
+            case opcode::ter_furn_run:
+            case opcode::furn_run:
+            case opcode::place_furn:
+                if( !is_inactive_furniture( ins.furn ) ) {
+                    return false;
+                }
+                break;
+            case opcode::setmap:
+                if( !::is_thread_safe( setmaps[ins.index] ) ) {
+                    return false;
+                }
+                break;
+            case opcode::piece:
+                return false;
+        }
+    }
+    return true;
+}
+
+void jmapgen_program::apply( mapgendata &dat, point offset,
+                             const std::vector<jmapgen_setmap> &setmaps, const jmapgen_objects &objects ) const
+{
+    map &m = dat.m;
+    for( const instruction &ins : instructions ) {
+        const point p = ins.pos + offset;
+        switch( ins.op ) {
+            case opcode::ter_furn_run:
+                for( int i = 0; i < ins.count; i++ ) {
+                    m.set( p + point( i, 0 ), ins.ter, ins.furn );
+                }
+                break;
+            case opcode::ter_run:
+                for( int i = 0; i < ins.count; i++ ) {
+                    m.ter_set( p + point( i, 0 ), ins.ter );
+                }
+                break;
+            case opcode::furn_run:
+                for( int i = 0; i < ins.count; i++ ) {
+                    m.furn_set( p + point( i, 0 ), ins.furn );
+                }
+                break;
+            case opcode::place_ter:
+                // Same as jmapgen_terrain::apply
+                for( int i = 0; i < ins.count; i++ ) {
+                    m.ter_set( p, ins.ter );
+                    if( m.has_flag_ter( "WALL", p ) ) {
+                        m.furn_set( p, f_null );
+                        if( !m.has_flag_ter( "PLACE_ITEM", p ) ) {
+                            m.i_clear( tripoint( p, m.get_abs_sub().z ) );
+                        }
+                    }
+                }
+                break;
+            case opcode::place_furn:
+                for( int i = 0; i < ins.count; i++ ) {
+                    m.furn_set( p, ins.furn );
+                }
+                break;
+            case opcode::setmap:
+                setmaps[ins.index].apply( dat, offset );
+                break;
+            case opcode::piece:
+                objects.apply_object( ins.index, dat, offset );
+                break;
+        }
+    }
+}
+
 /////////////
 void map::draw_map( mapgendata &dat )
 {
@@ -5841,6 +6131,51 @@ void map::rotate( int turns, const bool setpos_safe )
         return;
     }
 
+    if( drawing_detached ) {
+        detached_rotation += turns;
+    } else {
+        rotate_npcs_and_zones( turns, setpos_safe );
+    }
+
+    clear_vehicle_cache( );
+    clear_vehicle_list( abs_sub.z );
+
+    // Move the submaps around.
+    if( turns == 2 ) {
+        std::swap( *get_submap_at_grid( point_zero ), *get_submap_at_grid( point_south_east ) );
+        std::swap( *get_submap_at_grid( point_east ), *get_submap_at_grid( point_south ) );
+    } else {
+        point p;
+        submap tmp;
+
+        std::swap( *get_submap_at_grid( point_south_east - p ), tmp );
+
+        for( int k = 0; k < 4; ++k ) {
+            p = p.rotate( turns, { 2, 2 } );
+            std::swap( *get_submap_at_grid( point_south_east - p ), tmp );
+        }
+    }
+
+    // Then rotate them and recalculate vehicle positions.
+    for( int j = 0; j < 2; ++j ) {
+        for( int i = 0; i < 2; ++i ) {
+            point p( i, j );
+            auto sm = get_submap_at_grid( p );
+
+            sm->rotate( turns );
+
+            for( auto &veh : sm->vehicles ) {
+                veh->sm_pos = tripoint( p, abs_sub.z );
+            }
+
+            update_vehicle_list( sm, abs_sub.z );
+        }
+    }
+    reset_vehicle_cache( );
+}
+
+void map::rotate_npcs_and_zones( int turns, const bool setpos_safe )
+{
     real_coords rc;
     const tripoint &abs_sub = get_abs_sub();
     rc.fromabs( point( abs_sub.x * SEEX, abs_sub.y * SEEY ) );
@@ -5892,42 +6227,6 @@ void map::rotate( int turns, const bool setpos_safe )
         }
     }
 
-    clear_vehicle_cache( );
-    clear_vehicle_list( abs_sub.z );
-
-    // Move the submaps around.
-    if( turns == 2 ) {
-        std::swap( *get_submap_at_grid( point_zero ), *get_submap_at_grid( point_south_east ) );
-        std::swap( *get_submap_at_grid( point_east ), *get_submap_at_grid( point_south ) );
-    } else {
-        point p;
-        submap tmp;
-
-        std::swap( *get_submap_at_grid( point_south_east - p ), tmp );
-
-        for( int k = 0; k < 4; ++k ) {
-            p = p.rotate( turns, { 2, 2 } );
-            std::swap( *get_submap_at_grid( point_south_east - p ), tmp );
-        }
-    }
-
-    // Then rotate them and recalculate vehicle positions.
-    for( int j = 0; j < 2; ++j ) {
-        for( int i = 0; i < 2; ++i ) {
-            point p( i, j );
-            auto sm = get_submap_at_grid( p );
-
-            sm->rotate( turns );
-
-            for( auto &veh : sm->vehicles ) {
-                veh->sm_pos = tripoint( p, abs_sub.z );
-            }
-
-            update_vehicle_list( sm, abs_sub.z );
-        }
-    }
-    reset_vehicle_cache( );
-
     // rotate zones
     zone_manager &mgr = zone_manager::get_manager();
     mgr.rotate_zones( *this, turns );
@@ -6726,6 +7025,11 @@ bool run_mapgen_func( const std::string &mapgen_id, mapgendata &dat )
     return oter_mapgen.generate( dat, mapgen_id );
 }
 
+bool mapgen_is_thread_safe( const std::string &mapgen_id )
+{
+    return oter_mapgen.is_thread_safe( mapgen_id );
+}
+
 int register_mapgen_function( const std::string &key )
 {
     if( const auto ptr = get_mapgen_cfunction( key ) ) {
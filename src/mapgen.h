@@ -20,6 +20,7 @@ class JsonObject;
 class map;
 class mapgendata;
 class mission;
+struct jmapgen_objects;
 struct json_source_location;
 template <typename T> struct weighted_int_list;
 
@@ -40,6 +41,10 @@ class mapgen_function
         virtual void setup() { } // throws
         virtual void check( const std::string & /*oter_name*/ ) const { }
         virtual void generate( mapgendata & ) = 0;
+        /** Whether @ref generate only changes the map it draws on, so it can run on a worker thread. */
+        virtual bool is_thread_safe() const {
+            return false;
+        }
 };
 
 /////////////////////////////////////////////////////////////////////////////////
@@ -52,6 +57,7 @@ class mapgen_function_builtin : public virtual mapgen_function
             fptr( ptr ) {
         }
         void generate( mapgendata &mgd ) override;
+        bool is_thread_safe() const override;
 };
 
 /////////////////////////////////////////////////////////////////////////////////
@@ -179,6 +185,53 @@ class jmapgen_place
         jmapgen_int repeat;
 };
 
+/**
+ * A json mapgen lowered into a flat list of instructions once it is set up.
+ * The rows of the format become runs of resolved terrain / furniture, and terrain and
+ * furniture placements at a fixed position with a fixed repeat are done directly.
+ * Every other setmap and piece (random positions or repeats, items, monsters, vehicles,
+ * nested mapgen...) is still applied through its @ref jmapgen_setmap or @ref jmapgen_piece,
+ * referred to by its index in the mapgen it was made from.
+ */
+class jmapgen_program
+{
+    public:
+        void clear();
+        /** Set @p length tiles from @p start eastwards, like the format does. */
+        void add_run( point start, int length, ter_id ter, furn_id furn );
+        void add_setmap( size_t index );
+        /** @p index is the index of the object in its @ref jmapgen_objects. */
+        void add_object( size_t index, const jmapgen_place &where, const jmapgen_piece &what );
+
+        /** @p setmaps and @p objects must be the ones the program was made from. */
+        void apply( mapgendata &dat, point offset, const std::vector<jmapgen_setmap> &setmaps,
+                    const jmapgen_objects &objects ) const;
+        /** Whether @ref apply only sets terrain, inactive furniture and radiation. */
+        bool is_thread_safe( const std::vector<jmapgen_setmap> &setmaps ) const;
+
+    private:
+        enum class opcode : int {
+            ter_furn_run,
+            ter_run,
+            furn_run,
+            place_ter,
+            place_furn,
+            setmap,
+            piece,
+        };
+        struct instruction {
+            opcode op;
+            point pos;
+            /** Tiles of a run, or times to repeat a placement. */
+            int count = 1;
+            ter_id ter;
+            furn_id furn;
+            /** Index of the setmap or object. */
+            size_t index = 0;
+        };
+        std::vector<instruction> instructions;
+};
+
 using palette_id = std::string;
 
 // Strong typedef for strings used as map/palette keys
@@ -290,6 +343,10 @@ struct jmapgen_objects {
 
         void apply( mapgendata &dat ) const;
         void apply( mapgendata &dat, point offset ) const;
+        /** Appends the objects to @p program, in the order @ref apply would place them. */
+        void lower( jmapgen_program &program ) const;
+        /** Applies only the object at @p index, as @ref apply would. */
+        void apply_object( size_t index, mapgendata &dat, point offset ) const;
 
         /**
          * checks if applying these objects to data would cause cause a collision with vehicles
@@ -331,7 +388,8 @@ class mapgen_function_json_base
 
         void check_common( const std::string &oter_name ) const;
 
-        void formatted_set_incredibly_simple( map &m, point offset ) const;
+        /** Fills @ref program from the format, the setmaps and the objects. */
+        void lower();
 
         bool do_format;
         bool is_ready;
@@ -343,6 +401,7 @@ class mapgen_function_json_base
         std::vector<jmapgen_setmap> setmap_points;
 
         jmapgen_objects objects;
+        jmapgen_program program;
 };
 
 class mapgen_function_json : public mapgen_function_json_base, public virtual mapgen_function
@@ -351,6 +410,7 @@ class mapgen_function_json : public mapgen_function_json_base, public virtual ma
         void setup() override;
         void check( const std::string &oter_name ) const override;
         void generate( mapgendata & ) override;
+        bool is_thread_safe() const override;
         mapgen_function_json( const json_source_location &jsrcloc, int w, point grid_offset,
                               point grid_total );
         ~mapgen_function_json() override = default;
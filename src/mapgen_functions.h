@@ -88,6 +88,8 @@ bool run_mapgen_update_func( const std::string &update_mapgen_id, const tripoint
 bool run_mapgen_update_func( const std::string &update_mapgen_id, mapgendata &dat,
                              bool cancel_on_collision = true );
 bool run_mapgen_func( const std::string &mapgen_id, mapgendata &dat );
+/** Whether @ref run_mapgen_func for @p mapgen_id only changes the map, see @ref mapgen_function::is_thread_safe. */
+bool mapgen_is_thread_safe( const std::string &mapgen_id );
 std::pair<std::map<ter_id, int>, std::map<furn_id, int>> get_changed_ids_from_update(
             const std::string &update_mapgen_id );
 
@@ -10,7 +10,9 @@
 #include <list>
 #include <memory>
 #include <ostream>
+#include <set>
 #include <unordered_map>
+#include <utility>
 
 #include "avatar.h"
 #include "behavior.h"
@@ -21,6 +23,7 @@
 #include "effect.h"
 #include "field.h"
 #include "field_type.h"
+#include "flow_field.h"
 #include "game.h"
 #include "game_constants.h"
 #include "int_id.h"
@@ -34,6 +37,7 @@
 #include "monster_oracle.h"
 #include "mtype.h"
 #include "npc.h"
+#include "optional.h"
 #include "pathfinding.h"
 #include "pimpl.h"
 #include "player.h"
@@ -866,7 +870,19 @@ void monster::move()
             if( pf_settings.max_dist >= rl_dist( pos(), goal ) &&
                 ( path.empty() || rl_dist( pos(), path.front() ) >= 2 || path.back() != goal ) ) {
                 // We need a new path
-                path = g->m.route( pos(), goal, pf_settings, get_path_avoid() );
+                const std::set<tripoint> path_avoid = get_path_avoid();
+                // Monsters chasing the same target share the routes to it instead of each searching.
+                const flow_field *field = path_avoid.empty() && goal.z == posz() ?
+                                          here.get_flow_field( goal, pf_settings ) : nullptr;
+                cata::optional<std::vector<tripoint>> shared;
+                if( field != nullptr ) {
+                    shared = field->route_from( here, pos() );
+                }
+                if( shared ) {
+                    path = std::move( *shared );
+                } else {
+                    path = g->m.route( pos(), goal, pf_settings, path_avoid );
+                }
             }
 
             // Try to respect old paths, even if we can't pathfind at the moment
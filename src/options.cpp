@@ -2357,6 +2357,17 @@ void options_manager::add_options_world_default()
          true
        );
 
+    add( "MAP_SAVE_FORMAT", "world_default", translate_marker( "Map save format" ),
+         translate_marker( "Format of saved map files.  Binary files are smaller and load faster, JSON files are human-readable.  Files in either format can always be loaded, use the debug menu to convert existing files." ),
+    { { "json", translate_marker( "JSON" ) }, { "binary", translate_marker( "Binary" ) } },
+    "json"
+       );
+
+    add( "BUFFERED_FIELD_SPREAD", "world_default", translate_marker( "Buffered gas spreading" ),
+         translate_marker( "If true, gas spreads based on the fields at the start of each turn, and the fields of every submap use their own random numbers.  The results don't depend on the order the map is processed in, at the cost of some memory and time for copying the fields." ),
+         false
+       );
+
     add_empty_line();
 
     add( "CHARACTER_POINT_POOLS", "world_default", translate_marker( "Character point pools" ),
@@ -12,10 +12,12 @@
 #include <numeric>
 #include <ostream>
 #include <set>
+#include <sstream>
 #include <unordered_set>
 #include <vector>
 
 #include "assign.h"
+#include "background_writer.h"
 #include "basecamp.h"
 #include "cata_utility.h"
 #include "catacharset.h"
@@ -26,6 +28,7 @@
 #include "fstream_utils.h"
 #include "game.h"
 #include "generic_factory.h"
+#include "hash_utils.h"
 #include "json.h"
 #include "line.h"
 #include "map.h"
@@ -1166,6 +1169,41 @@ void overmap::populate( overmap_special_batch &enabled_specials )
 }
 
 void overmap::populate()
+{
+    overmap_special_batch enabled_specials = get_enabled_specials();
+    populate( enabled_specials );
+}
+
+bool overmap::generate_detached( const overmap *north, const overmap *east,
+                                 const overmap *south, const overmap *west,
+                                 overmap_special_batch &enabled_specials )
+{
+    detached = true;
+    lay_out( north, east, south, west, enabled_specials );
+    detached = false;
+    return !needs_adjacent_specials;
+}
+
+void overmap::copy_borders( overmap &to ) const
+{
+    to.connections_out = connections_out;
+    for( int i = 0; i < OMAPX; i++ ) {
+        for( const tripoint_om_omt &p : {
+                 tripoint_om_omt( i, 0, 0 ), tripoint_om_omt( i, OMAPY - 1, 0 )
+             } ) {
+            to.ter_set( p, ter( p ) );
+        }
+    }
+    for( int i = 0; i < OMAPY; i++ ) {
+        for( const tripoint_om_omt &p : {
+                 tripoint_om_omt( 0, i, 0 ), tripoint_om_omt( OMAPX - 1, i, 0 )
+             } ) {
+            to.ter_set( p, ter( p ) );
+        }
+    }
+}
+
+overmap_special_batch overmap::get_enabled_specials() const
 {
     overmap_special_batch enabled_specials = overmap_specials::get_default_batch( loc );
     overmap_feature_flag_settings &overmap_feature_flag = settings->overmap_feature_flag;
@@ -1210,7 +1248,7 @@ void overmap::populate()
         }
     }
 
-    populate( enabled_specials );
+    return enabled_specials;
 }
 
 oter_id overmap::get_default_terrain( int z ) const
@@ -1226,8 +1264,16 @@ oter_id overmap::get_default_terrain( int z ) const
     }
 }
 
+bool overmap::is_default_terrain( const oter_id &id ) const
+{
+    return id == get_default_terrain( -1 ) || id == get_default_terrain( 0 ) ||
+           id == get_default_terrain( 1 );
+}
+
 void overmap::init_layers()
 {
+    terrain_index.clear();
+    terrain_index_built = false;
     for( int k = 0; k < OVERMAP_LAYERS; ++k ) {
         const oter_id tid = get_default_terrain( k - OVERMAP_DEPTH );
 
@@ -1243,12 +1289,27 @@ void overmap::init_layers()
 
 void overmap::ter_set( const tripoint_om_omt &p, const oter_id &id )
 {
+    modified = true;
     if( !inbounds( p ) ) {
         /// TODO: Add a debug message reporting this, but currently there are way too many place that would trigger it.
         return;
     }
 
-    layer[p.z() + OVERMAP_DEPTH].terrain[p.x()][p.y()] = id;
+    oter_id &current = layer[p.z() + OVERMAP_DEPTH].terrain[p.x()][p.y()];
+    if( terrain_index_built && current != id ) {
+        if( !is_default_terrain( current ) ) {
+            std::vector<tripoint_om_omt> &locations = terrain_index[current];
+            auto iter = std::find( locations.begin(), locations.end(), p );
+            if( iter != locations.end() ) {
+                *iter = locations.back();
+                locations.pop_back();
+            }
+        }
+        if( !is_default_terrain( id ) ) {
+            terrain_index[id].push_back( p );
+        }
+    }
+    current = id;
 }
 
 const oter_id &overmap::ter( const tripoint_om_omt &p ) const
@@ -1261,13 +1322,37 @@ const oter_id &overmap::ter( const tripoint_om_omt &p ) const
     return layer[p.z() + OVERMAP_DEPTH].terrain[p.x()][p.y()];
 }
 
-bool &overmap::seen( const tripoint_om_omt &p )
+const std::vector<tripoint_om_omt> *overmap::terrain_locations( const oter_id &id ) const
 {
-    if( !inbounds( p ) ) {
-        nullbool = false;
-        return nullbool;
+    if( is_default_terrain( id ) ) {
+        return nullptr;
+    }
+    if( !terrain_index_built ) {
+        terrain_index.clear();
+        for( int z = -OVERMAP_DEPTH; z <= OVERMAP_HEIGHT; z++ ) {
+            const map_layer &cur_layer = layer[z + OVERMAP_DEPTH];
+            for( int x = 0; x < OMAPX; x++ ) {
+                for( int y = 0; y < OMAPY; y++ ) {
+                    const oter_id &t = cur_layer.terrain[x][y];
+                    if( !is_default_terrain( t ) ) {
+                        terrain_index[t].emplace_back( x, y, z );
+                    }
+                }
+            }
+        }
+        terrain_index_built = true;
+    }
+    static const std::vector<tripoint_om_omt> none;
+    const auto iter = terrain_index.find( id );
+    return iter == terrain_index.end() ? &none : &iter->second;
+}
+
+void overmap::set_seen( const tripoint_om_omt &p, const bool seen )
+{
+    if( inbounds( p ) && layer[p.z() + OVERMAP_DEPTH].visible[p.x()][p.y()] != seen ) {
+        layer[p.z() + OVERMAP_DEPTH].visible[p.x()][p.y()] = seen;
+        modified = true;
     }
-    return layer[p.z() + OVERMAP_DEPTH].visible[p.x()][p.y()];
 }
 
 bool overmap::seen( const tripoint_om_omt &p ) const
@@ -1278,13 +1363,12 @@ bool overmap::seen( const tripoint_om_omt &p ) const
     return layer[p.z() + OVERMAP_DEPTH].visible[p.x()][p.y()];
 }
 
-bool &overmap::explored( const tripoint_om_omt &p )
+void overmap::set_explored( const tripoint_om_omt &p, const bool explored )
 {
-    if( !inbounds( p ) ) {
-        nullbool = false;
-        return nullbool;
+    if( inbounds( p ) && layer[p.z() + OVERMAP_DEPTH].explored[p.x()][p.y()] != explored ) {
+        layer[p.z() + OVERMAP_DEPTH].explored[p.x()][p.y()] = explored;
+        modified = true;
     }
-    return layer[p.z() + OVERMAP_DEPTH].explored[p.x()][p.y()];
 }
 
 bool overmap::is_explored( const tripoint_om_omt &p ) const
@@ -1324,6 +1408,7 @@ bool overmap::monster_check( const std::pair<tripoint_om_sm, monster> &candidate
 
 void overmap::insert_npc( shared_ptr_fast<npc> who )
 {
+    modified = true;
     npcs.push_back( who );
     g->set_npcs_dirty();
 }
@@ -1339,6 +1424,7 @@ shared_ptr_fast<npc> overmap::erase_npc( const character_id &id )
     }
     auto ptr = *iter;
     npcs.erase( iter );
+    modified = true;
     g->set_npcs_dirty();
     return ptr;
 }
@@ -1437,6 +1523,7 @@ const std::string &overmap::note( const tripoint_om_omt &p ) const
 
 void overmap::add_note( const tripoint_om_omt &p, std::string message )
 {
+    modified = true;
     if( p.z() < -OVERMAP_DEPTH || p.z() > OVERMAP_HEIGHT ) {
         debugmsg( "Attempting to add not to overmap for blank layer %d", p.z() );
         return;
@@ -1458,6 +1545,7 @@ void overmap::add_note( const tripoint_om_omt &p, std::string message )
 
 void overmap::mark_note_dangerous( const tripoint_om_omt &p, int radius, bool is_dangerous )
 {
+    modified = true;
     for( auto &i : layer[p.z() + OVERMAP_DEPTH].notes ) {
         if( p.xy() == i.p ) {
             i.dangerous = is_dangerous;
@@ -1469,6 +1557,7 @@ void overmap::mark_note_dangerous( const tripoint_om_omt &p, int radius, bool is
 
 void overmap::delete_note( const tripoint_om_omt &p )
 {
+    modified = true;
     add_note( p, std::string{} );
 }
 
@@ -1517,6 +1606,7 @@ const string_id<map_extra> &overmap::extra( const tripoint_om_omt &p ) const
 
 void overmap::add_extra( const tripoint_om_omt &p, const string_id<map_extra> &id )
 {
+    modified = true;
     if( p.z() < -OVERMAP_DEPTH || p.z() > OVERMAP_HEIGHT ) {
         debugmsg( "Attempting to add not to overmap for blank layer %d", p.z() );
         return;
@@ -1539,6 +1629,7 @@ void overmap::add_extra( const tripoint_om_omt &p, const string_id<map_extra> &i
 
 void overmap::delete_extra( const tripoint_om_omt &p )
 {
+    modified = true;
     add_extra( p, string_id<map_extra>::NULL_ID() );
 }
 
@@ -1580,6 +1671,7 @@ const scent_trace &overmap::scent_at( const tripoint_abs_omt &loc ) const
 
 void overmap::set_scent( const tripoint_abs_omt &loc, const scent_trace &new_scent )
 {
+    modified = true;
     // TODO: increase strength of scent trace when applied repeatedly in a short timespan.
     scents[loc] = new_scent;
 }
@@ -1615,7 +1707,7 @@ static void fixup_labs( overmap &om )
     }
 
     if( !has_endgame ) {
-        debugmsg( _( "No endgame lab was generated." ) );
+        debugmsg( "No endgame lab was generated." );
     }
 }
 
@@ -1629,6 +1721,33 @@ void overmap::generate( const overmap *north, const overmap *east,
     }
 
     dbg( DL::Info ) << "overmap::generate start";
+    lay_out( north, east, south, west, enabled_specials );
+    finish_generating();
+    dbg( DL::Info ) << "overmap::generate done";
+}
+
+unsigned int overmap::generation_seed( int step ) const
+{
+    std::size_t seed = g->get_seed();
+    cata::hash_combine( seed, loc.x() );
+    cata::hash_combine( seed, loc.y() );
+    cata::hash_combine( seed, step );
+    return static_cast<unsigned int>( seed );
+}
+
+void overmap::finish_generating()
+{
+    rng_seed_scope seeded( generation_seed( 1 ) );
+    place_radios();
+}
+
+void overmap::lay_out( const overmap *north, const overmap *east,
+                       const overmap *south, const overmap *west,
+                       overmap_special_batch &enabled_specials )
+{
+    // Each overmap draws from its own engine, so what it looks like doesn't depend on
+    // what was generated before it, or on the thread generating it.
+    rng_seed_scope seeded( generation_seed( 0 ) );
 
     clear_labs();
 
@@ -1676,8 +1795,6 @@ void overmap::generate( const overmap *north, const overmap *east,
 
     // Place the monsters, now that the terrain is laid out
     place_mongroups();
-    place_radios();
-    dbg( DL::Info ) << "overmap::generate done";
 }
 
 bool overmap::generate_sub( const int z )
@@ -2125,6 +2242,7 @@ const
 
 void overmap::process_mongroups()
 {
+    modified = true;
     for( auto it = zg.begin(); it != zg.end(); ) {
         mongroup &mg = it->second;
         if( mg.dying ) {
@@ -2141,29 +2259,35 @@ void overmap::process_mongroups()
 
 void overmap::clear_mon_groups()
 {
+    modified = true;
     zg.clear();
 }
 
 void overmap::clear_overmap_special_placements()
 {
+    modified = true;
     overmap_special_placements.clear();
 }
 void overmap::clear_cities()
 {
+    modified = true;
     cities.clear();
 }
 void overmap::clear_labs()
 {
+    modified = true;
     labs.clear();
 }
 void overmap::clear_connections_out()
 {
+    modified = true;
     connections_out.clear();
 }
 
 void overmap::place_special_forced( const overmap_special_id &special_id, const tripoint_om_omt &p,
                                     om_direction::type dir )
 {
+    modified = true;
     static city invalid_city;
     place_special( *special_id, p, dir, invalid_city, false, true );
 }
@@ -2202,6 +2326,7 @@ void mongroup::wander( const overmap &om )
 
 void overmap::move_hordes()
 {
+    modified = true;
     // Prevent hordes to be moved twice by putting them in here after moving.
     decltype( zg ) tmpzg;
     //MOVE ZOMBIE GROUPS
@@ -2343,6 +2468,7 @@ void overmap::move_hordes()
 */
 void overmap::signal_hordes( const tripoint_rel_sm &p_rel, const int sig_power )
 {
+    modified = true;
     tripoint_om_sm p( p_rel.raw() );
     for( auto &elem : zg ) {
         mongroup &mg = elem.second;
@@ -4599,6 +4725,11 @@ void overmap::place_specials( overmap_special_batch &enabled_specials )
     return placement.instances_placed <
            placement.special_details->occurrences.min;
 } ) ) {
+        if( detached ) {
+            // Only the overmap buffer can create the adjacent overmap.
+            needs_adjacent_specials = true;
+            return;
+        }
         // Randomly select from among the nearest uninitialized overmap positions.
         int previous_distance = 0;
         std::vector<point_abs_om> nearest_candidates;
@@ -4804,6 +4935,7 @@ void overmap::open( overmap_special_batch &enabled_specials )
             overmap::unserialize_view( fin, plrfilename );
         };
         read_from_file_optional( plrfilename, plr_reader );
+        modified = false;
     } else { // No map exists!  Prepare neighbors, and generate one.
         std::vector<const overmap *> pointers;
         // Fetch south and north
@@ -4832,8 +4964,20 @@ void overmap::save() const
     } );
 }
 
+void overmap::save( background_writer &writer ) const
+{
+    std::ostringstream view;
+    serialize_view( view );
+    writer.write( overmapbuffer::player_filename( loc ), view.str() );
+
+    std::ostringstream terrain;
+    serialize( terrain );
+    writer.write( overmapbuffer::terrain_filename( loc ), terrain.str() );
+}
+
 void overmap::add_mon_group( const mongroup &group )
 {
+    modified = true;
     // Monster groups: the old system had large groups (radius > 1),
     // the new system transforms them into groups of radius 1, this also
     // makes the diffuse setting obsolete (as it only controls how the radius
@@ -4926,6 +5070,7 @@ shared_ptr_fast<npc> overmap::find_npc( const character_id &id ) const
 
 cata::optional<basecamp *> overmap::find_camp( const point_abs_omt &p )
 {
+    modified = true;
     for( auto &v : camps ) {
         if( v.camp_omt_pos().xy() == p ) {
             return &v;
@@ -4936,7 +5081,9 @@ cata::optional<basecamp *> overmap::find_camp( const point_abs_omt &p )
 
 bool overmap::is_omt_generated( const tripoint_om_omt &loc ) const
 {
-    if( !inbounds( loc ) ) {
+    // Nothing was generated where there was no overmap yet, and the map buffer is only
+    // for the game thread.
+    if( !inbounds( loc ) || detached ) {
         return false;
     }
 
@@ -4954,6 +5101,7 @@ bool overmap::is_omt_generated( const tripoint_om_omt &loc ) const
 void overmap::set_electric_grid_connections( const tripoint_om_omt &p,
         const std::bitset<six_cardinal_directions.size()> &connections )
 {
+    modified = true;
     electric_grid_connections[p] = connections;
     for( size_t i = 0; i < six_cardinal_directions.size(); i++ ) {
         tripoint_om_omt other_p = p + six_cardinal_directions[i];
@@ -34,6 +34,7 @@
 class JsonIn;
 class JsonObject;
 class JsonOut;
+class background_writer;
 class basecamp;
 class character_id;
 class map_extra;
@@ -190,12 +191,49 @@ class overmap
          **/
         void populate( overmap_special_batch &enabled_specials );
         void populate();
+        /** The specials the regional settings allow to be placed on a new overmap. */
+        overmap_special_batch get_enabled_specials() const;
+        /**
+         * Generate a new overmap without using the overmap buffer, so it can be done on
+         * another thread. Only the given neighbours are looked at, they only need what
+         * @ref copy_borders keeps. Returns false if mandatory specials would have to be
+         * placed on a new adjacent overmap, which only the overmap buffer can create.
+         * The overmap is incomplete then and must be discarded. Otherwise it must be
+         * finished with @ref finish_generating on the game thread.
+         */
+        bool generate_detached( const overmap *north, const overmap *east,
+                                const overmap *south, const overmap *west,
+                                overmap_special_batch &enabled_specials );
+        /** The part of generating that uses translations: the messages of the radio towers. */
+        void finish_generating();
+        /**
+         * Copies what generating an adjacent overmap looks at, the outgoing connections and
+         * the surface terrain along the edges, into @p to, a new overmap at the same position.
+         */
+        void copy_borders( overmap &to ) const;
 
         const point_abs_om &pos() const {
             return loc;
         }
 
         void save() const;
+        /** Serialize the overmap and queue the resulting files on @p writer. */
+        void save( background_writer &writer ) const;
+
+        /**
+         * Whether anything changed since the overmap was loaded or last saved.
+         * NPCs change without the overmap noticing, overmaps with NPCs always need saving.
+         */
+        bool needs_saving() const {
+            return modified || !npcs.empty();
+        }
+        /** For code that changes the public members or data handed out by pointer. */
+        void set_modified() {
+            modified = true;
+        }
+        void mark_saved() {
+            modified = false;
+        }
 
         /**
          * @return The (local) overmap terrain coordinates of a randomly
@@ -217,9 +255,15 @@ class overmap
 
         void ter_set( const tripoint_om_omt &p, const oter_id &id );
         const oter_id &ter( const tripoint_om_omt &p ) const;
-        bool &seen( const tripoint_om_omt &p );
+        /**
+         * All locations of terrain @p id on this overmap, in no particular order.
+         * Returns nullptr if @p id is the default terrain of any z-level, those
+         * fill most of the overmap and are not indexed.
+         */
+        const std::vector<tripoint_om_omt> *terrain_locations( const oter_id &id ) const;
+        void set_seen( const tripoint_om_omt &p, bool seen );
         bool seen( const tripoint_om_omt &p ) const;
-        bool &explored( const tripoint_om_omt &p );
+        void set_explored( const tripoint_om_omt &p, bool explored );
         bool is_explored( const tripoint_om_omt &p ) const;
 
         bool has_note( const tripoint_om_omt &p ) const;
@@ -340,7 +384,9 @@ class overmap
 
         std::vector<shared_ptr_fast<npc>> npcs;
 
-        bool nullbool = false;
+        // Set by the setters, cleared by mark_saved. Overmaps that were just generated
+        // have never been saved.
+        bool modified = true;
         point_abs_om loc;
 
         std::array<map_layer, OVERMAP_LAYERS> layer;
@@ -354,7 +400,18 @@ class overmap
 
         pimpl<regional_settings> settings;
 
+        // Locations of each terrain except for the default ones, built by
+        // terrain_locations when first needed and kept up to date by ter_set.
+        mutable std::unordered_map<oter_id, std::vector<tripoint_om_omt>> terrain_index;
+        mutable bool terrain_index_built = false;
+
+        // Set by generate_detached while it runs.
+        bool detached = false;
+        // Set when detached generation has specials left that go on a new adjacent overmap.
+        bool needs_adjacent_specials = false;
+
         oter_id get_default_terrain( int z ) const;
+        bool is_default_terrain( const oter_id &id ) const;
 
         // Initialize
         void init_layers();
@@ -382,6 +439,15 @@ class overmap
         void generate( const overmap *north, const overmap *east,
                        const overmap *south, const overmap *west,
                        overmap_special_batch &enabled_specials );
+        /**
+         * All of @ref generate but @ref finish_generating. Only touches this overmap
+         * if @ref detached.
+         */
+        void lay_out( const overmap *north, const overmap *east,
+                      const overmap *south, const overmap *west,
+                      overmap_special_batch &enabled_specials );
+        /** Seed for step @p step of generating this overmap, see @ref rng_seed_scope. */
+        unsigned int generation_seed( int step ) const;
         bool generate_sub( int z );
         bool generate_over( int z );
 
@@ -73,22 +73,7 @@ const overmap_connection::subtype *overmap_connection::pick_subtype_for(
 
     const size_t cache_index = ground.to_i();
     assert( cache_index < cached_subtypes.size() );
-
-    if( cached_subtypes[cache_index] ) {
-        return cached_subtypes[cache_index].value;
-    }
-
-    const auto iter = std::find_if( subtypes.cbegin(),
-    subtypes.cend(), [&ground]( const subtype & elem ) {
-        return elem.allows_terrain( ground );
-    } );
-
-    const overmap_connection::subtype *result = iter != subtypes.cend() ? &*iter : nullptr;
-
-    cached_subtypes[cache_index].value = result;
-    cached_subtypes[cache_index].assigned = true;
-
-    return result;
+    return cached_subtypes[cache_index];
 }
 
 bool overmap_connection::has( const oter_id &oter ) const
@@ -125,7 +110,15 @@ void overmap_connection::check() const
 
 void overmap_connection::finalize()
 {
-    cached_subtypes.resize( overmap_terrains::get_all().size() );
+    // Filled here rather than when first needed, overmaps are generated on several threads.
+    cached_subtypes.clear();
+    for( const oter_t &ground : overmap_terrains::get_all() ) {
+        const auto iter = std::find_if( subtypes.cbegin(),
+        subtypes.cend(), [&ground]( const subtype & elem ) {
+            return elem.allows_terrain( ground.id.id() );
+        } );
+        cached_subtypes.push_back( iter != subtypes.cend() ? &*iter : nullptr );
+    }
 }
 
 namespace overmap_connections
@@ -61,16 +61,9 @@ class overmap_connection
         oter_type_str_id default_terrain;
 
     private:
-        struct cache {
-            const subtype *value = nullptr;
-            bool assigned = false;
-            operator bool() const {
-                return assigned;
-            }
-        };
-
         std::list<subtype> subtypes;
-        mutable std::vector<cache> cached_subtypes;
+        // What pick_subtype_for returns, by the index of the terrain.
+        std::vector<const subtype *> cached_subtypes;
 };
 
 namespace overmap_connections
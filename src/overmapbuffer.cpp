@@ -3,12 +3,16 @@
 #include <algorithm>
 #include <cassert>
 #include <climits>
+#include <exception>
 #include <iterator>
 #include <list>
 #include <map>
 #include <queue>
+#include <stdexcept>
+#include <thread>
 
 #include "avatar.h"
+#include "background_writer.h"
 #include "basecamp.h"
 #include "calendar.h"
 #include "cata_utility.h"
@@ -40,6 +44,7 @@
 #include "string_formatter.h"
 #include "string_id.h"
 #include "string_utils.h"
+#include "thread_pool.h"
 #include "translations.h"
 #include "vehicle.h"
 
@@ -48,10 +53,12 @@ class map_extra;
 overmapbuffer overmap_buffer;
 
 overmapbuffer::overmapbuffer()
-    : last_requested_overmap( nullptr )
+    : last_requested_overmap( nullptr ), writer( std::make_unique<background_writer>() )
 {
 }
 
+overmapbuffer::~overmapbuffer() = default;
+
 const city_reference city_reference::invalid{ nullptr, tripoint_abs_sm(), -1 };
 
 int city_reference::get_distance_from_bounds() const
@@ -82,6 +89,9 @@ std::string overmapbuffer::player_filename( const point_abs_om &p )
 
 overmap &overmapbuffer::get( const point_abs_om &p )
 {
+    if( !on_game_thread() ) {
+        debugmsg( "The overmap buffer is only for the game thread" );
+    }
     if( last_requested_overmap != nullptr && last_requested_overmap->pos() == p ) {
         return *last_requested_overmap;
     }
@@ -90,6 +100,9 @@ overmap &overmapbuffer::get( const point_abs_om &p )
     if( it != overmaps.end() ) {
         return *( last_requested_overmap = it->second.get() );
     }
+    if( overmap *generated = take_generated( p ) ) {
+        return *( last_requested_overmap = generated );
+    }
 
     // That constructor loads an existing overmap or creates a new one.
     overmap &new_om = *( overmaps[ p ] = std::make_unique<overmap>( p ) );
@@ -115,6 +128,131 @@ void overmapbuffer::create_custom_overmap( const point_abs_om &p, overmap_specia
     new_om.populate( specials );
 }
 
+struct overmapbuffer::generated_overmap {
+    // Null if the overmap has to be generated on the game thread after all.
+    std::unique_ptr<overmap> om;
+    // What generating the overmaps next to it looks at, null as long as om is.
+    std::shared_ptr<const overmap> borders;
+};
+
+void overmapbuffer::generate_around( const point_abs_om &center )
+{
+    // Defense mode has no overmaps, and with a single core this would only take turns
+    // with the game thread.
+    if( g->gametype() == SGAME_DEFENSE || std::thread::hardware_concurrency() < 2 ) {
+        return;
+    }
+    // Same order as the arguments of overmap::generate_detached.
+    static constexpr std::array<point, 4> sides = {{
+            point_north, point_east, point_south, point_west
+        }
+    };
+    // The corners come after the sides, so they see the sides next to them as if
+    // everything had been generated one by one in this order.
+    static constexpr std::array<point, 8> around = {{
+            point_north, point_east, point_south, point_west,
+            point_north_east, point_south_east, point_south_west, point_north_west
+        }
+    };
+    for( const point &offset : around ) {
+        const point_abs_om p = center + offset;
+        if( overmaps.count( p ) > 0 || generating.count( p ) > 0 || !not_on_disk( p ) ) {
+            continue;
+        }
+        // The worker only gets what no other thread touches: copies of the borders of the
+        // loaded neighbours, the futures of those being generated, and overmaps made here,
+        // as their constructor reads the options and the region settings.
+        std::array<std::shared_ptr<const overmap>, sides.size()> loaded;
+        std::array<generated_future, sides.size()> pending;
+        bool saved_neighbour = false;
+        for( size_t i = 0; i < sides.size(); i++ ) {
+            const point_abs_om neighbour = p + sides[i];
+            const auto loaded_iter = overmaps.find( neighbour );
+            const auto pending_iter = generating.find( neighbour );
+            if( loaded_iter != overmaps.end() ) {
+                std::shared_ptr<overmap> borders = std::make_shared<overmap>( neighbour );
+                loaded_iter->second->copy_borders( *borders );
+                loaded[i] = borders;
+            } else if( pending_iter != generating.end() ) {
+                pending[i] = pending_iter->second;
+            } else if( !not_on_disk( neighbour ) ) {
+                saved_neighbour = true;
+            }
+        }
+        if( saved_neighbour ) {
+            // It would have to be loaded first, that's left to get.
+            continue;
+        }
+        std::shared_ptr<generated_overmap> result = std::make_shared<generated_overmap>();
+        result->om = std::make_unique<overmap>( p );
+        std::shared_ptr<overmap> borders = std::make_shared<overmap>( p );
+        overmap_special_batch enabled_specials = result->om->get_enabled_specials();
+        generating[p] = get_background_thread_pool().submit(
+        [result, borders, loaded, pending, enabled_specials]() mutable {
+            std::array<const overmap *, sides.size()> neighbours;
+            for( size_t i = 0; i < sides.size(); i++ ) {
+                neighbours[i] = loaded[i].get();
+                if( pending[i].valid() ) {
+                    neighbours[i] = pending[i].get()->borders.get();
+                    if( neighbours[i] == nullptr ) {
+                        // That one is left to the game thread, so this one must wait for it.
+                        result->om.reset();
+                        return result;
+                    }
+                }
+            }
+            if( result->om->generate_detached( neighbours[0], neighbours[1], neighbours[2],
+                                               neighbours[3], enabled_specials ) ) {
+                result->om->copy_borders( *borders );
+                result->borders = borders;
+            } else {
+                result->om.reset();
+            }
+            return result;
+        } ).share();
+    }
+}
+
+overmap *overmapbuffer::take_generated( const point_abs_om &p )
+{
+    const auto iter = generating.find( p );
+    if( iter == generating.end() ) {
+        return nullptr;
+    }
+    const generated_future generated = iter->second;
+    generating.erase( iter );
+    std::unique_ptr<overmap> om;
+    try {
+        om = std::move( generated.get()->om );
+    } catch( const std::exception & ) {
+        // Generated again by the caller, which reports the error if it happens again.
+        report_deferred_debugmsgs();
+        return nullptr;
+    }
+    // Whatever went wrong on the worker is reported now, on this thread.
+    report_deferred_debugmsgs();
+    if( !om ) {
+        return nullptr;
+    }
+    om->finish_generating();
+    overmap &new_om = *( overmaps[ p ] = std::move( om ) );
+    fix_mongroups( new_om );
+    fix_npcs( new_om );
+    return &new_om;
+}
+
+bool overmapbuffer::not_on_disk( const point_abs_om &p ) const
+{
+    if( known_non_existing.count( p ) > 0 ) {
+        return true;
+    }
+    if( file_exist( terrain_filename( p ) ) ) {
+        return false;
+    }
+    known_non_existing.insert( p );
+    return true;
+}
+
 void overmapbuffer::fix_mongroups( overmap &new_overmap )
 {
     for( auto it = new_overmap.zg.begin(); it != new_overmap.zg.end(); ) {
@@ -123,6 +261,7 @@ void overmapbuffer::fix_mongroups( overmap &new_overmap )
         // transformed into spawn points on a submap, the group can then be removed
         if( mg.empty() ) {
             new_overmap.zg.erase( it++ );
+            new_overmap.set_modified();
             continue;
         }
         // Inside the bounds of the overmap?
@@ -145,6 +284,7 @@ void overmapbuffer::fix_mongroups( overmap &new_overmap )
         mg.pos = tripoint_om_sm( sm_rem, mg.pos.z() );
         om.add_mon_group( mg );
         new_overmap.zg.erase( it++ );
+        new_overmap.set_modified();
     }
 }
 
@@ -202,17 +342,48 @@ void overmapbuffer::fix_npcs( overmap &new_overmap )
 
 void overmapbuffer::save()
 {
+    std::vector<overmap *> saved;
     for( auto &omp : overmaps ) {
-        // Note: this may throw io errors from std::ofstream
-        omp.second->save();
+        overmap &om = *omp.second;
+        if( om.needs_saving() ) {
+            om.save( *writer );
+            om.mark_saved();
+            saved.push_back( &om );
+        }
+    }
+    // Files are written while the next overmaps are serialized, but the save is only done
+    // once all of them are on disk, so a failed write fails the save that lost the data.
+    writer->flush();
+    const std::vector<std::string> errors = writer->take_errors();
+    if( !errors.empty() ) {
+        for( overmap *om : saved ) {
+            om->set_modified();
+        }
+        throw std::runtime_error( string_format( "failed to write overmap data to %s",
+                                  join( errors, ", " ) ) );
+    }
+}
+
+void overmapbuffer::flush_writes()
+{
+    writer->flush();
+    for( const std::string &err : writer->take_errors() ) {
+        debugmsg( "Failed to write overmap data to %s", err );
     }
 }
 
 void overmapbuffer::clear()
 {
+    // Overmaps are only read from disk again after this, so they must be complete by then.
+    flush_writes();
+    for( const std::pair<const point_abs_om, generated_future> &pending : generating ) {
+        pending.second.wait();
+    }
+    generating.clear();
     overmaps.clear();
     known_non_existing.clear();
     last_requested_overmap = nullptr;
+    matching_terrains_cache.clear();
 }
 
 const regional_settings &overmapbuffer::get_settings( const tripoint_abs_omt &p )
@@ -259,6 +430,9 @@ void overmapbuffer::delete_extra( const tripoint_abs_omt &p )
 
 overmap *overmapbuffer::get_existing( const point_abs_om &p )
 {
+    if( !on_game_thread() ) {
+        debugmsg( "The overmap buffer is only for the game thread" );
+    }
     if( last_requested_overmap && last_requested_overmap->pos() == p ) {
         return last_requested_overmap;
     }
@@ -266,6 +440,9 @@ overmap *overmapbuffer::get_existing( const point_abs_om &p )
     if( it != overmaps.end() ) {
         return last_requested_overmap = it->second.get();
     }
+    if( overmap *generated = take_generated( p ) ) {
+        return last_requested_overmap = generated;
+    }
     if( known_non_existing.count( p ) > 0 ) {
         // This overmap does not exist on disk (this has already been
         // checked in a previous call of this function).
@@ -399,7 +576,7 @@ bool overmapbuffer::is_explored( const tripoint_abs_omt &p )
 void overmapbuffer::toggle_explored( const tripoint_abs_omt &p )
 {
     const overmap_with_local_coords om_loc = get_om_global( p );
-    om_loc.om->explored( om_loc.local ) = !om_loc.om->explored( om_loc.local );
+    om_loc.om->set_explored( om_loc.local, !om_loc.om->is_explored( om_loc.local ) );
 }
 
 bool overmapbuffer::has_horde( const tripoint_abs_omt &p )
@@ -536,6 +713,10 @@ std::vector<mongroup *> overmapbuffer::groups_at( const tripoint_abs_sm &p )
         }
         result.push_back( &mg );
     }
+    if( !result.empty() ) {
+        // The groups are handed out to spawn monsters from them.
+        om.set_modified();
+    }
     return result;
 }
 
@@ -578,8 +759,10 @@ void overmapbuffer::move_vehicle( vehicle *veh, const point_abs_ms &old_msp )
     const overmap_with_local_coords new_om_loc = get_om_global( new_omt );
     if( old_om_loc.om == new_om_loc.om ) {
         new_om_loc.om->vehicles[veh->om_id].p = new_om_loc.local.xy();
+        new_om_loc.om->set_modified();
     } else {
         old_om_loc.om->vehicles.erase( veh->om_id );
+        old_om_loc.om->set_modified();
         add_vehicle( veh );
     }
 }
@@ -592,6 +775,7 @@ void overmapbuffer::remove_camp( const basecamp &camp )
     for( auto it = camps.begin(); it != camps.end(); ++it ) {
         if( it->camp_omt_pos().xy() == omt ) {
             camps.erase( it );
+            om_loc.om->set_modified();
             return;
         }
     }
@@ -606,6 +790,7 @@ void overmapbuffer::remove_vehicle( const vehicle *veh )
         return;
     }
     om_loc.om->vehicles.erase( veh->om_id );
+    om_loc.om->set_modified();
 }
 
 void overmapbuffer::add_vehicle( vehicle *veh )
@@ -625,6 +810,7 @@ void overmapbuffer::add_vehicle( vehicle *veh )
     tracked_veh.p = om_loc.local.xy();
     tracked_veh.name = veh->name;
     veh->om_id = id;
+    om_loc.om->set_modified();
 }
 
 void overmapbuffer::add_camp( const basecamp &camp )
@@ -632,6 +818,7 @@ void overmapbuffer::add_camp( const basecamp &camp )
     const point_abs_omt omt = camp.camp_omt_pos().xy();
     const overmap_with_local_coords om_loc = get_om_global( omt );
     om_loc.om->camps.push_back( camp );
+    om_loc.om->set_modified();
 }
 
 bool overmapbuffer::seen( const tripoint_abs_omt &p )
@@ -645,7 +832,7 @@ bool overmapbuffer::seen( const tripoint_abs_omt &p )
 void overmapbuffer::set_seen( const tripoint_abs_omt &p, bool seen )
 {
     const overmap_with_local_coords om_loc = get_om_global( p );
-    om_loc.om->seen( om_loc.local ) = seen;
+    om_loc.om->set_seen( om_loc.local, seen );
 }
 
 const oter_id &overmapbuffer::ter( const tripoint_abs_omt &p )
@@ -1008,6 +1195,72 @@ tripoint_abs_omt overmapbuffer::find_closest(
     return find_closest( origin, params );
 }
 
+const std::vector<oter_id> &overmapbuffer::matching_terrains( const omt_find_params &params )
+{
+    const auto iter = matching_terrains_cache.find( params.types );
+    if( iter != matching_terrains_cache.end() ) {
+        return iter->second;
+    }
+    std::vector<oter_id> &result = matching_terrains_cache[params.types];
+    for( const oter_t &ot : overmap_terrains::get_all() ) {
+        const oter_id id = ot.id.id();
+        for( const std::pair<std::string, ot_match_type> &elem : params.types ) {
+            if( is_ot_match( elem.first, id, elem.second ) ) {
+                result.push_back( id );
+                break;
+            }
+        }
+    }
+    return result;
+}
+
+bool overmapbuffer::find_indexed( const point_abs_om &om_pos, const omt_find_params &params,
+                                  std::vector<tripoint_abs_omt> &result )
+{
+    const overmap *om = params.existing_only ? get_existing( om_pos ) : &get( om_pos );
+    if( om == nullptr ) {
+        return true;
+    }
+    for( const oter_id &id : matching_terrains( params ) ) {
+        const std::vector<tripoint_om_omt> *locations = om->terrain_locations( id );
+        if( locations == nullptr ) {
+            return false;
+        }
+        for( const tripoint_om_omt &p : *locations ) {
+            result.push_back( project_combine( om_pos, p ) );
+        }
+    }
+    return true;
+}
+
+using om_distance = std::pair<int, point_abs_om>;
+
+// Overmaps with tiles in square distance max_dist of origin, with the distance of their
+// nearest tile, nearest first.
+static std::vector<om_distance> overmaps_by_distance( const point_abs_omt &origin, int max_dist )
+{
+    const point_abs_om min_om = project_to<coords::om>( origin - point( max_dist, max_dist ) );
+    const point_abs_om max_om = project_to<coords::om>( origin + point( max_dist, max_dist ) );
+    const auto axis_dist = []( int o, int lo, int size ) {
+        return std::max( { 0, lo - o, o - ( lo + size - 1 ) } );
+    };
+    std::vector<om_distance> result;
+    for( int x = min_om.x(); x <= max_om.x(); x++ ) {
+        for( int y = min_om.y(); y <= max_om.y(); y++ ) {
+            const point_abs_om om_pos( x, y );
+            const point_abs_omt corner = project_to<coords::omt>( om_pos );
+            const int dist = std::max( axis_dist( origin.x(), corner.x(), OMAPX ),
+                                       axis_dist( origin.y(), corner.y(), OMAPY ) );
+            result.emplace_back( dist, om_pos );
+        }
+    }
+    std::stable_sort( result.begin(), result.end(), []( const om_distance & lhs,
+    const om_distance & rhs ) {
+        return lhs.first < rhs.first;
+    } );
+    return result;
+}
+
 tripoint_abs_omt overmapbuffer::find_closest( const tripoint_abs_omt &origin,
         const omt_find_params &params )
 {
@@ -1034,6 +1287,49 @@ tripoint_abs_omt overmapbuffer::find_closest( const tripoint_abs_omt &origin,
     const int min_dist = params.min_distance;
     const int max_dist = params.search_range ? params.search_range : OMAPX * 5;
 
+    // Overmaps index where their terrain is, so only the locations with the right
+    // terrain have to be checked, and only on the overmaps that can be closer than
+    // the best location found so far.
+    std::vector<tripoint_abs_omt> result;
+    cata::optional<int> found_dist;
+    std::vector<tripoint_abs_omt> candidates;
+    for( const om_distance &om : overmaps_by_distance( origin.xy(), max_dist ) ) {
+        if( found_dist && *found_dist < om.first ) {
+            break;
+        }
+        candidates.clear();
+        if( !find_indexed( om.second, params, candidates ) ) {
+            return find_closest_by_scan( origin, params );
+        }
+        for( const tripoint_abs_omt &loc : candidates ) {
+            const int dist_xy = square_dist( origin.xy(), loc.xy() );
+            if( dist_xy < min_dist || dist_xy > max_dist ) {
+                continue;
+            }
+            const int dist = square_dist( origin, loc );
+            if( ( found_dist && *found_dist < dist ) || !is_findable_location( loc, params ) ) {
+                continue;
+            }
+            if( !found_dist || dist < *found_dist ) {
+                found_dist = dist;
+                result.clear();
+            }
+            result.push_back( loc );
+        }
+        if( params.popup ) {
+            params.popup->refresh();
+        }
+    }
+
+    return random_entry( result, overmap::invalid_tripoint );
+}
+
+tripoint_abs_omt overmapbuffer::find_closest_by_scan( const tripoint_abs_omt &origin,
+        const omt_find_params &params )
+{
+    const int min_dist = params.min_distance;
+    const int max_dist = params.search_range ? params.search_range : OMAPX * 5;
+
     std::vector<tripoint_abs_omt> result;
     cata::optional<int> found_dist;
 
@@ -1080,6 +1376,39 @@ std::vector<tripoint_abs_omt> overmapbuffer::find_all( const tripoint_abs_omt &o
     const int min_dist = params.min_distance;
     const int max_dist = params.search_range ? params.search_range : OMAPX;
 
+    std::vector<tripoint_abs_omt> candidates;
+    for( const om_distance &om : overmaps_by_distance( origin.xy(), max_dist ) ) {
+        candidates.clear();
+        if( !find_indexed( om.second, params, candidates ) ) {
+            return find_all_by_scan( origin, params );
+        }
+        for( const tripoint_abs_omt &loc : candidates ) {
+            const int dist = square_dist( origin.xy(), loc.xy() );
+            if( loc.z() == origin.z() && dist >= min_dist && dist <= max_dist &&
+                is_findable_location( loc, params ) ) {
+                result.push_back( loc );
+            }
+        }
+        if( params.popup ) {
+            params.popup->refresh();
+        }
+    }
+    // Nearest first, like the scan.
+    std::stable_sort( result.begin(), result.end(), [&]( const tripoint_abs_omt & lhs,
+    const tripoint_abs_omt & rhs ) {
+        return square_dist( origin, lhs ) < square_dist( origin, rhs );
+    } );
+
+    return result;
+}
+
+std::vector<tripoint_abs_omt> overmapbuffer::find_all_by_scan( const tripoint_abs_omt &origin,
+        const omt_find_params &params )
+{
+    std::vector<tripoint_abs_omt> result;
+    const int min_dist = params.min_distance;
+    const int max_dist = params.search_range ? params.search_range : OMAPX;
+
     size_t num_overmaps = overmaps.size();
     size_t counter = 0;
 
@@ -1486,7 +1815,10 @@ void overmapbuffer::spawn_monster( const tripoint_abs_sm &p )
             placed->on_load();
         }
     } );
-    om.monster_map->erase( current_submap_loc );
+    if( monster_bucket.first != monster_bucket.second ) {
+        om.monster_map->erase( current_submap_loc );
+        om.set_modified();
+    }
 }
 
 void overmapbuffer::despawn_monster( const monster &critter )
@@ -1501,6 +1833,7 @@ void overmapbuffer::despawn_monster( const monster &critter )
     overmap &om = get( omp );
     // Store the monster using coordinates local to the overmap.
     om.monster_map->insert( std::make_pair( sm, critter ) );
+    om.set_modified();
 }
 
 overmapbuffer::t_notes_vector overmapbuffer::get_notes( int z, const std::string *pattern )
@@ -4,6 +4,8 @@
 
 #include <array>
 #include <functional>
+#include <future>
+#include <map>
 #include <memory>
 #include <set>
 #include <string>
@@ -20,6 +22,7 @@
 #include "string_id.h"
 #include "type_id.h"
 
+class background_writer;
 class basecamp;
 class character_id;
 class map_extra;
@@ -165,6 +168,7 @@ class overmapbuffer
 {
     public:
         overmapbuffer();
+        ~overmapbuffer();
 
         static std::string terrain_filename( const point_abs_om & );
         static std::string player_filename( const point_abs_om & );
@@ -174,7 +178,16 @@ class overmapbuffer
          * compared with the position of the overmap.
          */
         overmap &get( const point_abs_om & );
+        /**
+         * Start generating the overmaps around the one at @p center that don't exist yet
+         * on worker threads. A later @ref get of one of them only waits if it isn't done.
+         */
+        void generate_around( const point_abs_om &center );
+        /** Queue all overmaps to be written to disk on a background thread. */
         void save();
+        /** Block until all overmaps queued by @ref save have been written to disk. */
+        void flush_writes();
+        /** Unload all overmaps, after waiting for pending writes. */
         void clear();
         void create_custom_overmap( const point_abs_om &, overmap_special_batch &specials );
 
@@ -528,8 +541,39 @@ class overmapbuffer
          * see omt_find_params for definitions of the terms
          */
         bool is_findable_location( const tripoint_abs_omt &location, const omt_find_params &params );
+        /** Terrain ids that match any of the types of @p params. */
+        const std::vector<oter_id> &matching_terrains( const omt_find_params &params );
+        /**
+         * Adds the locations on overmap @p om_pos that have a terrain matching @p params
+         * to @p result. Returns false if those terrains are not indexed by the overmap,
+         * see @ref overmap::terrain_locations.
+         */
+        bool find_indexed( const point_abs_om &om_pos, const omt_find_params &params,
+                           std::vector<tripoint_abs_omt> &result );
+        /** @ref find_closest by checking every location, nearest first. */
+        tripoint_abs_omt find_closest_by_scan( const tripoint_abs_omt &origin,
+                                               const omt_find_params &params );
+        /** @ref find_all by checking every location, nearest first. */
+        std::vector<tripoint_abs_omt> find_all_by_scan( const tripoint_abs_omt &origin,
+                const omt_find_params &params );
+
+        std::map<std::vector<std::pair<std::string, ot_match_type>>, std::vector<oter_id>>
+                matching_terrains_cache;
 
         std::unordered_map< point_abs_om, std::unique_ptr< overmap > > overmaps;
+
+        struct generated_overmap;
+        using generated_future = std::shared_future<std::shared_ptr<generated_overmap>>;
+        // Overmaps being generated by generate_around, not yet in overmaps.
+        std::map<point_abs_om, generated_future> generating;
+        /**
+         * Moves the overmap generated at @p p by @ref generate_around into @ref overmaps,
+         * waiting for it if needed, and finishes it there. Returns null if there is none,
+         * or if it has to be generated on this thread after all.
+         */
+        overmap *take_generated( const point_abs_om &p );
+        /** Whether no overmap for @p p is saved, checking the disk only once. */
+        bool not_on_disk( const point_abs_om &p ) const;
         /**
          * Set of overmap coordinates of overmaps that are known
          * to not exist on disk. See @ref get_existing for usage.
@@ -537,6 +581,7 @@ class overmapbuffer
         mutable std::set<point_abs_om> known_non_existing;
         // Cached result of previous call to overmapbuffer::get_existing
         overmap mutable *last_requested_overmap;
+        std::unique_ptr<background_writer> writer;
 
         /**
          * Get a list of notes in the (loaded) overmaps.
@@ -1,20 +1,23 @@
 #include "pathfinding.h"
 
+#include <cassert>
+#include <cstdint>
 #include <cstdlib>
 #include <algorithm>
-#include <queue>
 #include <set>
 #include <array>
 #include <memory>
 #include <utility>
 #include <vector>
 
+#include "bucket_queue.h"
 #include "cata_utility.h"
 #include "coordinates.h"
 #include "debug.h"
 #include "map.h"
 #include "mapdata.h"
 #include "optional.h"
+#include "portal_graph.h"
 #include "submap.h"
 #include "trap.h"
 #include "veh_type.h"
@@ -38,42 +41,80 @@ constexpr int flat_index( const tripoint &p )
 
 // Flattened 2D array representing a single z-level worth of pathfinding data
 struct path_data_layer {
+    // Search that last wrote each entry, entries written by older searches are unvisited.
+    std::array< uint32_t, MAPSIZE_X *MAPSIZE_Y > generation;
     // State is accessed way more often than all other values here
     std::array< astar_state, MAPSIZE_X *MAPSIZE_Y > state;
     std::array< int, MAPSIZE_X *MAPSIZE_Y > score;
     std::array< int, MAPSIZE_X *MAPSIZE_Y > gscore;
     std::array< tripoint, MAPSIZE_X *MAPSIZE_Y > parent;
+    // Search currently using this layer
+    uint32_t current = 0;
 
-    void init( point min, point max ) {
-        tripoint p;
-        for( p.x = min.x; p.x <= max.x; p.x++ ) {
-            for( p.y = min.y; p.y <= max.y; p.y++ ) {
-                const int ind = flat_index( p );
-                state[ind] = ASL_NONE; // Mark as unvisited
-            }
-        }
+    astar_state get_state( const int index ) const {
+        return generation[index] == current ? state[index] : ASL_NONE;
+    }
+
+    void set_state( const int index, const astar_state new_state ) {
+        generation[index] = current;
+        state[index] = new_state;
     }
 };
 
+// Kept between searches, so neither the layers nor the open list have to be allocated or
+// cleared for each one. Instead, each search has a new generation number.
 struct pathfinder {
-    point min;
-    point max;
-    pathfinder( point _min, point _max ) :
-        min( _min ), max( _max ) {
-    }
+    // Layers beyond this many are freed after a search, the most recently used ones stay.
+    static constexpr int max_kept_layers = 3;
 
-    std::priority_queue< std::pair<int, tripoint>, std::vector< std::pair<int, tripoint> >, pair_greater_cmp_first >
-    open;
+    uint32_t generation = 0;
+    // Set while a search runs, a search must not start another one on the same thread.
+    bool searching = false;
+    cata::bucket_queue<tripoint> open;
     std::array< std::unique_ptr< path_data_layer >, OVERMAP_LAYERS > path_data;
 
+    void start_search() {
+        assert( !searching );
+        searching = true;
+        open.clear();
+        generation++;
+        if( generation == 0 ) {
+            // Wrapped around, entries from long ago would look like they belong to this search.
+            for( std::unique_ptr< path_data_layer > &layer : path_data ) {
+                if( layer != nullptr ) {
+                    layer->generation.fill( 0 );
+                }
+            }
+            generation = 1;
+        }
+    }
+
+    void finish_search() {
+        searching = false;
+        int kept = 0;
+        for( const std::unique_ptr< path_data_layer > &layer : path_data ) {
+            kept += layer != nullptr ? 1 : 0;
+        }
+        while( kept > max_kept_layers ) {
+            // Generations only wrap around once in a very long while, freeing a layer that
+            // was used recently then just means allocating it again.
+            std::unique_ptr< path_data_layer > *oldest = nullptr;
+            for( std::unique_ptr< path_data_layer > &layer : path_data ) {
+                if( layer != nullptr && ( oldest == nullptr || layer->current < ( *oldest )->current ) ) {
+                    oldest = &layer;
+                }
+            }
+            oldest->reset();
+            kept--;
+        }
+    }
+
     path_data_layer &get_layer( const int z ) {
         std::unique_ptr< path_data_layer > &ptr = path_data[z + OVERMAP_DEPTH];
-        if( ptr != nullptr ) {
-            return *ptr;
+        if( ptr == nullptr ) {
+            ptr = std::make_unique<path_data_layer>();
         }
-
-        ptr = std::make_unique<path_data_layer>();
-        ptr->init( min, max );
+        ptr->current = generation;
         return *ptr;
     }
 
@@ -82,36 +123,34 @@ struct pathfinder {
     }
 
     tripoint get_next() {
-        const auto pt = open.top();
-        open.pop();
-        return pt.second;
+        return open.pop();
     }
 
     void add_point( const int gscore, const int score, const tripoint &from, const tripoint &to ) {
         auto &layer = get_layer( to.z );
         const int index = flat_index( to );
-        if( ( layer.state[index] == ASL_OPEN && gscore >= layer.gscore[index] ) ||
-            layer.state[index] == ASL_CLOSED ) {
+        const astar_state state = layer.get_state( index );
+        if( ( state == ASL_OPEN && gscore >= layer.gscore[index] ) || state == ASL_CLOSED ) {
             return;
         }
 
-        layer.state [index] = ASL_OPEN;
+        layer.set_state( index, ASL_OPEN );
         layer.gscore[index] = gscore;
         layer.parent[index] = from;
         layer.score [index] = score;
-        open.push( std::make_pair( score, to ) );
+        open.push( score, to );
     }
 
     void close_point( const tripoint &p ) {
         auto &layer = get_layer( p.z );
         const int index = flat_index( p );
-        layer.state[index] = ASL_CLOSED;
+        layer.set_state( index, ASL_CLOSED );
     }
 
     void unclose_point( const tripoint &p ) {
         auto &layer = get_layer( p.z );
         const int index = flat_index( p );
-        layer.state[index] = ASL_NONE;
+        layer.set_state( index, ASL_NONE );
     }
 };
 
@@ -160,6 +199,21 @@ bool vertical_move_destination( const map &m, tripoint &t )
     return false;
 }
 
+bool stairs_destination( const map &m, tripoint &t, const bool going_up )
+{
+    return going_up ? vertical_move_destination<TFLAG_GOES_DOWN>( m, t ) :
+           vertical_move_destination<TFLAG_GOES_UP>( m, t );
+}
+
+bool pathfinding_settings::operator==( const pathfinding_settings &rhs ) const
+{
+    return bash_strength == rhs.bash_strength && max_dist == rhs.max_dist &&
+           max_length == rhs.max_length && climb_cost == rhs.climb_cost &&
+           allow_open_doors == rhs.allow_open_doors && avoid_traps == rhs.avoid_traps &&
+           allow_climb_stairs == rhs.allow_climb_stairs &&
+           avoid_rough_terrain == rhs.avoid_rough_terrain && avoid_sharp == rhs.avoid_sharp;
+}
+
 template<class Set1, class Set2>
 bool is_disjoint( const Set1 &set1, const Set2 &set2 )
 {
@@ -191,6 +245,172 @@ bool is_disjoint( const Set1 &set1, const Set2 &set2 )
     return true;
 }
 
+std::vector<tripoint> plain_line_route( const map &m, const tripoint &f, const tripoint &t )
+{
+    if( f.z != t.z ) {
+        return std::vector<tripoint>();
+    }
+    std::vector<tripoint> line_path = line_to( f, t );
+    const pathfinding_cache &pf_cache = m.get_pathfinding_cache_ref( f.z );
+    // Check all points for any special case (including just hard terrain)
+    if( ( pf_cache.special[f.x][f.y] & pf_non_normal ) ||
+    std::any_of( line_path.begin(), line_path.end(), [&pf_cache]( const tripoint & p ) {
+    return pf_cache.special[p.x][p.y] & pf_non_normal;
+} ) ) {
+        return std::vector<tripoint>();
+    }
+    return line_path;
+}
+
+half_open_rectangle<point> map::route_bounds( const tripoint &f, const tripoint &t ) const
+{
+    const int pad = 16;  // Should be much bigger - low value makes pathfinders dumb!
+    int minx = std::min( f.x, t.x ) - pad;
+    int miny = std::min( f.y, t.y ) - pad;
+    int maxx = std::max( f.x, t.x ) + pad;
+    int maxy = std::max( f.y, t.y ) + pad;
+    clip_to_bounds( minx, miny );
+    clip_to_bounds( maxx, maxy );
+    return half_open_rectangle<point>( point( minx, miny ), point( maxx, maxy ) );
+}
+
+route_step map::route_step_cost( const pathfinding_cache &cache, const tripoint &from,
+                                 const tripoint &to, const pathfinding_settings &settings ) const
+{
+    using kind = route_step::kind;
+    const int bash = settings.bash_strength;
+    const int climb_cost = settings.climb_cost;
+    const bool doors = settings.allow_open_doors;
+
+    int from_part = -1;
+    const vehicle *from_veh = cache.special[from.x][from.y] & PF_VEHICLE ?
+                              veh_at_internal( from, from_part ) : nullptr;
+    int part = -1;
+    const pf_special special = cache.special[to.x][to.y];
+    const vehicle *veh = special & PF_VEHICLE ? veh_at_internal( to, part ) : nullptr;
+    if( from_veh &&
+        !from_veh->allowed_move( from_veh->tripoint_to_mount( from ),
+                                 from_veh->tripoint_to_mount( to ) ) ) {
+        //Trying to squeeze through a vehicle hole, skip this movement but don't close the tile as other paths may lead to it
+        return route_step{ kind::blocked_from_here, 0 };
+    }
+    if( veh && veh != from_veh &&
+        !veh->allowed_move( veh->tripoint_to_mount( from ), veh->tripoint_to_mount( to ) ) ) {
+        //Same as above but moving into rather than out of a vehicle
+        return route_step{ kind::blocked_from_here, 0 };
+    }
+
+    if( !( special & pf_non_normal ) ) {
+        // Boring flat dirt - the most common case above the ground
+        return route_step{ kind::enter, 2 };
+    }
+    if( settings.avoid_rough_terrain ) {
+        return route_step{ kind::blocked, 0 };
+    }
+
+    const maptile &tile = maptile_at_internal( to );
+    const ter_t &terrain = tile.get_ter_t();
+    const furn_t &furniture = tile.get_furn_t();
+
+    const int move_cost = move_cost_internal( furniture, terrain, veh, part );
+    // Don't calculate bash rating unless we intend to actually use it
+    const int rating = ( bash == 0 || move_cost != 0 ) ? -1 :
+                       bash_rating_internal( bash, furniture, terrain, false, veh, part );
+
+    if( move_cost == 0 && rating <= 0 && ( !doors || !terrain.open || !furniture.open ) &&
+        veh == nullptr && climb_cost <= 0 ) {
+        return route_step{ kind::blocked, 0 };
+    }
+
+    int cost = move_cost;
+    if( move_cost == 0 ) {
+        if( climb_cost > 0 && special & PF_CLIMBABLE ) {
+            // Climbing fences
+            cost += climb_cost;
+        } else if( doors && ( terrain.open || furniture.open ) &&
+                   ( !terrain.has_flag( "OPENCLOSE_INSIDE" ) || !furniture.has_flag( "OPENCLOSE_INSIDE" ) ||
+                     !is_outside( from ) ) ) {
+            // Only try to open INSIDE doors from the inside
+            // To open and then move onto the tile
+            cost += 4;
+        } else if( veh != nullptr ) {
+            const auto vpobst = vpart_position( const_cast<vehicle &>( *veh ), part ).obstacle_at_part();
+            part = vpobst ? vpobst->part_index() : -1;
+            if( doors && veh->part_flag( part, VPFLAG_OPENABLE ) &&
+                ( !veh->part_flag( part, "OPENCLOSE_INSIDE" ) || from_veh == veh ) ) {
+                // Handle car doors, but don't try to path through curtains
+                cost += 10; // One turn to open, 4 to move there
+            } else if( part >= 0 && bash > 0 ) {
+                // Car obstacle that isn't a door
+                // TODO: Account for armor
+                int hp = veh->cpart( part ).hp();
+                if( hp / 20 > bash ) {
+                    // Threshold damage thing means we just can't bash this down
+                    return route_step{ kind::blocked, 0 };
+                } else if( hp / 10 > bash ) {
+                    // Threshold damage thing means we will fail to deal damage pretty often
+                    hp *= 2;
+                }
+
+                cost += 2 * hp / bash + 8 + 4;
+            } else if( part >= 0 ) {
+                if( !doors || !veh->part_flag( part, VPFLAG_OPENABLE ) ) {
+                    // Won't be openable, don't try from other sides
+                    return route_step{ kind::blocked, 0 };
+                }
+
+                return route_step{ kind::blocked_from_here, 0 };
+            }
+        } else if( rating > 1 ) {
+            // Expected number of turns to bash it down, 1 turn to move there
+            // and 5 turns of penalty not to trash everything just because we can
+            cost += ( 20 / rating ) + 2 + 10;
+        } else if( rating == 1 ) {
+            // Desperate measures, avoid whenever possible
+            cost += 500;
+        } else {
+            // Unbashable and unopenable from here
+            if( !doors || !terrain.open || !furniture.open ) {
+                // Or anywhere else for that matter
+                return route_step{ kind::blocked, 0 };
+            }
+
+            return route_step{ kind::blocked_from_here, 0 };
+        }
+    }
+
+    if( settings.avoid_traps && special & PF_TRAP ) {
+        const trap &ter_trp = terrain.trap.obj();
+        const trap &trp = ter_trp.is_benign() ? tile.get_trap_t() : ter_trp;
+        if( !trp.is_benign() ) {
+            // For now make them detect all traps
+            if( has_zlevels() && terrain.has_flag( TFLAG_NO_FLOOR ) ) {
+                // Special case - ledge in z-levels
+                // Warning: really expensive, needs a cache
+                if( valid_move( to, tripoint( to.xy(), to.z - 1 ), false, true ) ) {
+                    const tripoint below( to.xy(), to.z - 1 );
+                    if( !has_flag( TFLAG_NO_FLOOR, below ) ) {
+                        // Otherwise this would have been a huge fall
+                        return route_step{ kind::drop, 10 };
+                    }
+
+                    // We won't be walking on it
+                    return route_step{ kind::blocked, 0 };
+                }
+            } else {
+                // Otherwise it's walkable
+                cost += 500;
+            }
+        }
+    }
+
+    if( settings.avoid_sharp && special & PF_SHARP ) {
+        // Avoid sharp things
+        return route_step{ kind::blocked, 0 };
+    }
+    return route_step{ kind::enter, cost };
+}
+
 std::vector<tripoint> map::route( const tripoint &f, const tripoint &t,
                                   const pathfinding_settings &settings,
                                   const std::set<tripoint> &pre_closed ) const
@@ -211,20 +431,12 @@ std::vector<tripoint> map::route( const tripoint &f, const tripoint &t,
     }
     // First, check for a simple straight line on flat ground
     // Except when the line contains a pre-closed tile - we need to do regular pathing then
-    static const auto non_normal = PF_SLOW | PF_WALL | PF_VEHICLE | PF_TRAP | PF_SHARP;
-    if( f.z == t.z ) {
-        const auto line_path = line_to( f, t );
-        const auto &pf_cache = get_pathfinding_cache_ref( f.z );
-        // Check all points for any special case (including just hard terrain)
-        if( !( pf_cache.special[f.x][f.y] & non_normal ) &&
-        std::all_of( line_path.begin(), line_path.end(), [&pf_cache]( const tripoint & p ) {
-        return !( pf_cache.special[p.x][p.y] & non_normal );
-        } ) ) {
-            const std::set<tripoint> sorted_line( line_path.begin(), line_path.end() );
-
-            if( is_disjoint( sorted_line, pre_closed ) ) {
-                return line_path;
-            }
+    const std::vector<tripoint> line_path = plain_line_route( *this, f, t );
+    if( !line_path.empty() ) {
+        const std::set<tripoint> sorted_line( line_path.begin(), line_path.end() );
+
+        if( is_disjoint( sorted_line, pre_closed ) ) {
+            return line_path;
         }
     }
 
@@ -233,31 +445,43 @@ std::vector<tripoint> map::route( const tripoint &f, const tripoint &t,
         return ret;
     }
 
-    int max_length = settings.max_length;
-    int bash = settings.bash_strength;
-    int climb_cost = settings.climb_cost;
-    bool doors = settings.allow_open_doors;
-    bool trapavoid = settings.avoid_traps;
-    bool roughavoid = settings.avoid_rough_terrain;
-    bool sharpavoid = settings.avoid_sharp;
+    // Searching tile by tile gets expensive over longer distances and across z-levels
+    if( f.z != t.z || square_dist( f.xy(), t.xy() ) > hierarchical_route_dist ) {
+        cata::optional<std::vector<tripoint>> planned = route_through_portals( f, t, settings,
+                pre_closed );
+        if( planned ) {
+            return std::move( *planned );
+        }
+    }
 
-    const int pad = 16;  // Should be much bigger - low value makes pathfinders dumb!
-    int minx = std::min( f.x, t.x ) - pad;
-    int miny = std::min( f.y, t.y ) - pad;
+    return search_route( f, t, settings, pre_closed, nullptr );
+}
+
+std::vector<tripoint> map::search_route( const tripoint &f, const tripoint &t,
+        const pathfinding_settings &settings, const std::set<tripoint> &pre_closed,
+        const route_corridor *corridor ) const
+{
+    std::vector<tripoint> ret;
+    const int max_length = settings.max_length;
+    // The corridor may lead anywhere on the map.
+    const half_open_rectangle<point> bounds = corridor == nullptr ? route_bounds( f, t ) :
+            half_open_rectangle<point>( point_zero, point( SEEX * my_MAPSIZE, SEEY * my_MAPSIZE ) );
     // TODO: Make this way bigger
-    int minz = std::min( f.z, t.z );
-    int maxx = std::max( f.x, t.x ) + pad;
-    int maxy = std::max( f.y, t.y ) + pad;
+    const int minz = std::min( f.z, t.z );
     // Same TODO: as above
-    int maxz = std::max( f.z, t.z );
-    clip_to_bounds( minx, miny, minz );
-    clip_to_bounds( maxx, maxy, maxz );
-
-    pathfinder pf( point( minx, miny ), point( maxx, maxy ) );
+    const int maxz = std::max( f.z, t.z );
+
+    // Routes are searched for by many creatures every turn, setting up a new pathfinder
+    // each time would take longer than most searches. Each thread has its own.
+    static thread_local pathfinder pf;
+    pf.start_search();
+    on_out_of_scope finish_search( []() {
+        pf.finish_search();
+    } );
     // Make NPCs not want to path through player
     // But don't make player pathing stop working
     for( const auto &p : pre_closed ) {
-        if( p.x >= minx && p.x < maxx && p.y >= miny && p.y < maxy ) {
+        if( bounds.contains( p.xy() ) ) {
             pf.close_point( p );
         }
     }
@@ -274,8 +498,7 @@ std::vector<tripoint> map::route( const tripoint &f, const tripoint &t,
 
         const int parent_index = flat_index( cur );
         auto &layer = pf.get_layer( cur.z );
-        auto &cur_state = layer.state[parent_index];
-        if( cur_state == ASL_CLOSED ) {
+        if( layer.get_state( parent_index ) == ASL_CLOSED ) {
             continue;
         }
 
@@ -289,14 +512,11 @@ std::vector<tripoint> map::route( const tripoint &f, const tripoint &t,
             break;
         }
 
-        cur_state = ASL_CLOSED;
+        layer.set_state( parent_index, ASL_CLOSED );
 
         const auto &pf_cache = get_pathfinding_cache_ref( cur.z );
         const auto cur_special = pf_cache.special[cur.x][cur.y];
 
-        int cur_part;
-        const vehicle *cur_veh = veh_at_internal( cur, cur_part );
-
         // 7 3 5
         // 1 . 2
         // 6 4 8
@@ -307,156 +527,38 @@ std::vector<tripoint> map::route( const tripoint &f, const tripoint &t,
             const int index = flat_index( p );
 
             // TODO: Remove this and instead have sentinels at the edges
-            if( p.x < minx || p.x >= maxx || p.y < miny || p.y >= maxy ) {
+            if( !bounds.contains( p.xy() ) || ( corridor != nullptr && !corridor->contains( p ) ) ) {
                 continue;
             }
 
-            if( layer.state[index] == ASL_CLOSED ) {
+            if( layer.get_state( index ) == ASL_CLOSED ) {
                 continue;
             }
 
-            int part = -1;
-            const vehicle *veh = veh_at_internal( p, part );
-            if( cur_veh &&
-                !cur_veh->allowed_move( cur_veh->tripoint_to_mount( cur ), cur_veh->tripoint_to_mount( p ) ) ) {
-                //Trying to squeeze through a vehicle hole, skip this movement but don't close the tile as other paths may lead to it
+            const route_step step = route_step_cost( pf_cache, cur, p, settings );
+            if( step.what == route_step::kind::blocked_from_here ) {
                 continue;
             }
-
-            if( veh && veh != cur_veh &&
-                !veh->allowed_move( veh->tripoint_to_mount( cur ), veh->tripoint_to_mount( p ) ) ) {
-                //Same as above but moving into rather than out of a vehicle
+            if( step.what != route_step::kind::enter ) {
+                if( step.what == route_step::kind::drop ) {
+                    // From cur, not p, because we won't be walking on air
+                    const tripoint below( p.xy(), p.z - 1 );
+                    pf.add_point( layer.gscore[parent_index] + step.cost,
+                                  layer.gscore[parent_index] + step.cost + 2 * rl_dist( below, t ),
+                                  cur, below );
+                }
+                // Close it so that next time we won't try to calculate costs
+                layer.set_state( index, ASL_CLOSED );
                 continue;
             }
 
             // Penalize for diagonals or the path will look "unnatural"
-            int newg = layer.gscore[parent_index] + ( ( cur.x != p.x && cur.y != p.y ) ? 1 : 0 );
-
-            const auto p_special = pf_cache.special[p.x][p.y];
-            // TODO: De-uglify, de-huge-n
-            if( !( p_special & non_normal ) ) {
-                // Boring flat dirt - the most common case above the ground
-                newg += 2;
-            } else {
-                if( roughavoid ) {
-                    layer.state[index] = ASL_CLOSED; // Close all rough terrain tiles
-                    continue;
-                }
-
-                const maptile &tile = maptile_at_internal( p );
-                const auto &terrain = tile.get_ter_t();
-                const auto &furniture = tile.get_furn_t();
-
-                const int cost = move_cost_internal( furniture, terrain, veh, part );
-                // Don't calculate bash rating unless we intend to actually use it
-                const int rating = ( bash == 0 || cost != 0 ) ? -1 :
-                                   bash_rating_internal( bash, furniture, terrain, false, veh, part );
-
-                if( cost == 0 && rating <= 0 && ( !doors || !terrain.open || !furniture.open ) && veh == nullptr &&
-                    climb_cost <= 0 ) {
-                    layer.state[index] = ASL_CLOSED; // Close it so that next time we won't try to calculate costs
-                    continue;
-                }
-
-                newg += cost;
-                if( cost == 0 ) {
-                    if( climb_cost > 0 && p_special & PF_CLIMBABLE ) {
-                        // Climbing fences
-                        newg += climb_cost;
-                    } else if( doors && ( terrain.open || furniture.open ) &&
-                               ( !terrain.has_flag( "OPENCLOSE_INSIDE" ) || !furniture.has_flag( "OPENCLOSE_INSIDE" ) ||
-                                 !is_outside( cur ) ) ) {
-                        // Only try to open INSIDE doors from the inside
-                        // To open and then move onto the tile
-                        newg += 4;
-                    } else if( veh != nullptr ) {
-                        const auto vpobst = vpart_position( const_cast<vehicle &>( *veh ), part ).obstacle_at_part();
-                        part = vpobst ? vpobst->part_index() : -1;
-                        int dummy = -1;
-                        if( doors && veh->part_flag( part, VPFLAG_OPENABLE ) &&
-                            ( !veh->part_flag( part, "OPENCLOSE_INSIDE" ) ||
-                              veh_at_internal( cur, dummy ) == veh ) ) {
-                            // Handle car doors, but don't try to path through curtains
-                            newg += 10; // One turn to open, 4 to move there
-                        } else if( part >= 0 && bash > 0 ) {
-                            // Car obstacle that isn't a door
-                            // TODO: Account for armor
-                            int hp = veh->cpart( part ).hp();
-                            if( hp / 20 > bash ) {
-                                // Threshold damage thing means we just can't bash this down
-                                layer.state[index] = ASL_CLOSED;
-                                continue;
-                            } else if( hp / 10 > bash ) {
-                                // Threshold damage thing means we will fail to deal damage pretty often
-                                hp *= 2;
-                            }
-
-                            newg += 2 * hp / bash + 8 + 4;
-                        } else if( part >= 0 ) {
-                            if( !doors || !veh->part_flag( part, VPFLAG_OPENABLE ) ) {
-                                // Won't be openable, don't try from other sides
-                                layer.state[index] = ASL_CLOSED;
-                            }
-
-                            continue;
-                        }
-                    } else if( rating > 1 ) {
-                        // Expected number of turns to bash it down, 1 turn to move there
-                        // and 5 turns of penalty not to trash everything just because we can
-                        newg += ( 20 / rating ) + 2 + 10;
-                    } else if( rating == 1 ) {
-                        // Desperate measures, avoid whenever possible
-                        newg += 500;
-                    } else {
-                        // Unbashable and unopenable from here
-                        if( !doors || !terrain.open || !furniture.open ) {
-                            // Or anywhere else for that matter
-                            layer.state[index] = ASL_CLOSED;
-                        }
-
-                        continue;
-                    }
-                }
-
-                if( trapavoid && p_special & PF_TRAP ) {
-                    const auto &ter_trp = terrain.trap.obj();
-                    const auto &trp = ter_trp.is_benign() ? tile.get_trap_t() : ter_trp;
-                    if( !trp.is_benign() ) {
-                        // For now make them detect all traps
-                        if( has_zlevels() && terrain.has_flag( TFLAG_NO_FLOOR ) ) {
-                            // Special case - ledge in z-levels
-                            // Warning: really expensive, needs a cache
-                            if( valid_move( p, tripoint( p.xy(), p.z - 1 ), false, true ) ) {
-                                tripoint below( p.xy(), p.z - 1 );
-                                if( !has_flag( TFLAG_NO_FLOOR, below ) ) {
-                                    // Otherwise this would have been a huge fall
-                                    auto &layer = pf.get_layer( p.z - 1 );
-                                    // From cur, not p, because we won't be walking on air
-                                    pf.add_point( layer.gscore[parent_index] + 10,
-                                                  layer.score[parent_index] + 10 + 2 * rl_dist( below, t ),
-                                                  cur, below );
-                                }
-
-                                // Close p, because we won't be walking on it
-                                layer.state[index] = ASL_CLOSED;
-                                continue;
-                            }
-                        } else if( trapavoid ) {
-                            // Otherwise it's walkable
-                            newg += 500;
-                        }
-                    }
-                }
-
-                if( sharpavoid && p_special & PF_SHARP ) {
-                    layer.state[index] = ASL_CLOSED; // Avoid sharp things
-                }
-
-            }
+            const int newg = layer.gscore[parent_index] + ( ( cur.x != p.x && cur.y != p.y ) ? 1 : 0 ) +
+                             step.cost;
 
             // If not visited, add as open
             // If visited, add it only if we can do so with better score
-            if( layer.state[index] == ASL_NONE || newg < layer.gscore[index] ) {
+            if( layer.get_state( index ) == ASL_NONE || newg < layer.gscore[index] ) {
                 pf.add_point( newg, newg + 2 * rl_dist( p, t ), cur, p );
             }
         }
@@ -471,48 +573,43 @@ std::vector<tripoint> map::route( const tripoint &f, const tripoint &t,
         if( settings.allow_climb_stairs && cur.z > minz && parent_terrain.has_flag( TFLAG_GOES_DOWN ) ) {
             tripoint dest( cur.xy(), cur.z - 1 );
             if( vertical_move_destination<TFLAG_GOES_UP>( *this, dest ) ) {
-                auto &layer = pf.get_layer( dest.z );
                 pf.add_point( layer.gscore[parent_index] + 2,
-                              layer.score[parent_index] + 2 * rl_dist( dest, t ),
+                              layer.gscore[parent_index] + 2 * rl_dist( dest, t ),
                               cur, dest );
             }
         }
         if( settings.allow_climb_stairs && cur.z < maxz && parent_terrain.has_flag( TFLAG_GOES_UP ) ) {
             tripoint dest( cur.xy(), cur.z + 1 );
             if( vertical_move_destination<TFLAG_GOES_DOWN>( *this, dest ) ) {
-                auto &layer = pf.get_layer( dest.z );
                 pf.add_point( layer.gscore[parent_index] + 2,
-                              layer.score[parent_index] + 2 * rl_dist( dest, t ),
+                              layer.gscore[parent_index] + 2 * rl_dist( dest, t ),
                               cur, dest );
             }
         }
         if( cur.z < maxz && parent_terrain.has_flag( TFLAG_RAMP ) &&
             valid_move( cur, tripoint( cur.xy(), cur.z + 1 ), false, true ) ) {
-            auto &layer = pf.get_layer( cur.z + 1 );
             for( size_t it = 0; it < 8; it++ ) {
                 const tripoint above( cur.x + x_offset[it], cur.y + y_offset[it], cur.z + 1 );
                 pf.add_point( layer.gscore[parent_index] + 4,
-                              layer.score[parent_index] + 4 + 2 * rl_dist( above, t ),
+                              layer.gscore[parent_index] + 4 + 2 * rl_dist( above, t ),
                               cur, above );
             }
         }
         if( cur.z < maxz && parent_terrain.has_flag( TFLAG_RAMP_UP ) &&
             valid_move( cur, tripoint( cur.xy(), cur.z + 1 ), false, true, true ) ) {
-            auto &layer = pf.get_layer( cur.z + 1 );
             for( size_t it = 0; it < 8; it++ ) {
                 const tripoint above( cur.x + x_offset[it], cur.y + y_offset[it], cur.z + 1 );
                 pf.add_point( layer.gscore[parent_index] + 4,
-                              layer.score[parent_index] + 4 + 2 * rl_dist( above, t ),
+                              layer.gscore[parent_index] + 4 + 2 * rl_dist( above, t ),
                               cur, above );
             }
         }
         if( cur.z > minz && parent_terrain.has_flag( TFLAG_RAMP_DOWN ) &&
             valid_move( cur, tripoint( cur.xy(), cur.z - 1 ), false, true, true ) ) {
-            auto &layer = pf.get_layer( cur.z - 1 );
             for( size_t it = 0; it < 8; it++ ) {
                 const tripoint below( cur.x + x_offset[it], cur.y + y_offset[it], cur.z - 1 );
                 pf.add_point( layer.gscore[parent_index] + 4,
-                              layer.score[parent_index] + 4 + 2 * rl_dist( below, t ),
+                              layer.gscore[parent_index] + 4 + 2 * rl_dist( below, t ),
                               cur, below );
             }
         }
@@ -548,3 +645,28 @@ std::vector<tripoint> map::route( const tripoint &f, const tripoint &t,
 
     return ret;
 }
+
+cata::optional<std::vector<tripoint>> map::route_through_portals( const tripoint &f,
+                                      const tripoint &t, const pathfinding_settings &settings,
+                                      const std::set<tripoint> &pre_closed ) const
+{
+    const cata::optional<std::vector<tripoint>> waypoints = portal_graphs->get( settings ).waypoints(
+                *this, f, t );
+    if( !waypoints || waypoints->empty() ) {
+        // Either the graph can't tell, or there is no route at all.
+        return waypoints;
+    }
+    // The graph goes through the middle of each run of border tiles, the search through
+    // the submaps around its route finds the shortest way through them.
+    route_corridor corridor;
+    for( const tripoint &p : *waypoints ) {
+        corridor.add_around( p );
+    }
+    std::vector<tripoint> ret = search_route( f, t, settings, pre_closed, &corridor );
+    if( ret.empty() ) {
+        // The graph doesn't know about pre_closed, and the shortest route may be too long
+        // within the corridor but not outside of it. Only a full search can tell.
+        return cata::nullopt;
+    }
+    return ret;
+}
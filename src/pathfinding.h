@@ -2,8 +2,14 @@
 #ifndef CATA_SRC_PATHFINDING_H
 #define CATA_SRC_PATHFINDING_H
 
+#include <bitset>
+#include <vector>
+
 #include "game_constants.h"
 
+class map;
+struct tripoint;
+
 enum pf_special : int {
     PF_NORMAL = 0x00,    // Plain boring tile (grass, dirt, floor etc.)
     PF_SLOW = 0x01,      // Tile with move cost >2
@@ -38,11 +44,26 @@ inline pf_special &operator &= ( pf_special &lhs, pf_special rhs )
     return lhs;
 }
 
+// Tiles that need more than a look at the pathfinding cache
+constexpr pf_special pf_non_normal = PF_SLOW | PF_WALL | PF_VEHICLE | PF_TRAP | PF_SHARP;
+
+/** How much of the pathfinding caches had to be rebuilt, for the debug timer. */
+struct pathfinding_cache_stats {
+    int full_rebuilds = 0;
+    // Submaps rebuilt by partial updates, and the ones those could keep
+    int submaps_rebuilt = 0;
+    int submaps_kept = 0;
+};
+
 struct pathfinding_cache {
     pathfinding_cache();
     ~pathfinding_cache();
 
+    // All of the level has to be rebuilt
     bool dirty;
+    // Submaps that changed since the last update, indexed by x * MAPSIZE + y like the other submap caches
+    std::bitset<MAPSIZE *MAPSIZE> dirty_submaps;
+    pathfinding_cache_stats stats;
 
     pf_special special[MAPSIZE_X][MAPSIZE_Y];
 };
@@ -71,6 +92,40 @@ struct pathfinding_settings {
           allow_open_doors( aod ), avoid_traps( at ), allow_climb_stairs( acs ), avoid_rough_terrain( art ),
           avoid_sharp( as ) {}
     pathfinding_settings &operator = ( const pathfinding_settings & ) = default;
+
+    bool operator==( const pathfinding_settings &rhs ) const;
 };
 
+/** Stepping onto a neighboring tile in @ref map::route, see @ref map::route_step_cost. */
+struct route_step {
+    enum class kind : int {
+        // Moves there for cost
+        enter,
+        // Not from this neighbor, others may still get there
+        blocked_from_here,
+        // Not from any neighbor
+        blocked,
+        // A ledge, routes drop to the tile below it instead for cost
+        drop,
+    };
+    kind what = kind::blocked;
+    int cost = 0;
+};
+
+// Routes between points further apart than this are planned over the submaps first.
+// Each leg of those is shorter, so they are never planned that way themselves.
+constexpr int hierarchical_route_dist = SEEX * 2;
+
+/**
+ * The straight line from @p f to @p t, which @ref map::route takes without searching if
+ * it only crosses plain tiles. Empty if it doesn't.
+ */
+std::vector<tripoint> plain_line_route( const map &m, const tripoint &f, const tripoint &t );
+
+/**
+ * Moves @p t, which has to be on the z-level stairs at the same x/y lead to, onto the tile
+ * they arrive on. @p going_up is the direction of travel. Returns false if there is none.
+ */
+bool stairs_destination( const map &m, tripoint &t, bool going_up );
+
 #endif // CATA_SRC_PATHFINDING_H
@@ -0,0 +1,671 @@
+#include "portal_graph.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <unordered_map>
+
+#include "bucket_queue.h"
+#include "line.h"
+#include "map.h"
+#include "mapdata.h"
+
+// Diagonals come last, like in map::route.
+static constexpr std::array<point, 8> neighbor_offsets = {{
+        point_west, point_east, point_north, point_south,
+        point_north_east, point_south_west, point_north_west, point_south_east
+    }
+};
+
+static constexpr size_t max_cached_graphs = 8;
+static constexpr int unreachable = INT_MAX;
+
+// Search keys are the z-level and node index packed into one int.
+static constexpr int index_bits = 20;
+static constexpr int start_key = -1;
+static constexpr int goal_key = -2;
+
+// Step costs besides the ones of entering a tile. Drops cost drop_step minus the step cost.
+static constexpr int16_t blocked_step = -1;
+static constexpr int16_t drop_step = -2;
+// In level::enter_cost for tiles that have their costs in level::varying_costs
+static constexpr int16_t varying_step = INT16_MIN;
+
+static int flat_index( point p )
+{
+    return p.x * MAPSIZE_Y + p.y;
+}
+
+static int direction_of( point offset )
+{
+    return std::find( neighbor_offsets.begin(), neighbor_offsets.end(), offset ) -
+           neighbor_offsets.begin();
+}
+
+static int16_t encode_step( const route_step &step )
+{
+    switch( step.what ) {
+        case route_step::kind::enter:
+            return step.cost;
+        case route_step::kind::drop:
+            return drop_step - step.cost;
+        default:
+            return blocked_step;
+    }
+}
+
+static int submap_index( point p )
+{
+    return ( p.x % SEEX ) * SEEY + p.y % SEEY;
+}
+
+static int submap_of( point p, const int mapsize )
+{
+    return ( p.x / SEEX ) * mapsize + p.y / SEEY;
+}
+
+static int make_key( const int zlev, const int index )
+{
+    return ( ( zlev + OVERMAP_DEPTH ) << index_bits ) | index;
+}
+
+// Only these settings change the graph, lengths are checked by each search.
+static bool same_costs( const pathfinding_settings &lhs, const pathfinding_settings &rhs )
+{
+    return lhs.bash_strength == rhs.bash_strength && lhs.climb_cost == rhs.climb_cost &&
+           lhs.allow_open_doors == rhs.allow_open_doors && lhs.avoid_traps == rhs.avoid_traps &&
+           lhs.allow_climb_stairs == rhs.allow_climb_stairs &&
+           lhs.avoid_rough_terrain == rhs.avoid_rough_terrain && lhs.avoid_sharp == rhs.avoid_sharp;
+}
+
+void route_corridor::add_around( const tripoint &p )
+{
+    const point sm( p.x / SEEX, p.y / SEEY );
+    for( int sx = std::max( sm.x - 1, 0 ); sx <= std::min( sm.x + 1, MAPSIZE - 1 ); sx++ ) {
+        for( int sy = std::max( sm.y - 1, 0 ); sy <= std::min( sm.y + 1, MAPSIZE - 1 ); sy++ ) {
+            submaps[p.z + OVERMAP_DEPTH].set( sx * MAPSIZE + sy );
+        }
+    }
+}
+
+int portal_graph::level::step_cost( point to, const int dir ) const
+{
+    const int index = flat_index( to );
+    const int16_t cost = enter_cost[index];
+    return cost == varying_step ? varying_costs.at( index )[dir] : cost;
+}
+
+portal_graph::submap_costs portal_graph::local_costs( const level &lev, const point start )
+{
+    static cata::bucket_queue<point> open;
+    open.clear();
+    const point origin( start.x - start.x % SEEX, start.y - start.y % SEEY );
+    submap_costs costs;
+    costs.fill( unreachable );
+    costs[submap_index( start )] = 0;
+    open.push( 0, start );
+    while( !open.empty() ) {
+        const int dist = open.top_priority();
+        const point cur = open.pop();
+        if( dist > costs[submap_index( cur )] ) {
+            continue;
+        }
+        for( size_t i = 0; i < neighbor_offsets.size(); i++ ) {
+            const point next = cur + neighbor_offsets[i];
+            if( next.x < origin.x || next.x >= origin.x + SEEX ||
+                next.y < origin.y || next.y >= origin.y + SEEY ) {
+                continue;
+            }
+            const int enter = lev.step_cost( next, i );
+            if( enter < 0 ) {
+                continue;
+            }
+            const int next_dist = dist + enter + ( i >= 4 ? 1 : 0 );
+            int &known = costs[submap_index( next )];
+            if( next_dist < known ) {
+                known = next_dist;
+                open.push( next_dist, next );
+            }
+        }
+    }
+    return costs;
+}
+
+portal_graph::portal_graph( const pathfinding_settings &settings ) : settings_( settings )
+{
+}
+
+portal_graph::level &portal_graph::get_level( const map &m, const int zlev )
+{
+    level &lev = levels[zlev + OVERMAP_DEPTH];
+    if( !lev.built ) {
+        build( m, zlev, lev );
+    } else if( lev.dirty.any() ) {
+        update( m, zlev, lev );
+    }
+    return lev;
+}
+
+void portal_graph::invalidate( const int zlev )
+{
+    const int minz = std::max( zlev - 1, -OVERMAP_DEPTH );
+    const int maxz = std::min( zlev + 1, OVERMAP_HEIGHT );
+    for( int z = minz; z <= maxz; z++ ) {
+        levels[z + OVERMAP_DEPTH] = level();
+    }
+}
+
+void portal_graph::invalidate( const tripoint &p )
+{
+    const point sm( p.x / SEEX, p.y / SEEY );
+    const int minz = std::max( p.z - 1, -OVERMAP_DEPTH );
+    const int maxz = std::min( p.z + 1, OVERMAP_HEIGHT );
+    for( int z = minz; z <= maxz; z++ ) {
+        level &lev = levels[z + OVERMAP_DEPTH];
+        if( !lev.built ) {
+            continue;
+        }
+        // Stairs lead anywhere on their overmap terrain and ramps to the tiles next to them,
+        // both are within a submap of the one that changed.
+        const int radius = z == p.z ? 0 : 1;
+        for( int sx = sm.x - radius; sx <= sm.x + radius; sx++ ) {
+            for( int sy = sm.y - radius; sy <= sm.y + radius; sy++ ) {
+                if( sx >= 0 && sx < lev.mapsize && sy >= 0 && sy < lev.mapsize ) {
+                    lev.dirty.set( sx * lev.mapsize + sy );
+                }
+            }
+        }
+    }
+}
+
+void portal_graph::build( const map &m, const int zlev, level &lev ) const
+{
+    lev = level();
+    lev.built = true;
+    lev.mapsize = m.getmapsize();
+    lev.submap_nodes.resize( lev.mapsize * lev.mapsize );
+    lev.enter_cost.assign( MAPSIZE_X * MAPSIZE_Y, blocked_step );
+    for( int i = 0; i < lev.mapsize * lev.mapsize; i++ ) {
+        lev.dirty.set( i );
+    }
+    update( m, zlev, lev );
+}
+
+void portal_graph::update( const map &m, const int zlev, level &lev ) const
+{
+    const int size = lev.mapsize * SEEX;
+    const std::bitset<MAPSIZE *MAPSIZE> dirty = lev.dirty;
+    lev.dirty.reset();
+    const auto is_dirty = [&]( const point sm ) {
+        return sm.x >= 0 && sm.x < lev.mapsize && sm.y >= 0 && sm.y < lev.mapsize &&
+               dirty[sm.x * lev.mapsize + sm.y];
+    };
+    const auto in_map = [size]( const point p ) {
+        return p.x >= 0 && p.x < size && p.y >= 0 && p.y < size;
+    };
+    const pathfinding_cache &pf_cache = m.get_pathfinding_cache_ref( zlev );
+
+    // Steps onto, within and off the changed submaps. Plain tiles without vehicles next to
+    // them cost the same from everywhere, like in map::route_step_cost.
+    std::vector<bool> costs_done( size * size );
+    const auto update_costs = [&]( const point to ) {
+        const int index = flat_index( to );
+        if( lev.enter_cost[index] == varying_step ) {
+            lev.varying_costs.erase( index );
+        }
+        bool near_vehicle = false;
+        for( const point &offset : neighbor_offsets ) {
+            const point from = to - offset;
+            if( in_map( from ) && ( pf_cache.special[from.x][from.y] & PF_VEHICLE ) ) {
+                near_vehicle = true;
+                break;
+            }
+        }
+        if( !near_vehicle && !( pf_cache.special[to.x][to.y] & pf_non_normal ) ) {
+            lev.enter_cost[index] = 2;
+            return;
+        }
+        std::array<int16_t, 8> costs;
+        costs.fill( blocked_step );
+        cata::optional<int16_t> same;
+        bool varying = false;
+        for( size_t i = 0; i < neighbor_offsets.size(); i++ ) {
+            const point from = to - neighbor_offsets[i];
+            if( !in_map( from ) ) {
+                continue;
+            }
+            costs[i] = encode_step( m.route_step_cost( pf_cache, tripoint( from, zlev ),
+                                    tripoint( to, zlev ), settings_ ) );
+            if( !same ) {
+                same = costs[i];
+            } else if( *same != costs[i] ) {
+                varying = true;
+            }
+        }
+        if( varying ) {
+            lev.enter_cost[index] = varying_step;
+            lev.varying_costs[index] = costs;
+        } else {
+            lev.enter_cost[index] = same ? *same : blocked_step;
+        }
+    };
+    for( int sx = 0; sx < lev.mapsize; sx++ ) {
+        for( int sy = 0; sy < lev.mapsize; sy++ ) {
+            if( !is_dirty( point( sx, sy ) ) ) {
+                continue;
+            }
+            for( int x = std::max( sx * SEEX - 1, 0 ); x <= std::min( sx * SEEX + SEEX, size - 1 ); x++ ) {
+                for( int y = std::max( sy * SEEY - 1, 0 ); y <= std::min( sy * SEEY + SEEY, size - 1 ); y++ ) {
+                    if( !costs_done[x * size + y] ) {
+                        costs_done[x * size + y] = true;
+                        update_costs( point( x, y ) );
+                    }
+                }
+            }
+        }
+    }
+
+    // The nodes of the changed submaps are built from scratch, portals to them from
+    // their neighbors are dropped.
+    for( int i = 0; i < lev.mapsize * lev.mapsize; i++ ) {
+        if( !dirty[i] ) {
+            continue;
+        }
+        for( const int index : lev.submap_nodes[i] ) {
+            lev.node_at.erase( lev.nodes[index].pos );
+            lev.nodes[index] = node();
+            lev.nodes[index].removed = true;
+            lev.free_nodes.push_back( index );
+        }
+        lev.submap_nodes[i].clear();
+    }
+    for( int sx = 0; sx < lev.mapsize; sx++ ) {
+        for( int sy = 0; sy < lev.mapsize; sy++ ) {
+            const point sm( sx, sy );
+            if( is_dirty( sm ) || !( is_dirty( sm + point_west ) || is_dirty( sm + point_east ) ||
+                                     is_dirty( sm + point_north ) || is_dirty( sm + point_south ) ) ) {
+                continue;
+            }
+            for( const int index : lev.submap_nodes[sx * lev.mapsize + sy] ) {
+                std::vector<edge> &edges = lev.nodes[index].edges;
+                edges.erase( std::remove_if( edges.begin(), edges.end(), [&lev]( const edge & e ) {
+                    return lev.nodes[e.to].removed;
+                } ), edges.end() );
+            }
+        }
+    }
+
+    // Submaps with new nodes, their nodes have to be connected again.
+    std::bitset<MAPSIZE *MAPSIZE> relink = dirty;
+    const auto add_node = [&]( const point p ) {
+        const tripoint pos( p, zlev );
+        const auto iter = lev.node_at.find( pos );
+        if( iter != lev.node_at.end() ) {
+            return iter->second;
+        }
+        int index = lev.nodes.size();
+        if( lev.free_nodes.empty() ) {
+            lev.nodes.emplace_back();
+        } else {
+            index = lev.free_nodes.back();
+            lev.free_nodes.pop_back();
+        }
+        lev.nodes[index] = node();
+        lev.nodes[index].pos = pos;
+        const int sm = submap_of( p, lev.mapsize );
+        lev.submap_nodes[sm].push_back( index );
+        relink.set( sm );
+        lev.node_at.emplace( pos, index );
+        return index;
+    };
+    const auto step_cost = [&lev]( const point to, const int dir ) {
+        return lev.step_cost( to, dir );
+    };
+
+    // A pair of portals in the middle of each run of tiles that lead to the neighboring submap
+    // and back, on each border of a changed submap. The tiles of a run are connected along
+    // the border on both sides, so any step across the run can go through its portals instead.
+    // 1 and 3 are east and south, the opposite directions are one lower.
+    for( const int forward : {
+             1, 3
+         } ) {
+        const int backward = forward ^ 1;
+        const point dir = neighbor_offsets[forward];
+        const point along( dir.y, dir.x );
+        const int next = direction_of( along );
+        const int prev = next ^ 1;
+        for( int sx = 0; sx + dir.x < lev.mapsize; sx++ ) {
+            for( int sy = 0; sy + dir.y < lev.mapsize; sy++ ) {
+                if( !is_dirty( point( sx, sy ) ) && !is_dirty( point( sx, sy ) + dir ) ) {
+                    continue;
+                }
+                const point border( sx * SEEX + dir.x * ( SEEX - 1 ),
+                                    sy * SEEY + dir.y * ( SEEY - 1 ) );
+                std::array<int, SEEX> run_of;
+                run_of.fill( -1 );
+                int runs = 0;
+                int run_start = -1;
+                for( int i = 0; i <= SEEX; i++ ) {
+                    const point near = border + along * i;
+                    const bool open = i < SEEX && step_cost( near + dir, forward ) >= 0 &&
+                                      step_cost( near, backward ) >= 0;
+                    const bool joined = open && run_start >= 0 &&
+                                        step_cost( near, next ) >= 0 && step_cost( near - along, prev ) >= 0 &&
+                                        step_cost( near + dir, next ) >= 0 && step_cost( near + dir - along, prev ) >= 0;
+                    if( run_start >= 0 && !joined ) {
+                        const point portal = border + along * ( ( run_start + i - 1 ) / 2 );
+                        const int here = add_node( portal );
+                        const int there = add_node( portal + dir );
+                        lev.nodes[here].edges.push_back( edge{ there, step_cost( portal + dir, forward ) } );
+                        lev.nodes[there].edges.push_back( edge{ here, step_cost( portal, backward ) } );
+                        std::fill( run_of.begin() + run_start, run_of.begin() + i, runs );
+                        runs++;
+                        run_start = -1;
+                    }
+                    if( open && run_start < 0 ) {
+                        run_start = i;
+                    }
+                }
+                // Everything else that crosses the border.
+                for( int i = 0; i < SEEX; i++ ) {
+                    const point near = border + along * i;
+                    for( int j = std::max( i - 1, 0 ); j <= std::min( i + 1, SEEX - 1 ); j++ ) {
+                        if( run_of[i] >= 0 && run_of[i] == run_of[j] ) {
+                            continue;
+                        }
+                        const point far = border + dir + along * j;
+                        const int there_dir = direction_of( far - near );
+                        // Penalize diagonals, like map::route
+                        const int diagonal = i != j ? 1 : 0;
+                        const int there_cost = step_cost( far, there_dir );
+                        const int back_cost = step_cost( near, there_dir ^ 1 );
+                        if( there_cost < 0 && back_cost < 0 ) {
+                            continue;
+                        }
+                        const int here = add_node( near );
+                        const int there = add_node( far );
+                        if( there_cost >= 0 ) {
+                            lev.nodes[here].edges.push_back( edge{ there, there_cost + diagonal } );
+                        }
+                        if( back_cost >= 0 ) {
+                            lev.nodes[there].edges.push_back( edge{ here, back_cost + diagonal } );
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    if( settings_.allow_climb_stairs && m.has_zlevels() ) {
+        for( int x = 0; x < size; x++ ) {
+            for( int y = 0; y < size; y++ ) {
+                if( !( pf_cache.special[x][y] & PF_UPDOWN ) || !is_dirty( point( x / SEEX, y / SEEY ) ) ) {
+                    continue;
+                }
+                const tripoint p( x, y, zlev );
+                const ter_t &terrain = m.ter( p ).obj();
+                std::vector<std::pair<tripoint, int>> vertical;
+                // Same costs as in map::route
+                if( zlev > -OVERMAP_DEPTH && terrain.has_flag( TFLAG_GOES_DOWN ) ) {
+                    tripoint dest( x, y, zlev - 1 );
+                    if( stairs_destination( m, dest, false ) ) {
+                        vertical.emplace_back( dest, 2 );
+                    }
+                }
+                if( zlev < OVERMAP_HEIGHT && terrain.has_flag( TFLAG_GOES_UP ) ) {
+                    tripoint dest( x, y, zlev + 1 );
+                    if( stairs_destination( m, dest, true ) ) {
+                        vertical.emplace_back( dest, 2 );
+                    }
+                }
+                const auto add_ramp = [&]( const int dz ) {
+                    for( const point &offset : neighbor_offsets ) {
+                        vertical.emplace_back( tripoint( p.xy() + offset, zlev + dz ), 4 );
+                    }
+                };
+                const tripoint above( p.xy(), zlev + 1 );
+                const tripoint below( p.xy(), zlev - 1 );
+                if( zlev < OVERMAP_HEIGHT && ( ( terrain.has_flag( TFLAG_RAMP ) &&
+                                                 m.valid_move( p, above, false, true ) ) ||
+                                               ( terrain.has_flag( TFLAG_RAMP_UP ) &&
+                                                 m.valid_move( p, above, false, true, true ) ) ) ) {
+                    add_ramp( 1 );
+                }
+                if( zlev > -OVERMAP_DEPTH && terrain.has_flag( TFLAG_RAMP_DOWN ) &&
+                    m.valid_move( p, below, false, true, true ) ) {
+                    add_ramp( -1 );
+                }
+                if( !vertical.empty() ) {
+                    const int index = add_node( p.xy() );
+                    std::vector<std::pair<tripoint, int>> &node_vertical = lev.nodes[index].vertical;
+                    node_vertical.insert( node_vertical.end(), vertical.begin(), vertical.end() );
+                }
+            }
+        }
+    }
+
+    // Ledges drop routes to the tile below them, only routes that avoid traps see them.
+    const bool drops = settings_.avoid_traps && m.has_zlevels();
+    if( drops && zlev > -OVERMAP_DEPTH ) {
+        for( int x = 0; x < size; x++ ) {
+            for( int y = 0; y < size; y++ ) {
+                if( !is_dirty( point( x / SEEX, y / SEEY ) ) ) {
+                    continue;
+                }
+                const point from( x, y );
+                for( size_t i = 0; i < neighbor_offsets.size(); i++ ) {
+                    const point to = from + neighbor_offsets[i];
+                    if( !in_map( to ) ) {
+                        continue;
+                    }
+                    const int cost = step_cost( to, i );
+                    if( cost <= drop_step ) {
+                        const int index = add_node( from );
+                        lev.nodes[index].vertical.emplace_back( tripoint( to, zlev - 1 ), drop_step - cost );
+                    }
+                }
+            }
+        }
+    }
+
+    // Ramps and ledges on the neighboring levels need nodes to arrive on.
+    for( const int dz : {
+             -1, 1
+         } ) {
+        if( !m.has_zlevels() || !m.inbounds_z( zlev + dz ) ) {
+            continue;
+        }
+        const pathfinding_cache &other_cache = m.get_pathfinding_cache_ref( zlev + dz );
+        for( int x = 0; x < size; x++ ) {
+            for( int y = 0; y < size; y++ ) {
+                const bool ramp = settings_.allow_climb_stairs && ( other_cache.special[x][y] & PF_UPDOWN );
+                const bool ledge = drops && dz > 0 && ( other_cache.special[x][y] & PF_TRAP );
+                if( !ramp && !ledge ) {
+                    continue;
+                }
+                const ter_t &terrain = m.ter( tripoint( x, y, zlev + dz ) ).obj();
+                if( ledge && terrain.has_flag( TFLAG_NO_FLOOR ) && is_dirty( point( x / SEEX, y / SEEY ) ) ) {
+                    add_node( point( x, y ) );
+                }
+                const bool leads_here = ramp && ( dz < 0 ?
+                                                  terrain.has_flag( TFLAG_RAMP ) ||
+                                                  terrain.has_flag( TFLAG_RAMP_UP ) :
+                                                  terrain.has_flag( TFLAG_RAMP_DOWN ) );
+                if( !leads_here ) {
+                    continue;
+                }
+                // map::route arrives on all of them, whether they can be entered or not.
+                for( const point &offset : neighbor_offsets ) {
+                    const point arrival = point( x, y ) + offset;
+                    if( in_map( arrival ) && is_dirty( point( arrival.x / SEEX, arrival.y / SEEY ) ) ) {
+                        add_node( arrival );
+                    }
+                }
+            }
+        }
+    }
+
+    // Connect the nodes on each submap that changed or got new nodes, the portals to other
+    // submaps are kept.
+    for( int i = 0; i < lev.mapsize * lev.mapsize; i++ ) {
+        if( !relink[i] ) {
+            continue;
+        }
+        const std::vector<int> &nodes = lev.submap_nodes[i];
+        for( const int from : nodes ) {
+            std::vector<edge> &edges = lev.nodes[from].edges;
+            edges.erase( std::remove_if( edges.begin(), edges.end(), [&]( const edge & e ) {
+                return submap_of( lev.nodes[e.to].pos.xy(), lev.mapsize ) == i;
+            } ), edges.end() );
+            const submap_costs costs = local_costs( lev, lev.nodes[from].pos.xy() );
+            for( const int to : nodes ) {
+                const int cost = costs[submap_index( lev.nodes[to].pos.xy() )];
+                if( to != from && cost != unreachable ) {
+                    edges.push_back( edge{ to, cost } );
+                }
+            }
+        }
+    }
+}
+
+cata::optional<std::vector<tripoint>> portal_graph::waypoints( const map &m,
+                                    const tripoint &from, const tripoint &to )
+{
+    if( !m.inbounds( from ) || !m.inbounds( to ) ) {
+        return cata::nullopt;
+    }
+    std::vector<tripoint> result;
+    const int minz = std::min( from.z, to.z );
+    const int maxz = std::max( from.z, to.z );
+    level &start_level = get_level( m, from.z );
+    level &goal_level = get_level( m, to.z );
+
+    // Nodes on the submap of the goal can go there directly.
+    std::unordered_map<int, int> goal_costs;
+    for( const int index : goal_level.submap_nodes[submap_of( to.xy(), goal_level.mapsize )] ) {
+        const int cost = local_costs( goal_level,
+                                      goal_level.nodes[index].pos.xy() )[submap_index( to.xy() )];
+        if( cost != unreachable ) {
+            goal_costs.emplace( index, cost );
+        }
+    }
+    if( goal_costs.empty() ) {
+        return result;
+    }
+
+    std::unordered_map<int, int> gscore;
+    std::unordered_map<int, int> parent;
+    cata::bucket_queue<int> open;
+    const auto position = [&]( const int key ) {
+        if( key == goal_key ) {
+            return to;
+        }
+        const int zlev = ( key >> index_bits ) - OVERMAP_DEPTH;
+        return levels[zlev + OVERMAP_DEPTH].nodes[key & ( ( 1 << index_bits ) - 1 )].pos;
+    };
+    // Not limited by the max length of the settings, the graph may take detours map::route doesn't.
+    const auto add = [&]( const int key, const int g, const int from_key ) {
+        const auto iter = gscore.find( key );
+        if( iter != gscore.end() && iter->second <= g ) {
+            return;
+        }
+        gscore[key] = g;
+        parent[key] = from_key;
+        open.push( g + 2 * rl_dist( position( key ), to ), key );
+    };
+
+    const submap_costs start_costs = local_costs( start_level, from.xy() );
+    for( const int index : start_level.submap_nodes[submap_of( from.xy(), start_level.mapsize )] ) {
+        const int cost = start_costs[submap_index( start_level.nodes[index].pos.xy() )];
+        if( cost != unreachable ) {
+            add( make_key( from.z, index ), cost, start_key );
+        }
+    }
+
+    bool found = false;
+    while( !open.empty() ) {
+        const int score = open.top_priority();
+        const int cur = open.pop();
+        const int g = gscore[cur];
+        const tripoint cur_pos = position( cur );
+        if( score > g + 2 * rl_dist( cur_pos, to ) ) {
+            // Found a cheaper way here after this was queued.
+            continue;
+        }
+        if( cur == goal_key ) {
+            found = true;
+            break;
+        }
+
+        const int index = cur & ( ( 1 << index_bits ) - 1 );
+        const node &cur_node = levels[cur_pos.z + OVERMAP_DEPTH].nodes[index];
+        for( const edge &e : cur_node.edges ) {
+            add( make_key( cur_pos.z, e.to ), g + e.cost, cur );
+        }
+        if( cur_pos.z == to.z ) {
+            const auto iter = goal_costs.find( index );
+            if( iter != goal_costs.end() ) {
+                add( goal_key, g + iter->second, cur );
+            }
+        }
+        for( const std::pair<tripoint, int> &vertical : cur_node.vertical ) {
+            const tripoint &dest = vertical.first;
+            if( dest.z < minz || dest.z > maxz || !m.inbounds( dest ) ) {
+                continue;
+            }
+            const level &dest_level = get_level( m, dest.z );
+            const auto iter = dest_level.node_at.find( dest );
+            if( iter != dest_level.node_at.end() ) {
+                add( make_key( dest.z, iter->second ), g + vertical.second, cur );
+            }
+        }
+    }
+
+    if( !found ) {
+        return result;
+    }
+    for( int key = goal_key; key != start_key; key = parent[key] ) {
+        result.push_back( position( key ) );
+    }
+    result.push_back( from );
+    std::reverse( result.begin(), result.end() );
+    // The ends may be nodes themselves.
+    result.erase( std::unique( result.begin(), result.end() ), result.end() );
+    return result;
+}
+
+portal_graph &portal_graph_cache::get( const pathfinding_settings &settings )
+{
+    const auto iter = std::find_if( graphs.begin(), graphs.end(),
+    [&settings]( const std::unique_ptr<portal_graph> &graph ) {
+        return same_costs( graph->settings(), settings );
+    } );
+    if( iter != graphs.end() ) {
+        std::rotate( graphs.begin(), iter, std::next( iter ) );
+    } else {
+        if( graphs.size() >= max_cached_graphs ) {
+            graphs.pop_back();
+        }
+        graphs.insert( graphs.begin(), std::make_unique<portal_graph>( settings ) );
+    }
+    return *graphs.front();
+}
+
+void portal_graph_cache::invalidate( const int zlev )
+{
+    for( std::unique_ptr<portal_graph> &graph : graphs ) {
+        graph->invalidate( zlev );
+    }
+}
+
+void portal_graph_cache::invalidate( const tripoint &p )
+{
+    for( std::unique_ptr<portal_graph> &graph : graphs ) {
+        graph->invalidate( p );
+    }
+}
+
+void portal_graph_cache::clear()
+{
+    graphs.clear();
+}
@@ -0,0 +1,140 @@
+#pragma once
+#ifndef CATA_SRC_PORTAL_GRAPH_H
+#define CATA_SRC_PORTAL_GRAPH_H
+
+#include <array>
+#include <bitset>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "game_constants.h"
+#include "optional.h"
+#include "pathfinding.h"
+#include "point.h"
+
+class map;
+
+/** Submaps of the reality bubble a tile by tile search may go through, on each z-level. */
+struct route_corridor {
+    std::array<std::bitset<MAPSIZE *MAPSIZE>, OVERMAP_LAYERS> submaps;
+
+    /** Add the submap of @p p and the ones around it. */
+    void add_around( const tripoint &p );
+    bool contains( const tripoint &p ) const {
+        return submaps[p.z + OVERMAP_DEPTH][( p.x / SEEX ) * MAPSIZE + p.y / SEEY];
+    }
+};
+
+/**
+ * Coarse routes over the submaps of the reality bubble, used by @ref map::route for
+ * long routes and routes to other z-levels.
+ *
+ * Where two neighboring submaps can be walked between, each run of passable border
+ * tiles gets a node (portal) on both sides. Steps across a border that no run covers,
+ * diagonal or one way ones, get nodes of their own. Stairs, ramps and ledges are nodes
+ * too, connected to the tiles they lead to on the other z-level. Nodes on the same submap
+ * are connected by the cost of the shortest route between them that stays on the submap,
+ * using the same tile costs as @ref map::route. So every route @ref map::route can find
+ * has a counterpart in the graph, and searching the graph only expands a few nodes per submap.
+ *
+ * Levels are built when a search first reaches them. When the map changes, only the
+ * nodes of the changed submaps and the portals to their neighbors are built again.
+ */
+class portal_graph
+{
+    public:
+        explicit portal_graph( const pathfinding_settings &settings );
+
+        const pathfinding_settings &settings() const {
+            return settings_;
+        }
+
+        /**
+         * Tiles a route from @p from to @p to goes through, starting with @p from and
+         * ending with @p to. Consecutive waypoints are on the same submap, adjacent, or
+         * connected by stairs, a ramp or a ledge. Empty if there is no route within the
+         * z-levels of both ends, nullopt if either end is outside of the map.
+         */
+        cata::optional<std::vector<tripoint>> waypoints( const map &m, const tripoint &from,
+                                           const tripoint &to );
+        /**
+         * Drop the level @p zlev, because the map changed there. Its neighbors are dropped
+         * too, their stairs and ramps may lead to different tiles now.
+         */
+        void invalidate( int zlev );
+        /**
+         * Build the submap of @p p again, because the map changed there. Submaps close to it
+         * on the neighboring levels are built again too, for their stairs and ramps.
+         */
+        void invalidate( const tripoint &p );
+
+    private:
+        struct edge {
+            int to;
+            int cost;
+        };
+        struct node {
+            tripoint pos;
+            // Dropped with its submap, the index is reused by a later node
+            bool removed = false;
+            // To nodes on the same level
+            std::vector<edge> edges;
+            // Tiles on other levels reached by stairs or ramps, and the cost of going there
+            std::vector<std::pair<tripoint, int>> vertical;
+        };
+        struct level {
+            bool built = false;
+            int mapsize = 0;
+            std::vector<node> nodes;
+            std::vector<int> free_nodes;
+            // Indices of the nodes on each submap
+            std::vector<std::vector<int>> submap_nodes;
+            std::map<tripoint, int> node_at;
+            /**
+             * Cost of stepping onto each tile from its neighbors, see map::route_step_cost.
+             * Most tiles cost the same from every neighbor, the others are in @ref varying_costs.
+             */
+            std::vector<int16_t> enter_cost;
+            // Cost of the tiles that depend on the neighbor, by direction of the step
+            std::unordered_map<int, std::array<int16_t, 8>> varying_costs;
+            // Submaps to build again before the next search
+            std::bitset<MAPSIZE *MAPSIZE> dirty;
+
+            /**
+             * Cost of stepping onto @p to in the direction with index @p dir, negative if
+             * that isn't possible or drops to the level below.
+             */
+            int step_cost( point to, int dir ) const;
+        };
+        using submap_costs = std::array<int, SEEX *SEEY>;
+
+        // Costs of the shortest routes from start to all tiles of its submap that stay on the submap.
+        static submap_costs local_costs( const level &lev, point start );
+        level &get_level( const map &m, int zlev );
+        void build( const map &m, int zlev, level &lev ) const;
+        void update( const map &m, int zlev, level &lev ) const;
+
+        pathfinding_settings settings_;
+        std::array<level, OVERMAP_LAYERS> levels;
+};
+
+/** The portal graphs of a map, one for each set of tile costs in use. */
+class portal_graph_cache
+{
+    public:
+        /** The graph for @p settings. Stays valid until the next call of any member. */
+        portal_graph &get( const pathfinding_settings &settings );
+        void invalidate( int zlev );
+        void invalidate( const tripoint &p );
+        void clear();
+
+    private:
+        // Most recently used first
+        std::vector<std::unique_ptr<portal_graph>> graphs;
+};
+
+#endif // CATA_SRC_PORTAL_GRAPH_H
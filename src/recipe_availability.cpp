@@ -0,0 +1,135 @@
+#include "recipe_availability.h"
+
+#include <functional>
+#include <utility>
+
+#include "inventory.h"
+#include "item.h"
+#include "recipe.h"
+#include "recipe_dictionary.h"
+#include "requirements.h"
+#include "visitable.h"
+
+static const itype_id itype_adv_UPS_off( "adv_UPS_off" );
+static const itype_id itype_UPS( "UPS" );
+static const itype_id itype_UPS_off( "UPS_off" );
+
+recipe_availability::recipe_availability( const recipe &r, const inventory &inv,
+        const int batch_size )
+{
+    const auto all_items_filter = r.get_component_filter( recipe_filter_flags::none );
+    const auto no_rotten_filter = r.get_component_filter( recipe_filter_flags::no_rotten );
+    const deduped_requirement_data &req = r.deduped_requirements();
+    can_craft = req.can_make_with_inventory( inv, all_items_filter, batch_size,
+                cost_adjustment::start_only );
+    can_craft_non_rotten = req.can_make_with_inventory( inv, no_rotten_filter, batch_size,
+                           cost_adjustment::start_only );
+    apparently_craftable = r.simple_requirements().can_make_with_inventory( inv, all_items_filter,
+                           batch_size, cost_adjustment::start_only );
+}
+
+bool recipe_availability_cache::type_summary::operator==( const type_summary &rhs ) const
+{
+    return count == rhs.count && charges == rhs.charges && ammo == rhs.ammo &&
+           components == rhs.components && rotten == rhs.rotten && filthy == rhs.filthy;
+}
+
+void recipe_availability_cache::update( const inventory &inv, const uint64_t generation,
+                                        const recipe_subset &recipes )
+{
+    if( has_generation && generation == this->generation ) {
+        return;
+    }
+    has_generation = true;
+    this->generation = generation;
+
+    // Everything the component filters and the requirements look at.
+    std::map<itype_id, type_summary> new_types;
+    inv.visit_items( [&new_types]( const item * it ) {
+        type_summary &summary = new_types[it->typeId()];
+        summary.count += it->count();
+        summary.charges += it->charges;
+        summary.ammo += it->ammo_remaining();
+        summary.components += is_crafting_component_allow_filthy( *it ) ? 1 : 0;
+        summary.rotten += it->rotten() ? 1 : 0;
+        summary.filthy += it->is_filthy() ? 1 : 0;
+        return VisitResponse::NEXT;
+    } );
+
+    const auto type_changed = [&]( const itype_id &id ) {
+        drop_recipes( recipes.of_component( id ) );
+        drop_recipes( recipes.of_tool( id ) );
+    };
+    for( const std::pair<const itype_id, type_summary> &e : new_types ) {
+        const auto iter = types.find( e.first );
+        if( iter == types.end() || !( iter->second == e.second ) ) {
+            type_changed( e.first );
+        }
+    }
+    for( const std::pair<const itype_id, type_summary> &e : types ) {
+        if( new_types.count( e.first ) == 0 ) {
+            type_changed( e.first );
+        }
+    }
+    // Tools used by charges are indexed under the UPS, which gets its charges from these.
+    for( const itype_id &id : {
+             itype_UPS_off, itype_adv_UPS_off
+         } ) {
+        const auto old_iter = types.find( id );
+        const auto new_iter = new_types.find( id );
+        const bool had = old_iter != types.end();
+        const bool has = new_iter != new_types.end();
+        if( had != has || ( had && !( old_iter->second == new_iter->second ) ) ) {
+            drop_recipes( recipes.of_tool( itype_UPS ) );
+            break;
+        }
+    }
+    types = std::move( new_types );
+
+    const std::map<quality_id, std::map<int, int>> &new_qualities = inv.get_quality_cache();
+    for( const std::pair<const quality_id, std::map<int, int>> &e : new_qualities ) {
+        const auto iter = qualities.find( e.first );
+        if( iter == qualities.end() || iter->second != e.second ) {
+            drop_recipes( recipes.of_quality( e.first ) );
+        }
+    }
+    for( const std::pair<const quality_id, std::map<int, int>> &e : qualities ) {
+        if( new_qualities.count( e.first ) == 0 ) {
+            drop_recipes( recipes.of_quality( e.first ) );
+        }
+    }
+    qualities = new_qualities;
+}
+
+const recipe_availability &recipe_availability_cache::get( const recipe &r,
+        const inventory &inv )
+{
+    auto iter = cache.find( &r );
+    if( iter == cache.end() ) {
+        iter = cache.emplace( &r, recipe_availability( r, inv, 1 ) ).first;
+        evaluations++;
+    }
+    return iter->second;
+}
+
+void recipe_availability_cache::clear()
+{
+    has_generation = false;
+    types.clear();
+    qualities.clear();
+    cache.clear();
+}
+
+size_t recipe_availability_cache::take_evaluation_count()
+{
+    const size_t result = evaluations;
+    evaluations = 0;
+    return result;
+}
+
+void recipe_availability_cache::drop_recipes( const std::set<const recipe *> &recipes )
+{
+    for( const recipe *r : recipes ) {
+        cache.erase( r );
+    }
+}
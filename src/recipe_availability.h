@@ -0,0 +1,71 @@
+#pragma once
+#ifndef CATA_SRC_RECIPE_AVAILABILITY_H
+#define CATA_SRC_RECIPE_AVAILABILITY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <set>
+#include <unordered_map>
+
+#include "type_id.h"
+
+class inventory;
+class recipe;
+class recipe_subset;
+
+/** Whether the items of a crafting inventory are enough to start a recipe. */
+struct recipe_availability {
+    recipe_availability( const recipe &r, const inventory &inv, int batch_size );
+
+    bool can_craft;
+    bool can_craft_non_rotten;
+    /** Ignoring that the same items can't be used for more than one requirement. */
+    bool apparently_craftable;
+};
+
+/**
+ * Availability of recipes with a batch size of 1, kept between uses of the crafting menu.
+ *
+ * Each time the crafting inventory is formed it gets a new generation. The items of
+ * each type and the qualities of a new generation are compared with the last one, only
+ * recipes using a type or quality that changed are evaluated again.
+ */
+class recipe_availability_cache
+{
+    public:
+        /**
+         * Make the cache match @p inv, which has the generation @p generation.
+         * @p recipes has to contain all recipes that were asked for before.
+         */
+        void update( const inventory &inv, uint64_t generation, const recipe_subset &recipes );
+        /** Availability of @p r for the inventory of the last update. */
+        const recipe_availability &get( const recipe &r, const inventory &inv );
+        void clear();
+
+        /** Number of recipes evaluated since the last call. */
+        size_t take_evaluation_count();
+
+    private:
+        struct type_summary {
+            int count = 0;
+            int charges = 0;
+            int ammo = 0;
+            int components = 0;
+            int rotten = 0;
+            int filthy = 0;
+
+            bool operator==( const type_summary &rhs ) const;
+        };
+
+        void drop_recipes( const std::set<const recipe *> &recipes );
+
+        bool has_generation = false;
+        uint64_t generation = 0;
+        std::map<itype_id, type_summary> types;
+        std::map<quality_id, std::map<int, int>> qualities;
+        std::unordered_map<const recipe *, recipe_availability> cache;
+        size_t evaluations = 0;
+};
+
+#endif // CATA_SRC_RECIPE_AVAILABILITY_H
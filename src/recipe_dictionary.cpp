@@ -26,6 +26,8 @@
 #include "units.h"
 #include "value_ptr.h"
 
+static const itype_id itype_UPS( "UPS" );
+
 recipe_dictionary recipe_dict;
 
 namespace
@@ -301,6 +303,18 @@ const std::set<const recipe *> &recipe_subset::of_component( const itype_id &id
     return iter != component.end() ? iter->second : null_match;
 }
 
+const std::set<const recipe *> &recipe_subset::of_tool( const itype_id &id ) const
+{
+    auto iter = tool.find( id );
+    return iter != tool.end() ? iter->second : null_match;
+}
+
+const std::set<const recipe *> &recipe_subset::of_quality( const quality_id &id ) const
+{
+    auto iter = quality.find( id );
+    return iter != quality.end() ? iter->second : null_match;
+}
+
 void recipe_dictionary::load_recipe( const JsonObject &jo, const std::string &src )
 {
     load( jo, src, recipe_dict.recipes );
@@ -524,12 +538,26 @@ void recipe_subset::include( const recipe *r, int custom_difficulty )
             difficulties[r] = custom_difficulty; // Added again with lower difficulty
         }
     } else {
-        // add recipe to category and component caches
-        for( const auto &opts : r->simple_requirements().get_components() ) {
+        // add recipe to category, component, tool and quality caches
+        const requirement_data &reqs = r->simple_requirements();
+        for( const auto &opts : reqs.get_components() ) {
             for( const item_comp &comp : opts ) {
                 component[comp.type].insert( r );
             }
         }
+        for( const auto &opts : reqs.get_tools() ) {
+            for( const tool_comp &comp : opts ) {
+                tool[comp.type].insert( r );
+                if( comp.by_charges() ) {
+                    tool[itype_UPS].insert( r );
+                }
+            }
+        }
+        for( const auto &opts : reqs.get_qualities() ) {
+            for( const quality_requirement &qual : opts ) {
+                quality[qual.type].insert( r );
+            }
+        }
         category[r->category].insert( r );
         // Set the difficulty is it's not the default
         if( custom_difficulty != r->difficulty ) {
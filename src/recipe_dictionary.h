@@ -125,6 +125,13 @@ class recipe_subset
 
         /** Returns all recipes which could use component */
         const std::set<const recipe *> &of_component( const itype_id &id ) const;
+        /**
+         * Returns all recipes which could use tool. Tools used by charges can get them
+         * from a UPS, so those recipes are also returned for the UPS.
+         */
+        const std::set<const recipe *> &of_tool( const itype_id &id ) const;
+        /** Returns all recipes which require quality */
+        const std::set<const recipe *> &of_quality( const quality_id &id ) const;
 
         enum class search_type {
             name,
@@ -164,6 +171,8 @@ class recipe_subset
 
         void clear() {
             component.clear();
+            tool.clear();
+            quality.clear();
             category.clear();
             recipes.clear();
             ids.clear();
@@ -182,6 +191,8 @@ class recipe_subset
         std::map<const recipe *, int> difficulties;
         std::map<std::string, std::set<const recipe *>> category;
         std::map<itype_id, std::set<const recipe *>> component;
+        std::map<itype_id, std::set<const recipe *>> tool;
+        std::map<quality_id, std::set<const recipe *>> quality;
         std::unordered_set<recipe_id> ids;
 };
 
@@ -12,13 +12,13 @@
 unsigned int rng_bits()
 {
     // Whole uint range.
-    static std::uniform_int_distribution<unsigned int> rng_uint_dist;
+    static thread_local std::uniform_int_distribution<unsigned int> rng_uint_dist;
     return rng_uint_dist( rng_get_engine() );
 }
 
 int rng( int lo, int hi )
 {
-    static std::uniform_int_distribution<int> rng_int_dist;
+    static thread_local std::uniform_int_distribution<int> rng_int_dist;
     if( lo > hi ) {
         std::swap( lo, hi );
     }
@@ -27,7 +27,7 @@ int rng( int lo, int hi )
 
 double rng_float( double lo, double hi )
 {
-    static std::uniform_real_distribution<double> rng_real_dist;
+    static thread_local std::uniform_real_distribution<double> rng_real_dist;
     if( lo > hi ) {
         std::swap( lo, hi );
     }
@@ -41,13 +41,14 @@ units::angle random_direction()
 
 double normal_roll( double mean, double stddev )
 {
-    static std::normal_distribution<double> rng_normal_dist;
-    return rng_normal_dist( rng_get_engine(), std::normal_distribution<>::param_type( mean, stddev ) );
+    // Not kept between calls, it saves every other value it generates for the next call.
+    std::normal_distribution<double> rng_normal_dist( mean, stddev );
+    return rng_normal_dist( rng_get_engine() );
 }
 
 double exponential_roll( double lambda )
 {
-    static std::exponential_distribution<double> rng_exponential_dist;
+    static thread_local std::exponential_distribution<double> rng_exponential_dist;
     return rng_exponential_dist( rng_get_engine(),
                                  std::exponential_distribution<>::param_type( lambda ) );
 }
@@ -133,14 +134,30 @@ double rng_normal( double lo, double hi )
     return clamp( val, lo, hi );
 }
 
+// Engine of the innermost rng_seed_scope on this thread, if any.
+static thread_local cata_default_random_engine *scoped_engine = nullptr;
+
 cata_default_random_engine &rng_get_engine()
 {
+    if( scoped_engine != nullptr ) {
+        return *scoped_engine;
+    }
     // NOLINTNEXTLINE(cata-determinism)
     static cata_default_random_engine eng(
         std::chrono::high_resolution_clock::now().time_since_epoch().count() );
     return eng;
 }
 
+rng_seed_scope::rng_seed_scope( unsigned int seed ) : engine( seed ), previous( scoped_engine )
+{
+    scoped_engine = &engine;
+}
+
+rng_seed_scope::~rng_seed_scope()
+{
+    scoped_engine = previous;
+}
+
 void rng_set_engine_seed( unsigned int seed )
 {
     if( seed != 0 ) {
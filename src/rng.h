@@ -26,6 +26,25 @@ void rng_set_engine_seed( unsigned int seed );
 
 using cata_default_random_engine = std::minstd_rand0;
 cata_default_random_engine &rng_get_engine();
+
+/**
+ * While this exists, the PRNG functions called on the thread that created it draw
+ * from an engine of its own, seeded with @p seed, instead of the shared one.
+ * Work done on other threads is repeatable this way and doesn't race with the
+ * game thread. Scopes can be nested, the innermost one is used.
+ */
+class rng_seed_scope
+{
+    public:
+        explicit rng_seed_scope( unsigned int seed );
+        rng_seed_scope( const rng_seed_scope & ) = delete;
+        rng_seed_scope &operator=( const rng_seed_scope & ) = delete;
+        ~rng_seed_scope();
+
+    private:
+        cata_default_random_engine engine;
+        cata_default_random_engine *previous;
+};
 unsigned int rng_bits();
 
 int rng( int lo, int hi );
@@ -1,11 +1,20 @@
 #include "rot.h"
 
+#include <cmath>
+#include <map>
+#include <tuple>
+
+#include "debug.h"
+#include "enums.h"
+#include "game_constants.h"
 #include "item_location.h"
 #include "map.h"
 #include "vehicle.h"
 #include "units.h"
 #include "veh_type.h"
 #include "vpart_position.h"
+#include "weather.h"
+#include "weather_gen.h"
 
 namespace rot
 {
@@ -70,4 +79,159 @@ temperature_flag temperature_flag_for_part( const vehicle &veh, size_t part_inde
     return temperature_flag::TEMP_NORMAL;
 }
 
+units::temperature clip_by_temperature_flag( units::temperature temperature,
+        temperature_flag flag )
+{
+    switch( flag ) {
+        case temperature_flag::TEMP_NORMAL:
+            // Just use the temperature normally
+            return temperature;
+        case temperature_flag::TEMP_FRIDGE:
+            return std::min( temperature, temperatures::fridge );
+        case temperature_flag::TEMP_FREEZER:
+            return std::min( temperature, temperatures::freezer );
+        case temperature_flag::TEMP_HEATER:
+            return std::max( temperature, temperatures::normal );
+        case temperature_flag::TEMP_ROOT_CELLAR:
+            return temperatures::root_cellar;
+        default:
+            debugmsg( "Temperature flag enum not valid: %d.  Using current temperature.",
+                      static_cast<int>( flag ) );
+            break;
+    }
+    return temperature;
+}
+
+time_duration rot_over( time_duration time_delta, int temp, float factor )
+{
+    return factor * time_delta / 1_hours * get_hourly_rotpoints_at_temp( temp ) * 1_turns;
+}
+
+namespace
+{
+
+// Hours are numbered by the time they end at, turn_zero + phase + hour * 1_hours.
+int hour_phase( const time_point &t )
+{
+    const int turns = to_turns<int>( t - calendar::turn_zero );
+    const int hour = to_turns<int>( 1_hours );
+    return ( turns % hour + hour ) % hour;
+}
+
+int hour_index( const time_point &t )
+{
+    return ( to_turns<int>( t - calendar::turn_zero ) - hour_phase( t ) ) / to_turns<int>( 1_hours );
+}
+
+time_point hour_end( int phase, int hour )
+{
+    return calendar::turn_zero + time_duration::from_turns( phase ) + hour * 1_hours;
+}
+
+struct location_key {
+    point_abs_ms location;
+    int phase;
+
+    bool operator<( const location_key &rhs ) const {
+        return std::tie( location, phase ) < std::tie( rhs.location, rhs.phase );
+    }
+};
+
+struct conditions_key {
+    location_key where;
+    bool underground;
+    int local_mod;
+    temperature_flag flag;
+    float factor;
+
+    bool operator<( const conditions_key &rhs ) const {
+        return std::tie( where, underground, local_mod, flag, factor ) <
+               std::tie( rhs.where, rhs.underground, rhs.local_mod, rhs.flag, rhs.factor );
+    }
+};
+
+// Values for the hours first, first + 1, ...
+template<typename T>
+struct hour_range {
+    int first = 0;
+    std::vector<T> values;
+
+    bool covers( int from, int to ) const {
+        return !values.empty() && first <= from && to < first + static_cast<int>( values.size() );
+    }
+};
+
+struct timeline_cache {
+    time_point turn = calendar::before_time_starts;
+    const weather_generator *wgen = nullptr;
+    unsigned seed = 0;
+    std::map<location_key, hour_range<units::temperature>> temperatures;
+    // The first value of each range is 0, each following one adds the rot of its hour.
+    std::map<conditions_key, hour_range<time_duration>> sums;
+};
+
+} // namespace
+
+hourly_rot rot_for_hours( const storage_conditions &conditions, time_point start, int hours,
+                          const weather_generator &wgen, unsigned seed )
+{
+    static timeline_cache cache;
+    if( cache.turn != calendar::turn || cache.wgen != &wgen || cache.seed != seed ) {
+        cache.temperatures.clear();
+        cache.sums.clear();
+        cache.turn = calendar::turn;
+        cache.wgen = &wgen;
+        cache.seed = seed;
+    }
+
+    const int phase = hour_phase( start );
+    const int first = hour_index( start );
+    const int last = first + hours;
+    const location_key where{ conditions.underground ? point_abs_ms() : conditions.location, phase };
+    const conditions_key key{ where, conditions.underground,
+                              units::to_millidegree_celsius( conditions.local_mod ), conditions.flag, conditions.factor };
+    hour_range<time_duration> &sums = cache.sums[key];
+    if( !sums.covers( first, last ) ) {
+        const int from = sums.values.empty() ? first : std::min( first, sums.first );
+        const int to = sums.values.empty() ? last :
+                       std::max( last, sums.first + static_cast<int>( sums.values.size() ) - 1 );
+
+        hour_range<units::temperature> *weather_temperatures = nullptr;
+        if( !conditions.underground ) {
+            weather_temperatures = &cache.temperatures[where];
+            if( !weather_temperatures->covers( from + 1, to ) ) {
+                hour_range<units::temperature> updated;
+                updated.first = from + 1;
+                for( int hour = from + 1; hour <= to; hour++ ) {
+                    if( weather_temperatures->covers( hour, hour ) ) {
+                        updated.values.push_back(
+                            weather_temperatures->values[hour - weather_temperatures->first] );
+                    } else {
+                        const tripoint_abs_ms location( conditions.location, 0 );
+                        updated.values.push_back( wgen.get_weather_temperature( location,
+                                                  hour_end( phase, hour ), calendar::config, seed ) );
+                    }
+                }
+                *weather_temperatures = std::move( updated );
+            }
+        }
+
+        sums.first = from;
+        sums.values.assign( 1, 0_turns );
+        for( int hour = from + 1; hour <= to; hour++ ) {
+            // Same as the hourly steps of item::process_rot
+            const units::temperature env_temperature_raw = conditions.underground
+                    ? units::from_fahrenheit( AVERAGE_ANNUAL_TEMPERATURE ) + conditions.local_mod
+                    : weather_temperatures->values[hour - weather_temperatures->first] + conditions.local_mod;
+            const units::temperature env_temperature_clipped =
+                clip_by_temperature_flag( env_temperature_raw, conditions.flag );
+            const int temperature_in_fahrenheit = static_cast<int>( std::round(
+                    units::to_fahrenheit<float>( env_temperature_clipped ) ) );
+            sums.values.push_back( sums.values.back() +
+                                   rot_over( 1_hours, temperature_in_fahrenheit, conditions.factor ) );
+        }
+    }
+    return hourly_rot( sums.values, first - sums.first );
+}
+
 } // namespace rot
@@ -2,10 +2,18 @@
 #ifndef CATA_SRC_ROT_H
 #define CATA_SRC_ROT_H
 
+#include <cstddef>
+#include <vector>
+
+#include "calendar.h"
+#include "coordinates.h"
+#include "units_temperature.h"
+
 enum class temperature_flag : int;
 
 class map;
 class item_location;
+class weather_generator;
 
 namespace rot
 {
@@ -13,6 +21,59 @@ namespace rot
 // TODO: Move to item_location method?
 temperature_flag temperature_flag_for_location( const map &m, const item_location &loc );
 
-}
+/** Temperature in a place with @p flag, when the temperature around it is @p temperature. */
+units::temperature clip_by_temperature_flag( units::temperature temperature,
+        temperature_flag flag );
+
+/**
+ * Rot during @p time_delta at @p temp (in Fahrenheit), with @p factor applied to the time.
+ * @see get_hourly_rotpoints_at_temp
+ */
+time_duration rot_over( time_duration time_delta, int temp, float factor );
+
+/**
+ * Everything the hourly rot of an item outside the reality bubble depends on,
+ * besides the time.
+ */
+struct storage_conditions {
+    /** Where the weather temperature is taken, unused below ground. */
+    point_abs_ms location;
+    bool underground = false;
+    /** Added to the weather temperature. */
+    units::temperature local_mod;
+    temperature_flag flag;
+    /** Applied to the time, like the factor of @ref rot_over. */
+    float factor = 1.0f;
+};
+
+/** Rot over consecutive full hours, summed from the first of them. */
+class hourly_rot
+{
+    public:
+        hourly_rot( const std::vector<time_duration> &sums, size_t first ) :
+            sums( &sums ), first( first ) {}
+
+        /** Rot during the first @p hours hours. */
+        time_duration first_hours( size_t hours ) const {
+            return ( *sums )[first + hours] - ( *sums )[first];
+        }
+
+    private:
+        const std::vector<time_duration> *sums;
+        size_t first;
+};
+
+/**
+ * Rot in @p conditions for each of the @p hours full hours after @p start, with the
+ * temperature of the end of each hour.
+ *
+ * The weather temperatures are computed once for each location and time, and the sums
+ * are shared by all items in the same conditions whose hours end at the same time of the
+ * hour. Both are kept until the turn changes. The result is valid until the next call.
+ */
+hourly_rot rot_for_hours( const storage_conditions &conditions, time_point start, int hours,
+                          const weather_generator &wgen, unsigned seed );
+
+} // namespace rot
 
 #endif // CATA_SRC_ROT_H
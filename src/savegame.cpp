@@ -278,7 +278,7 @@ void scent_map::deserialize( const std::string &data, bool is_type )
                     buffer >> stmp >> count;
                 }
                 count--;
-                val = stmp;
+                val = clamp_scent( stmp );
             }
         }
     }
@@ -471,6 +471,7 @@ void overmap::unserialize( std::istream &fin, const std::string &file_path )
                 jsin.end_array();
             }
             jsin.end_array();
+            terrain_index_built = false;
             convert_terrain( needs_conversion );
         } else if( name == "region_id" ) {
             std::string new_region_id;
@@ -20,6 +20,7 @@
 #include <set>
 #include <sstream>
 #include <stack>
+#include <stdexcept>
 #include <unordered_map>
 #include <unordered_set>
 #include <utility>
@@ -31,6 +32,7 @@
 #include "auto_pickup.h"
 #include "avatar.h"
 #include "basecamp.h"
+#include "binary_io.h"
 #include "bionics.h"
 #include "bodypart.h"
 #include "calendar.h"
@@ -3717,9 +3719,6 @@ void stats_tracker::deserialize( JsonIn &jsin )
 
 void submap::store( JsonOut &jsout ) const
 {
-    jsout.member( "turn_last_touched", last_touched );
-    jsout.member( "temperature", temperature );
-
     // Terrain is saved using a simple RLE scheme.  Legacy saves don't have
     // this feature but the algorithm is backward compatible.
     jsout.member( "terrain" );
@@ -3805,20 +3804,6 @@ void submap::store( JsonOut &jsout ) const
     }
     jsout.end_array();
 
-    jsout.member( "items" );
-    jsout.start_array();
-    for( int j = 0; j < SEEY; j++ ) {
-        for( int i = 0; i < SEEX; i++ ) {
-            if( itm[i][j].empty() ) {
-                continue;
-            }
-            jsout.write( i );
-            jsout.write( j );
-            jsout.write( itm[i][j] );
-        }
-    }
-    jsout.end_array();
-
     jsout.member( "traps" );
     jsout.start_array();
     for( int j = 0; j < SEEY; j++ ) {
@@ -3837,6 +3822,28 @@ void submap::store( JsonOut &jsout ) const
     }
     jsout.end_array();
 
+    store_contents( jsout );
+}
+
+void submap::store_contents( JsonOut &jsout ) const
+{
+    jsout.member( "turn_last_touched", last_touched );
+    jsout.member( "temperature", temperature );
+
+    jsout.member( "items" );
+    jsout.start_array();
+    for( int j = 0; j < SEEY; j++ ) {
+        for( int i = 0; i < SEEX; i++ ) {
+            if( itm[i][j].empty() ) {
+                continue;
+            }
+            jsout.write( i );
+            jsout.write( j );
+            jsout.write( itm[i][j] );
+        }
+    }
+    jsout.end_array();
+
     jsout.member( "fields" );
     jsout.start_array();
     for( int j = 0; j < SEEY; j++ ) {
@@ -3986,7 +3993,7 @@ void submap::load( JsonIn &jsin, const std::string &member_name, int version )
             int rad_num = jsin.get_int();
             for( int i = 0; i < rad_num; ++i ) {
                 if( rad_cell < SEEX * SEEY ) {
-                    set_radiation( { 0 % SEEX, rad_cell / SEEX }, rad_strength );
+                    set_radiation( { rad_cell % SEEX, rad_cell / SEEX }, rad_strength );
                     rad_cell++;
                 }
             }
@@ -4069,6 +4076,7 @@ void submap::load( JsonIn &jsin, const std::string &member_name, int version )
                     field_count++;
                 }
                 fld[i][j].add_field( ft, intensity, time_duration::from_turns( age ) );
+                field_tiles.set( i * SEEY + j );
             }
         }
     } else if( member_name == "graffiti" ) {
@@ -4185,6 +4193,137 @@ void submap::load( JsonIn &jsin, const std::string &member_name, int version )
     }
 }
 
+// Terrain, furniture and trap layers are stored as a palette of string ids followed by
+// ( palette index, run length ) pairs, in the same row order as the JSON RLE.
+template<typename T>
+static void write_id_layer( std::ostream &fout, const int_id<T>( &layer )[SEEX][SEEY] )
+{
+    static_assert( SEEX * SEEY <= UINT8_MAX, "Run length must fit in a byte" );
+    std::vector<int_id<T>> palette;
+    std::vector<std::pair<uint16_t, uint8_t>> runs;
+    for( int j = 0; j < SEEY; j++ ) {
+        // NOLINTNEXTLINE(modernize-loop-convert)
+        for( int i = 0; i < SEEX; i++ ) {
+            const auto found = std::find( palette.begin(), palette.end(), layer[i][j] );
+            const uint16_t index = static_cast<uint16_t>( found - palette.begin() );
+            if( found == palette.end() ) {
+                palette.push_back( layer[i][j] );
+            }
+            if( !runs.empty() && runs.back().first == index ) {
+                runs.back().second++;
+            } else {
+                runs.emplace_back( index, 1 );
+            }
+        }
+    }
+    binary_io::write<uint16_t>( fout, palette.size() );
+    for( const int_id<T> &id : palette ) {
+        binary_io::write_string( fout, id.id().str() );
+    }
+    binary_io::write<uint16_t>( fout, runs.size() );
+    for( const std::pair<uint16_t, uint8_t> &run : runs ) {
+        binary_io::write<uint16_t>( fout, run.first );
+        binary_io::write<uint8_t>( fout, run.second );
+    }
+}
+
+template<typename T>
+static void read_id_layer( std::istream &fin, int_id<T>( &layer )[SEEX][SEEY] )
+{
+    const uint16_t palette_size = binary_io::read<uint16_t>( fin );
+    std::vector<int_id<T>> palette;
+    palette.reserve( palette_size );
+    for( uint16_t i = 0; i < palette_size; i++ ) {
+        palette.push_back( string_id<T>( binary_io::read_string( fin ) ).id() );
+    }
+    const uint16_t num_runs = binary_io::read<uint16_t>( fin );
+    int cell = 0;
+    for( uint16_t r = 0; r < num_runs; r++ ) {
+        const uint16_t index = binary_io::read<uint16_t>( fin );
+        const uint8_t length = binary_io::read<uint8_t>( fin );
+        if( index >= palette.size() || cell + length > SEEX * SEEY ) {
+            throw std::runtime_error( "corrupt tile layer" );
+        }
+        for( int k = 0; k < length; k++, cell++ ) {
+            layer[cell % SEEX][cell / SEEX] = palette[index];
+        }
+    }
+    if( cell != SEEX * SEEY ) {
+        throw std::runtime_error( "incomplete tile layer" );
+    }
+}
+
+// Radiation is stored as ( intensity, run length ) pairs.
+static void write_radiation_layer( std::ostream &fout, const int( &layer )[SEEX][SEEY] )
+{
+    std::vector<std::pair<int32_t, uint8_t>> runs;
+    for( int j = 0; j < SEEY; j++ ) {
+        // NOLINTNEXTLINE(modernize-loop-convert)
+        for( int i = 0; i < SEEX; i++ ) {
+            if( !runs.empty() && runs.back().first == layer[i][j] ) {
+                runs.back().second++;
+            } else {
+                runs.emplace_back( layer[i][j], 1 );
+            }
+        }
+    }
+    binary_io::write<uint16_t>( fout, runs.size() );
+    for( const std::pair<int32_t, uint8_t> &run : runs ) {
+        binary_io::write<int32_t>( fout, run.first );
+        binary_io::write<uint8_t>( fout, run.second );
+    }
+}
+
+static void read_radiation_layer( std::istream &fin, int( &layer )[SEEX][SEEY] )
+{
+    const uint16_t num_runs = binary_io::read<uint16_t>( fin );
+    int cell = 0;
+    for( uint16_t r = 0; r < num_runs; r++ ) {
+        const int32_t value = binary_io::read<int32_t>( fin );
+        const uint8_t length = binary_io::read<uint8_t>( fin );
+        if( cell + length > SEEX * SEEY ) {
+            throw std::runtime_error( "corrupt radiation layer" );
+        }
+        for( int k = 0; k < length; k++, cell++ ) {
+            layer[cell % SEEX][cell / SEEX] = value;
+        }
+    }
+    if( cell != SEEX * SEEY ) {
+        throw std::runtime_error( "incomplete radiation layer" );
+    }
+}
+
+void submap::store_binary( std::ostream &fout ) const
+{
+    write_id_layer( fout, ter );
+    write_id_layer( fout, frn );
+    write_id_layer( fout, trp );
+    write_radiation_layer( fout, rad );
+
+    std::ostringstream contents;
+    JsonOut jsout( contents );
+    jsout.start_object();
+    store_contents( jsout );
+    jsout.end_object();
+    binary_io::write_string( fout, contents.str() );
+}
+
+void submap::load_binary( std::istream &fin, int version )
+{
+    read_id_layer( fin, ter );
+    read_id_layer( fin, frn );
+    read_id_layer( fin, trp );
+    read_radiation_layer( fin, rad );
+
+    std::istringstream contents( binary_io::read_string( fin ) );
+    JsonIn jsin( contents );
+    jsin.start_object();
+    while( !jsin.end_object() ) {
+        const std::string member_name = jsin.get_member_name();
+        load( jsin, member_name, version );
+    }
+}
+
 void advanced_inv_pane_save_state::serialize( JsonOut &json, const std::string &prefix ) const
 {
     json.member( prefix + "sort_idx", sort_idx );
@@ -3,8 +3,10 @@
 #include <algorithm>
 #include <cassert>
 #include <cstdlib>
+#include <limits>
 
 #include "assign.h"
+#include "cata_utility.h"
 #include "calendar.h"
 #include "color.h"
 #include "cuboid_rectangle.h"
@@ -18,6 +20,12 @@
 
 static constexpr int SCENT_RADIUS = 40;
 
+scent_map::scent_value scent_map::clamp_scent( const int value )
+{
+    return clamp<int>( value, std::numeric_limits<scent_value>::min(),
+                       std::numeric_limits<scent_value>::max() );
+}
+
 static nc_color sev( const size_t level )
 {
     static const std::array<nc_color, 22> colors = { {
@@ -81,7 +89,7 @@ void scent_map::draw( const catacurses::window &win, const int div, const tripoi
 
 void scent_map::shift( point sm_shift )
 {
-    scent_array<int> new_scent;
+    scent_array<scent_value> new_scent;
     for( size_t x = 0; x < MAPSIZE_X; ++x ) {
         for( size_t y = 0; y < MAPSIZE_Y; ++y ) {
             const point p = point( x, y ) + sm_shift;
@@ -108,7 +116,7 @@ void scent_map::set( const tripoint &p, int value, const scenttype_id &type )
 
 void scent_map::set_unsafe( const tripoint &p, int value, const scenttype_id &type )
 {
-    grscent[p.x][p.y] = value;
+    grscent[p.x][p.y] = clamp_scent( value );
     if( !type.is_empty() ) {
         typescent = type;
     }
@@ -162,9 +170,15 @@ void scent_map::update( const tripoint &center, map &m )
     //block=0 reduce=1 normal=5
     scent_array<char> scent_transfer;
 
-    std::array < std::array < int, 3 + SCENT_RADIUS * 2 >, 1 + SCENT_RADIUS * 2 > new_scent;
-    std::array < std::array < int, 3 + SCENT_RADIUS * 2 >, 1 + SCENT_RADIUS * 2 > sum_3_scent_y;
-    std::array < std::array < char, 3 + SCENT_RADIUS * 2 >, 1 + SCENT_RADIUS * 2 > squares_used_y;
+    // Columns of the area scent diffuses in, plus one column on either side.
+    static constexpr int columns = SCENT_RADIUS * 2 + 3;
+    static constexpr int rows = SCENT_RADIUS * 2 + 1;
+    // All loops below go along columns, which are contiguous in memory, without branches,
+    // so the compiler can vectorize them. Scent is summed in ints.
+    using column_array = std::array<std::array<int, rows>, columns>;
+    column_array sum_3_scent_y;
+    column_array squares_used_y;
+    std::array<std::array<scent_value, rows>, columns> new_scent;
 
     diagonal_blocks( &blocked_cache )[MAPSIZE_X][MAPSIZE_Y] = m.access_cache(
                 center.z ).vehicle_obstructed_cache;
@@ -179,67 +193,65 @@ void scent_map::update( const tripoint &center, map &m )
     m.scent_blockers( scent_transfer, point( scentmap_minx - 1, scentmap_miny - 1 ),
                       point( scentmap_maxx + 1, scentmap_maxy + 1 ) );
 
-    for( int x = 0; x < SCENT_RADIUS * 2 + 3; ++x ) {
-        sum_3_scent_y[0][x] = 0;
-        squares_used_y[0][x] = 0;
-        sum_3_scent_y[SCENT_RADIUS * 2][x] = 0;
-        squares_used_y[SCENT_RADIUS * 2][x] = 0;
-    }
-
-    for( int x = 0; x < SCENT_RADIUS * 2 + 3; ++x ) {
-        for( int y = 0; y < SCENT_RADIUS * 2 + 1; ++y ) {
-
-            point abs( x + scentmap_minx - 1, y + scentmap_miny );
-
-            // remember the sum of the scent val for the 3 neighboring squares that can defuse into
-            sum_3_scent_y[y][x] = 0;
-            squares_used_y[y][x] = 0;
-            for( int i = abs.y - 1; i <= abs.y + 1; ++i ) {
-                sum_3_scent_y[y][x] += scent_transfer[abs.x][i] * grscent[abs.x][i];
-                squares_used_y[y][x] += scent_transfer[abs.x][i];
-            }
+    // remember the sum of the scent val for the 3 neighboring squares that can defuse into
+    for( int x = 0; x < columns; ++x ) {
+        const int abs_x = x + scentmap_minx - 1;
+        const char *const transfer = &scent_transfer[abs_x][scentmap_miny - 1];
+        const scent_value *const scent = &grscent[abs_x][scentmap_miny - 1];
+        std::array < int, rows + 2 > weighted;
+        for( int y = 0; y < rows + 2; ++y ) {
+            weighted[y] = transfer[y] * scent[y];
+        }
+        for( int y = 0; y < rows; ++y ) {
+            sum_3_scent_y[x][y] = weighted[y] + weighted[y + 1] + weighted[y + 2];
+            squares_used_y[x][y] = transfer[y] + transfer[y + 1] + transfer[y + 2];
         }
     }
 
-    for( int x = 1; x < SCENT_RADIUS * 2 + 2; ++x ) {
-        for( int y = 0; y < SCENT_RADIUS * 2 + 1; ++y ) {
-            const point abs( x + scentmap_minx - 1, y + scentmap_miny );
-
-            int squares_used = squares_used_y[y][x - 1] + squares_used_y[y][x] + squares_used_y[y][x + 1];
-            int total = sum_3_scent_y[y][x - 1] + sum_3_scent_y[y][x] + sum_3_scent_y[y][x + 1];
+    for( int x = 1; x < columns - 1; ++x ) {
+        const int abs_x = x + scentmap_minx - 1;
+        std::array<int, rows> squares_used;
+        std::array<int, rows> total;
+        for( int y = 0; y < rows; ++y ) {
+            squares_used[y] = squares_used_y[x - 1][y] + squares_used_y[x][y] +
+                              squares_used_y[x + 1][y];
+            total[y] = sum_3_scent_y[x - 1][y] + sum_3_scent_y[x][y] + sum_3_scent_y[x + 1][y];
+        }
 
-            //handle vehicle holes
+        //handle vehicle holes
+        for( int y = 0; y < rows; ++y ) {
+            const point abs( abs_x, y + scentmap_miny );
             if( blocked_cache[abs.x][abs.y].nw && scent_transfer[abs.x + 1][abs.y + 1] == 5 ) {
-                squares_used -= 4;
-                total -= 4 * grscent[abs.x + 1][abs.y + 1];
+                squares_used[y] -= 4;
+                total[y] -= 4 * grscent[abs.x + 1][abs.y + 1];
             }
             if( blocked_cache[abs.x][abs.y].ne && scent_transfer[abs.x - 1][abs.y + 1] == 5 ) {
-                squares_used -= 4;
-                total -= 4 * grscent[abs.x - 1][abs.y + 1];
+                squares_used[y] -= 4;
+                total[y] -= 4 * grscent[abs.x - 1][abs.y + 1];
             }
             if( blocked_cache[abs.x - 1][abs.y - 1].nw && scent_transfer[abs.x - 1][abs.y - 1] == 5 ) {
-                squares_used -= 4;
-                total -= 4 * grscent[abs.x - 1][abs.y - 1];
+                squares_used[y] -= 4;
+                total[y] -= 4 * grscent[abs.x - 1][abs.y - 1];
             }
             if( blocked_cache[abs.x + 1][abs.y - 1].ne && scent_transfer[abs.x + 1][abs.y - 1] == 5 ) {
-                squares_used -= 4;
-                total -= 4 * grscent[abs.x + 1][abs.y - 1];
+                squares_used[y] -= 4;
+                total[y] -= 4 * grscent[abs.x + 1][abs.y - 1];
             }
+        }
 
+        const char *const transfer = &scent_transfer[abs_x][scentmap_miny];
+        const scent_value *const scent = &grscent[abs_x][scentmap_miny];
+        for( int y = 0; y < rows; ++y ) {
             //Lingering scent
-            int temp_scent =  grscent[abs.x][abs.y] * ( 250 - squares_used  *
-                              scent_transfer[abs.x][abs.y] ) ;
-            temp_scent -=  grscent[abs.x][abs.y] * scent_transfer[abs.x][abs.y] *
-                           ( 45 - squares_used ) / 5;
-
-            new_scent[y][x] = ( temp_scent + total * scent_transfer[abs.x][abs.y] ) / 250;
+            int temp_scent = scent[y] * ( 250 - squares_used[y] * transfer[y] );
+            temp_scent -= scent[y] * transfer[y] * ( 45 - squares_used[y] ) / 5;
 
+            new_scent[x][y] = ( temp_scent + total[y] * transfer[y] ) / 250;
         }
     }
-    for( int x = 1; x < SCENT_RADIUS * 2 + 2; ++x ) {
-        for( int y = 0; y < SCENT_RADIUS * 2 + 1; ++y ) {
-            grscent[x + scentmap_minx - 1 ][y + scentmap_miny] = new_scent[y][x];
-        }
+    for( int x = 1; x < columns - 1; ++x ) {
+        std::copy( new_scent[x].begin(), new_scent[x].end(),
+                   &grscent[x + scentmap_minx - 1][scentmap_miny] );
     }
 }
 
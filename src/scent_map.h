@@ -3,6 +3,7 @@
 #define CATA_SRC_SCENT_MAP_H
 
 #include <array>
+#include <cstdint>
 #include <set>
 #include <string>
 #include <vector>
@@ -45,13 +46,18 @@ class scent_map
         template<typename T>
         using scent_array = std::array<std::array<T, MAPSIZE_Y>, MAPSIZE_X>;
 
-        scent_array<int> grscent;
+        // Scent values stay far below what fits into 16 bits, the smaller
+        // values halve the memory @ref update goes through.
+        using scent_value = int16_t;
+        scent_array<scent_value> grscent;
         scenttype_id typescent;
         cata::optional<tripoint> player_last_position;
         time_point player_last_moved = calendar::before_time_starts;
 
         const game &gm;
 
+        static scent_value clamp_scent( int value );
+
     public:
         scent_map( const game &g ) : gm( g ) { }
 
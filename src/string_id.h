@@ -2,6 +2,8 @@
 #ifndef CATA_SRC_STRING_ID_H
 #define CATA_SRC_STRING_ID_H
 
+#include <atomic>
+#include <cstdint>
 #include <string>
 #include <type_traits>
 
@@ -219,6 +221,21 @@ class string_id
          * to be special. Every string (including the empty one) may be a valid id.
          */
         string_id() : _id() {}
+        // The cache can't be copied implicitly.
+        string_id( const string_id &other ) : _cache( other._cache.load( std::memory_order_relaxed ) ),
+            _id( other._id ) {}
+        string_id( string_id &&other ) noexcept : _cache( other._cache.load( std::memory_order_relaxed ) ),
+            _id( std::move( other._id ) ) {}
+        string_id &operator=( const string_id &other ) {
+            _cache.store( other._cache.load( std::memory_order_relaxed ), std::memory_order_relaxed );
+            _id = other._id;
+            return *this;
+        }
+        string_id &operator=( string_id &&other ) noexcept {
+            _cache.store( other._cache.load( std::memory_order_relaxed ), std::memory_order_relaxed );
+            _id = std::move( other._id );
+            return *this;
+        }
         /**
          * Comparison, only useful when the id is used in std::map or std::set as key.
          * Guarantees total order, but DOESN'T guarantee the same order after process restart!
@@ -335,16 +352,27 @@ class string_id
         }
 
     private:
-        // generic_factory version that corresponds to the _cid
-        mutable int64_t _version = INVALID_VERSION;
-        // cached int_id counterpart of this string_id
-        mutable int _cid = INVALID_CID;
+        // Cached int_id counterpart of this string_id in the low half, the generic_factory
+        // version it belongs to in the high half. Both are updated at once, so threads that
+        // look up the same id at the same time never see the cid of another version.
+        mutable std::atomic<uint64_t> _cache{ pack_cid_version( INVALID_CID, INVALID_VERSION ) };
         // structure that captures the actual "identity" of this string_id
         Identity _id;
 
+        static constexpr uint64_t pack_cid_version( int cid, int64_t version ) {
+            return ( static_cast<uint64_t>( version ) << 32 ) | static_cast<uint32_t>( cid );
+        }
         inline void set_cid_version( int cid, int64_t version ) const {
-            _cid = cid;
-            _version = version;
+            _cache.store( pack_cid_version( cid, version ), std::memory_order_relaxed );
+        }
+        /** Sets @p cid to the cached one and returns true, if the cache belongs to @p version. */
+        inline bool get_cid( int64_t version, int &cid ) const {
+            const uint64_t cache = _cache.load( std::memory_order_relaxed );
+            if( ( cache >> 32 ) != ( static_cast<uint64_t>( version ) & 0xFFFFFFFFu ) ) {
+                return false;
+            }
+            cid = static_cast<int>( static_cast<uint32_t>( cache ) );
+            return true;
         }
 
         friend class generic_factory<T>;
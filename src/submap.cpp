@@ -56,6 +56,7 @@ submap &submap::operator=( submap && ) = default;
 void submap::update_lum_rem( point p, const item &i )
 {
     is_uniform = false;
+    modified = true;
     if( !i.is_emissive() ) {
         return;
     } else if( lum[p.x][p.y] && lum[p.x][p.y] < 255 ) {
@@ -85,6 +86,7 @@ void submap::insert_cosmetic( point p, const std::string &type, const std::strin
     ins.type = type;
     ins.str = str;
 
+    modified = true;
     cosmetics.push_back( ins );
 }
 
@@ -132,6 +134,7 @@ const std::string &submap::get_graffiti( point p ) const
 void submap::set_graffiti( point p, const std::string &new_graffiti )
 {
     is_uniform = false;
+    modified = true;
     // Find signage at p if available
     const auto fresult = find_cosmetic( cosmetics, p, COSMETICS_GRAFFITI );
     if( fresult.result ) {
@@ -144,6 +147,7 @@ void submap::set_graffiti( point p, const std::string &new_graffiti )
 void submap::delete_graffiti( point p )
 {
     is_uniform = false;
+    modified = true;
     const auto fresult = find_cosmetic( cosmetics, p, COSMETICS_GRAFFITI );
     if( fresult.result ) {
         cosmetics[ fresult.ndx ] = cosmetics.back();
@@ -172,6 +176,7 @@ std::string submap::get_signage( point p ) const
 void submap::set_signage( point p, const std::string &s )
 {
     is_uniform = false;
+    modified = true;
     // Find signage at p if available
     const auto fresult = find_cosmetic( cosmetics, p, COSMETICS_SIGNAGE );
     if( fresult.result ) {
@@ -183,6 +188,7 @@ void submap::set_signage( point p, const std::string &s )
 void submap::delete_signage( point p )
 {
     is_uniform = false;
+    modified = true;
     const auto fresult = find_cosmetic( cosmetics, p, COSMETICS_SIGNAGE );
     if( fresult.result ) {
         cosmetics[ fresult.ndx ] = cosmetics.back();
@@ -252,6 +258,23 @@ void submap::delete_computer( point p )
     computers.erase( p );
 }
 
+bool submap::has_live_contents() const
+{
+    if( field_count > 0 || !vehicles.empty() || !spawns.empty() || camp ||
+        !active_furniture.empty() || !partial_constructions.empty() || !computers.empty() ||
+        legacy_computer ) {
+        return true;
+    }
+    for( int x = 0; x < SEEX; x++ ) {
+        for( int y = 0; y < SEEY; y++ ) {
+            if( !itm[x][y].empty() || fld[x][y].field_count() > 0 ) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
 bool submap::contains_vehicle( vehicle *veh )
 {
     const auto match = std::find_if(
@@ -269,6 +292,7 @@ void submap::rotate( int turns )
     if( turns == 0 ) {
         return;
     }
+    modified = true;
 
     const auto rotate_point = [turns]( point  p ) {
         return p.rotate( turns, { SEEX, SEEY } );
@@ -305,6 +329,15 @@ void submap::rotate( int turns )
         }
     }
 
+    field_tiles.reset();
+    for( int x = 0; x < SEEX; x++ ) {
+        for( int y = 0; y < SEEY; y++ ) {
+            if( fld[x][y].field_count() > 0 ) {
+                field_tiles.set( x * SEEY + y );
+            }
+        }
+    }
+
     active_items.rotate_locations( turns, { SEEX, SEEY } );
 
     for( auto &elem : cosmetics ) {
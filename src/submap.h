@@ -2,8 +2,10 @@
 #ifndef CATA_SRC_SUBMAP_H
 #define CATA_SRC_SUBMAP_H
 
+#include <bitset>
 #include <cstddef>
 #include <cstdint>
+#include <iosfwd>
 #include <memory>
 #include <vector>
 #include <string>
@@ -76,10 +78,12 @@ class submap : maptile_soa<SEEX, SEEY>
 
         void set_trap( point p, trap_id trap ) {
             is_uniform = false;
+            modified = true;
             trp[p.x][p.y] = trap;
         }
 
         void set_all_traps( const trap_id &trap ) {
+            modified = true;
             std::uninitialized_fill_n( &trp[0][0], elements, trap );
         }
 
@@ -89,10 +93,12 @@ class submap : maptile_soa<SEEX, SEEY>
 
         void set_furn( point p, furn_id furn ) {
             is_uniform = false;
+            modified = true;
             frn[p.x][p.y] = furn;
         }
 
         void set_all_furn( const furn_id &furn ) {
+            modified = true;
             std::uninitialized_fill_n( &frn[0][0], elements, furn );
         }
 
@@ -102,10 +108,12 @@ class submap : maptile_soa<SEEX, SEEY>
 
         void set_ter( point p, ter_id terr ) {
             is_uniform = false;
+            modified = true;
             ter[p.x][p.y] = terr;
         }
 
         void set_all_ter( const ter_id &terr ) {
+            modified = true;
             std::uninitialized_fill_n( &ter[0][0], elements, terr );
         }
 
@@ -115,6 +123,7 @@ class submap : maptile_soa<SEEX, SEEY>
 
         void set_radiation( point p, const int radiation ) {
             is_uniform = false;
+            modified = true;
             rad[p.x][p.y] = radiation;
         }
 
@@ -124,11 +133,13 @@ class submap : maptile_soa<SEEX, SEEY>
 
         void set_lum( point p, uint8_t luminance ) {
             is_uniform = false;
+            modified = true;
             lum[p.x][p.y] = luminance;
         }
 
         void update_lum_add( point p, const item &i ) {
             is_uniform = false;
+            modified = true;
             if( i.is_emissive() && lum[p.x][p.y] < 255 ) {
                 lum[p.x][p.y]++;
             }
@@ -167,6 +178,7 @@ class submap : maptile_soa<SEEX, SEEY>
         }
 
         void set_temperature( int new_temperature ) {
+            modified = true;
             temperature = new_temperature;
         }
 
@@ -199,15 +211,53 @@ class submap : maptile_soa<SEEX, SEEY>
         void store( JsonOut &jsout ) const;
         void load( JsonIn &jsin, const std::string &member_name, int version );
 
+        /**
+         * Compact counterparts of @ref store and @ref load.
+         * Terrain, furniture, traps and radiation are run-length encoded binary layers,
+         * everything else is embedded as the same JSON that @ref store writes.
+         */
+        void store_binary( std::ostream &fout ) const;
+        void load_binary( std::istream &fin, int version );
+
         // If is_uniform is true, this submap is a solid block of terrain
         // Uniform submaps aren't saved/loaded, because regenerating them is faster
         bool is_uniform;
 
+        /**
+         * Whether this submap may differ from its last saved copy.
+         * Contents that are modified through references and long-lived pointers (items,
+         * fields, vehicles, spawns, computers, basecamps, active furniture and partial
+         * constructions) always count as changed while present, and once more after they
+         * are gone.
+         */
+        bool needs_saving() const {
+            return modified || saved_with_live_contents || has_live_contents();
+        }
+        void set_modified() {
+            modified = true;
+        }
+        /** Moves @ref last_touched, the submap needs saving again if it changed. */
+        void set_last_touched( const time_point &when ) {
+            if( when != last_touched ) {
+                last_touched = when;
+                modified = true;
+            }
+        }
+        void mark_saved() {
+            modified = false;
+            saved_with_live_contents = has_live_contents();
+        }
+
         std::vector<cosmetic_t> cosmetics; // Textual "visuals" for squares
 
         active_item_cache active_items;
 
         int field_count = 0;
+        /**
+         * Tiles (x * SEEY + y) that may have fields, field processing only visits these.
+         * Set when a field is added, cleared when processing finds the tile empty.
+         */
+        std::bitset<SEEX * SEEY> field_tiles;
         time_point last_touched = calendar::turn_zero;
         std::vector<spawn_point> spawns;
         /**
@@ -224,8 +274,15 @@ class submap : maptile_soa<SEEX, SEEY>
         std::map<point, computer> computers;
         std::unique_ptr<computer> legacy_computer;
         int temperature = 0;
+        // Set by the setters, cleared by mark_saved.
+        bool modified = true;
+        bool saved_with_live_contents = false;
 
         void update_legacy_computer();
+        bool has_live_contents() const;
+
+        /** Writes all members except the per-tile terrain, furniture, trap and radiation layers. */
+        void store_contents( JsonOut &jsout ) const;
 
         static constexpr size_t elements = SEEX * SEEY;
 };
@@ -0,0 +1,64 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+
+thread_pool::thread_pool( size_t num_threads )
+{
+    workers.reserve( num_threads );
+    for( size_t i = 0; i < num_threads; i++ ) {
+        workers.emplace_back( &thread_pool::run, this );
+    }
+}
+
+thread_pool::~thread_pool()
+{
+    {
+        std::lock_guard<std::mutex> lock( mutex );
+        stopping = true;
+    }
+    queue_changed.notify_all();
+    for( std::thread &worker : workers ) {
+        worker.join();
+    }
+}
+
+void thread_pool::enqueue( std::function<void()> task )
+{
+    {
+        std::lock_guard<std::mutex> lock( mutex );
+        queue.push_back( std::move( task ) );
+    }
+    queue_changed.notify_one();
+}
+
+void thread_pool::run()
+{
+    std::unique_lock<std::mutex> lock( mutex );
+    while( true ) {
+        queue_changed.wait( lock, [this] {
+            return stopping || !queue.empty();
+        } );
+        if( queue.empty() ) {
+            return;
+        }
+        std::function<void()> task = std::move( queue.front() );
+        queue.pop_front();
+        lock.unlock();
+        // Exceptions are caught by the packaged_task and passed on through its future.
+        task();
+        lock.lock();
+    }
+}
+
+thread_pool &get_thread_pool()
+{
+    // hardware_concurrency is 0 if unknown, there is always at least one worker.
+    static thread_pool pool( std::max( std::thread::hardware_concurrency(), 2U ) - 1 );
+    return pool;
+}
+
+thread_pool &get_background_thread_pool()
+{
+    static thread_pool pool( std::min( std::max( std::thread::hardware_concurrency() / 2, 1U ), 4U ) );
+    return pool;
+}
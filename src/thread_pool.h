@@ -0,0 +1,75 @@
+#pragma once
+#ifndef CATA_SRC_THREAD_POOL_H
+#define CATA_SRC_THREAD_POOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(_WIN32) && !defined(_MSC_VER)
+#   include "mingw.thread.h"
+#endif
+
+/**
+ * A fixed set of worker threads that run queued tasks in the order they were submitted.
+ *
+ * Tasks run concurrently with the game thread, so they must only touch data that
+ * nothing else reads or writes until their result has been retrieved.
+ */
+class thread_pool
+{
+    public:
+        explicit thread_pool( size_t num_threads );
+        thread_pool( const thread_pool & ) = delete;
+        thread_pool &operator=( const thread_pool & ) = delete;
+        /** Runs all queued tasks before returning. */
+        ~thread_pool();
+
+        size_t size() const {
+            return workers.size();
+        }
+
+        /**
+         * Queue @p task. The returned future yields its result, or rethrows the
+         * exception it threw.
+         */
+        template<typename F>
+        auto submit( F &&task ) -> std::future<decltype( task() )> {
+            using result_t = decltype( task() );
+            auto packaged = std::make_shared<std::packaged_task<result_t()>>( std::forward<F>( task ) );
+            std::future<result_t> result = packaged->get_future();
+            enqueue( [packaged]() {
+                ( *packaged )();
+            } );
+            return result;
+        }
+
+    private:
+        void enqueue( std::function<void()> task );
+        void run();
+
+        std::mutex mutex;
+        std::condition_variable queue_changed;
+        std::deque<std::function<void()>> queue;
+        bool stopping = false;
+        std::vector<std::thread> workers;
+};
+
+/** Pool shared by the whole game, with a thread for each hardware thread except the game's own. */
+thread_pool &get_thread_pool();
+
+/**
+ * Smaller pool for long tasks that the game thread doesn't wait for right away, such as
+ * generating overmaps ahead of the player. Kept apart from @ref get_thread_pool so
+ * they don't hold up the short tasks the game thread waits on every turn.
+ */
+thread_pool &get_background_thread_pool();
+
+#endif // CATA_SRC_THREAD_POOL_H
@@ -1288,6 +1288,9 @@ vehicle *vehicle::act_on_map()
         }
 
         here.on_vehicle_moved( sm_pos.z );
+        for( const tripoint &p : get_points( true ) ) {
+            here.set_pathfinding_cache_dirty( p );
+        }
         // Destroy vehicle (sank to nowhere)
         here.destroy_vehicle( this );
         return nullptr;
@@ -109,25 +109,27 @@ int incident_sunlight( const weather_type_id &wtype, const time_point &t )
     return std::max<float>( 0.0f, sunlight( t, false ) + wtype->light_modifier );
 }
 
+static int precipitation_per_turn( const weather_type_id &wtype )
+{
+    if( !wtype->rains ) {
+        return 0;
+    }
+    switch( wtype->precip ) {
+        case precip_class::very_light:
+            return 1;
+        case precip_class::light:
+            return 4;
+        case precip_class::heavy:
+            return 8;
+        default:
+            return 0;
+    }
+}
+
 inline void proc_weather_sum( const weather_type_id wtype, weather_sum &data,
                               const time_point &t, const time_duration &tick_size )
 {
-    int amount = 0;
-    if( wtype->rains ) {
-        switch( wtype->precip ) {
-            case precip_class::very_light:
-                amount = 1 * to_turns<int>( tick_size );
-                break;
-            case precip_class::light:
-                amount = 4 * to_turns<int>( tick_size );
-                break;
-            case precip_class::heavy:
-                amount = 8 * to_turns<int>( tick_size );
-                break;
-            default:
-                break;
-        }
-    }
+    const int amount = precipitation_per_turn( wtype ) * to_turns<int>( tick_size );
     if( wtype->acidic ) {
         data.acid_amount += amount;
     } else {
@@ -150,31 +152,220 @@ const weather_type_id &current_weather( const tripoint &location, const time_poi
     return wgen.get_weather_conditions( location, t, g->get_seed() );
 }
 
+namespace
+{
+
+/** Weather of one turn, or of several turns summed. */
+struct weather_rates {
+    int rain = 0;
+    int acid = 0;
+    double sunlight = 0.0;
+
+    weather_rates operator+( const weather_rates &rhs ) const {
+        return { rain + rhs.rain, acid + rhs.acid, sunlight + rhs.sunlight };
+    }
+    weather_rates operator-( const weather_rates &rhs ) const {
+        return { rain - rhs.rain, acid - rhs.acid, sunlight - rhs.sunlight };
+    }
+};
+
+/**
+ * Weather of each turn of a bucket of time, sampled at the start of the bucket.
+ */
+weather_rates rates_at( const weather_generator &wgen, const tripoint &location,
+                        const time_point &t, unsigned seed )
+{
+    const weather_type_id &wtype = wgen.get_weather_conditions( location, t, seed );
+    weather_rates result;
+    const int amount = precipitation_per_turn( wtype );
+    if( wtype->acidic ) {
+        result.acid = amount;
+    } else {
+        result.rain = amount;
+    }
+    result.sunlight = incident_sunlight( wtype, t );
+    return result;
+}
+
+/**
+ * Running sums of the weather of consecutive buckets of time, all of the same length,
+ * counted from the turn zero. Grows in both directions as it is queried.
+ */
+class weather_series
+{
+    public:
+        weather_series( const time_duration &bucket_length, int max_buckets ) :
+            bucket_turns( to_turns<int>( bucket_length ) ), max_buckets( max_buckets ) {}
+
+        /**
+         * Adds the weather between @p from and @p to to @p data, taking the weather of
+         * each bucket from @p sample the first time it is needed.
+         */
+        template<typename Sample>
+        void add( const time_point &from, const time_point &to, weather_sum &data,
+                  const Sample &sample ) {
+            const int begin_turn = to_turn<int>( from );
+            const int end_turn = to_turn<int>( to );
+            const int first_bucket = divide_round_to_minus_infinity( begin_turn, bucket_turns );
+            const int last_bucket = divide_round_to_minus_infinity( end_turn - 1, bucket_turns );
+            cover( first_bucket, last_bucket, sample );
+
+            const int first_bucket_end = ( first_bucket + 1 ) * bucket_turns;
+            add_turns( data, between( first_bucket, first_bucket + 1 ),
+                       std::min( end_turn, first_bucket_end ) - begin_turn );
+            if( last_bucket > first_bucket ) {
+                add_turns( data, between( first_bucket + 1, last_bucket ), bucket_turns );
+                add_turns( data, between( last_bucket, last_bucket + 1 ),
+                           end_turn - last_bucket * bucket_turns );
+            }
+        }
+
+    private:
+        static void add_turns( weather_sum &data, const weather_rates &rates, int turns ) {
+            data.rain_amount += rates.rain * turns;
+            data.acid_amount += rates.acid * turns;
+            data.sunlight += rates.sunlight * turns;
+        }
+
+        weather_rates between( int first_bucket, int end_bucket ) const {
+            return sums[end_bucket - first] - sums[first_bucket - first];
+        }
+
+        bool covers( int bucket ) const {
+            return bucket >= first && bucket < first + static_cast<int>( sums.size() ) - 1;
+        }
+
+        /** Makes sure the sums include the buckets from @p first_bucket to @p last_bucket. */
+        template<typename Sample>
+        void cover( int first_bucket, int last_bucket, const Sample &sample ) {
+            if( covers( first_bucket ) && covers( last_bucket ) ) {
+                return;
+            }
+            int new_first = first_bucket;
+            int new_last = last_bucket;
+            if( !sums.empty() ) {
+                new_first = std::min( new_first, first );
+                new_last = std::max( new_last, first + static_cast<int>( sums.size() ) - 2 );
+                if( new_last - new_first + 1 > max_buckets ) {
+                    // Forget the old buckets instead of growing without bound
+                    sums.clear();
+                    new_first = first_bucket;
+                    new_last = last_bucket;
+                }
+            }
+            const auto sample_bucket = [&]( int bucket ) {
+                return sample( time_point::from_turn( bucket * bucket_turns ) );
+            };
+            if( !sums.empty() && new_first == first ) {
+                // Only appending, the old sums stay valid
+                for( int bucket = first + static_cast<int>( sums.size() ) - 1; bucket <= new_last; bucket++ ) {
+                    sums.push_back( sums.back() + sample_bucket( bucket ) );
+                }
+                return;
+            }
+            std::vector<weather_rates> rebuilt;
+            rebuilt.reserve( new_last - new_first + 2 );
+            rebuilt.emplace_back();
+            for( int bucket = new_first; bucket <= new_last; bucket++ ) {
+                rebuilt.push_back( rebuilt.back() +
+                                   ( covers( bucket ) ? between( bucket, bucket + 1 ) : sample_bucket( bucket ) ) );
+            }
+            sums = std::move( rebuilt );
+            first = new_first;
+        }
+
+        int bucket_turns;
+        int max_buckets;
+        /** The bucket counted from by @ref sums. */
+        int first = 0;
+        /** sums[i] is the weather of the buckets from @ref first up to but excluding first + i. */
+        std::vector<weather_rates> sums;
+};
+
+/** Weather history of one overmap terrain tile, sampled at its center. */
+struct region_history {
+    weather_series hours{ 1_hours, to_hours<int>( 2 * calendar::year_length() ) };
+    weather_series minutes{ 1_minutes, to_minutes<int>( 8_days ) };
+};
+
+/**
+ * Weather history of the overmap terrain tiles sum_conditions was asked about.
+ * Weather doesn't change noticeably within one tile, so all places in it share it.
+ */
+struct weather_history {
+    const weather_generator *wgen = nullptr;
+    unsigned seed = 0;
+    bool eternal_season = false;
+    std::unordered_map<point_abs_omt, region_history> regions;
+
+    region_history &get( const weather_generator &current_wgen, unsigned current_seed,
+                         const point_abs_omt &region ) {
+        if( wgen != &current_wgen || seed != current_seed ||
+            eternal_season != calendar::eternal_season() ) {
+            wgen = &current_wgen;
+            seed = current_seed;
+            eternal_season = calendar::eternal_season();
+            regions.clear();
+        }
+        auto iter = regions.find( region );
+        if( iter == regions.end() ) {
+            if( regions.size() >= max_regions ) {
+                regions.clear();
+            }
+            iter = regions.emplace( region, region_history() ).first;
+        }
+        return iter->second;
+    }
+
+    static constexpr size_t max_regions = 32;
+};
+
+} // namespace
+
 weather_sum sum_conditions( const time_point &start, const time_point &end,
                             const tripoint &location )
 {
-    time_duration tick_size = 0_turns;
     weather_sum data;
+    if( start >= end ) {
+        return data;
+    }
+    const weather_manager &weather = get_weather();
+    // TODO: fix point types
+    const tripoint_abs_omt omt( ms_to_omt_copy( location ) );
+    // Wind is taken as it is now for the whole time
+    data.wind_amount = get_local_windpower( weather.windspeed, overmap_buffer.ter( omt ), location,
+                                            weather.winddirection, false ) * to_turns<int>( end - start );
 
-    for( time_point t = start; t < end; t += tick_size ) {
-        const time_duration diff = end - t;
-        if( diff < 10_turns ) {
-            tick_size = 1_turns;
-        } else if( diff > 7_days ) {
-            tick_size = 1_hours;
-        } else {
-            tick_size = 1_minutes;
+    if( weather.weather_override ) {
+        time_duration tick_size = 0_turns;
+        for( time_point t = start; t < end; t += tick_size ) {
+            const time_duration diff = end - t;
+            if( diff < 10_turns ) {
+                tick_size = 1_turns;
+            } else if( diff > 7_days ) {
+                tick_size = 1_hours;
+            } else {
+                tick_size = 1_minutes;
+            }
+            proc_weather_sum( weather.weather_override, data, t, tick_size );
         }
+        return data;
+    }
 
-        weather_type_id wtype = current_weather( location, t );
-        proc_weather_sum( wtype, data, t, tick_size );
-        const weather_manager &weather = get_weather();
-        data.wind_amount += get_local_windpower( weather.windspeed,
-                            // TODO: fix point types
-                            overmap_buffer.ter( tripoint_abs_omt( ms_to_omt_copy( location ) ) ),
-                            location,
-                            weather.winddirection, false ) * to_turns<int>( tick_size );
+    static weather_history history;
+    const weather_generator &wgen = weather.get_cur_weather_gen();
+    const unsigned seed = g->get_seed();
+    region_history &region = history.get( wgen, seed, omt.xy() );
+    const tripoint sample_location( omt_to_ms_copy( omt.raw().xy() ) + point( SEEX, SEEY ), 0 );
+    const auto sample = [&]( const time_point & t ) {
+        return rates_at( wgen, sample_location, t, seed );
+    };
+    // Only the last week is summed by the minute
+    const time_point by_minute = std::max( start, end - 7_days );
+    if( start < by_minute ) {
+        region.hours.add( start, by_minute, data, sample );
     }
+    region.minutes.add( by_minute, end, data, sample );
     return data;
 }
 
@@ -31,6 +31,7 @@
 #include "player_helpers.h"
 #include "point.h"
 #include "recipe.h"
+#include "recipe_availability.h"
 #include "recipe_dictionary.h"
 #include "requirements.h"
 #include "state_helpers.h"
@@ -625,6 +626,46 @@ TEST_CASE( "debug hammerspace", "[crafting]" )
     }
 }
 
+TEST_CASE( "recipe availability is evaluated again only for changed items", "[crafting]" )
+{
+    clear_all_state();
+    avatar &u = get_avatar();
+    const recipe &from_tape = recipe_id( "blindfold_from_tape" ).obj();
+    const recipe &from_scarf = recipe_id( "blindfold" ).obj();
+    recipe_subset recipes;
+    recipes.include( &from_tape );
+    recipes.include( &from_scarf );
+
+    recipe_availability_cache cache;
+    u.invalidate_crafting_inventory();
+    cache.update( u.crafting_inventory(), u.crafting_inventory_generation(), recipes );
+    CHECK_FALSE( cache.get( from_tape, u.crafting_inventory() ).can_craft );
+    CHECK_FALSE( cache.get( from_scarf, u.crafting_inventory() ).can_craft );
+    CHECK( cache.take_evaluation_count() == 2 );
+
+    WHEN( "the inventory is formed again without changes" ) {
+        u.invalidate_crafting_inventory();
+        cache.update( u.crafting_inventory(), u.crafting_inventory_generation(), recipes );
+        cache.get( from_tape, u.crafting_inventory() );
+        cache.get( from_scarf, u.crafting_inventory() );
+        THEN( "no recipe is evaluated again" ) {
+            CHECK( cache.take_evaluation_count() == 0 );
+        }
+    }
+    WHEN( "duct tape is added" ) {
+        u.worn.push_back( item( "backpack" ) );
+        u.i_add( item( "duct_tape" ) );
+        u.invalidate_crafting_inventory();
+        cache.update( u.crafting_inventory(), u.crafting_inventory_generation(), recipes );
+        const bool tape_craftable = cache.get( from_tape, u.crafting_inventory() ).can_craft;
+        cache.get( from_scarf, u.crafting_inventory() );
+        THEN( "only the recipe using it is evaluated again" ) {
+            CHECK( tape_craftable );
+            CHECK( cache.take_evaluation_count() == 1 );
+        }
+    }
+}
+
 TEST_CASE( "oven electric grid", "[crafting][overmap][grids][slow]" )
 {
     clear_all_state();
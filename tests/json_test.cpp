@@ -4,7 +4,9 @@
 #include <sstream>
 
 #include "bodypart.h"
+#include "filesystem.h"
 #include "json.h"
+#include "path_info.h"
 #include "string_formatter.h"
 #include "type_id.h"
 #include "colony.h"
@@ -246,6 +248,8 @@ static void test_get_string( const std::string &str, const std::string &json )
     std::istringstream iss( json );
     JsonIn jsin( iss );
     CHECK( jsin.get_string() == str );
+    JsonIn jsin_memory( json );
+    CHECK( jsin_memory.get_string() == str );
 }
 
 template<typename Matcher>
@@ -255,6 +259,8 @@ static void test_get_string_throws_matches( Matcher &&matcher, const std::string
     std::istringstream iss( json );
     JsonIn jsin( iss );
     CHECK_THROWS_MATCHES( jsin.get_string(), JsonError, matcher );
+    JsonIn jsin_memory( json );
+    CHECK_THROWS_MATCHES( jsin_memory.get_string(), JsonError, matcher );
 }
 
 template<typename Matcher>
@@ -266,6 +272,8 @@ static void test_string_error_throws_matches( Matcher &&matcher, const std::stri
     std::istringstream iss( json );
     JsonIn jsin( iss );
     CHECK_THROWS_MATCHES( jsin.string_error( "<message>", offset ), JsonError, matcher );
+    JsonIn jsin_memory( json );
+    CHECK_THROWS_MATCHES( jsin_memory.string_error( "<message>", offset ), JsonError, matcher );
 }
 
 TEST_CASE( "jsonin_get_string", "[json]" )
@@ -452,3 +460,79 @@ TEST_CASE( "jsonin_get_string", "[json]" )
             R"(       ar")" "\n" ),
         R"("foo\nbar")", 5 );
 }
+
+TEST_CASE( "jsonin_memory_matches_stream", "[json]" )
+{
+    const std::string json =
+        R"([ { "id": "foo", "flags": [ "A", "B" ], "weight": -1.5e2, "volume": 250 },)" "\n"
+        R"(  { "id": "bar", "active": true, "broken": false, "owner": null, "desc": "a\tb…" } ])";
+    std::istringstream iss( json );
+    JsonIn jsin( iss );
+    JsonIn jsin_memory( json );
+    for( JsonIn *j : { &jsin, &jsin_memory } ) {
+        JsonArray ja = j->get_array();
+        JsonObject foo = ja.next_object();
+        CHECK( foo.get_string( "id" ) == "foo" );
+        CHECK( foo.get_tags( "flags" ) == std::set<std::string> { "A", "B" } );
+        CHECK( foo.get_float( "weight" ) == Approx( -150.0 ) );
+        CHECK( foo.get_int( "volume" ) == 250 );
+        JsonObject bar = ja.next_object();
+        bar.allow_omitted_members();
+        CHECK( bar.get_bool( "active" ) );
+        CHECK_FALSE( bar.get_bool( "broken" ) );
+        CHECK( bar.get_string( "desc" ) == "a\tb…" );
+    }
+
+    const std::string bad = "[ 1,\n  2,\n]";
+    std::istringstream bad_iss( bad );
+    JsonIn bad_jsin( bad_iss );
+    JsonIn bad_jsin_memory( bad );
+    std::string stream_error;
+    std::string memory_error;
+    try {
+        bad_jsin.skip_value();
+    } catch( const JsonError &e ) {
+        stream_error = e.what();
+    }
+    try {
+        bad_jsin_memory.skip_value();
+    } catch( const JsonError &e ) {
+        memory_error = e.what();
+    }
+    CHECK_FALSE( stream_error.empty() );
+    CHECK( memory_error == stream_error );
+}
+
+TEST_CASE( "jsonin_load_data_benchmark", "[.][json][benchmark]" )
+{
+    std::vector<std::string> files;
+    for( const std::string &path : get_files_from_path( ".json", PATH_INFO::datadir() + "json", true,
+            true ) ) {
+        files.push_back( read_entire_file( path ) );
+    }
+    REQUIRE( !files.empty() );
+
+    BENCHMARK( "stream" ) {
+        for( const std::string &data : files ) {
+            std::istringstream iss( data );
+            JsonIn jsin( iss );
+            jsin.skip_value();
+        }
+    };
+    BENCHMARK( "memory" ) {
+        for( const std::string &data : files ) {
+            JsonIn jsin( data );
+            jsin.skip_value();
+        }
+    };
+    BENCHMARK( "memory, indexing objects" ) {
+        for( const std::string &data : files ) {
+            JsonIn jsin( data );
+            if( jsin.test_array() ) {
+                for( JsonObject jo : jsin.get_array() ) {
+                    jo.allow_omitted_members();
+                }
+            }
+        }
+    };
+}
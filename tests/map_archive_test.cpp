@@ -0,0 +1,224 @@
+#include "catch/catch.hpp"
+
+#include <iterator>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "cata_utility.h"
+#include "coordinate_conversions.h"
+#include "debug.h"
+#include "filesystem.h"
+#include "fstream_utils.h"
+#include "game.h"
+#include "map.h"
+#include "map_archive.h"
+#include "mapbuffer.h"
+#include "mapdata.h"
+#include "optional.h"
+#include "point.h"
+#include "string_formatter.h"
+#include "submap.h"
+
+static std::string archive_test_path()
+{
+    const std::string dir = g->get_world_base_save_path() + "/map_archive_test_" + get_pid_string();
+    REQUIRE( assure_dir_exist( dir ) );
+    const std::string path = dir + "/0.0.0.seg";
+    remove_file( path );
+    return path;
+}
+
+TEST_CASE( "map segment archive stores the newest record of each quad", "[savegame]" )
+{
+    const std::string path = archive_test_path();
+    const tripoint first( 1, 2, 0 );
+    const tripoint second( 3, 4, -1 );
+    {
+        map_segment_archive archive( path );
+        CHECK_FALSE( archive.read( first ) );
+        archive.append( first, "old" );
+        archive.append( second, "second" );
+        archive.append( first, "new" );
+        CHECK( archive.read( first ).value_or( "" ) == "new" );
+        CHECK( archive.read( second ).value_or( "" ) == "second" );
+    }
+
+    SECTION( "the index is rebuilt from the file" ) {
+        map_segment_archive archive( path );
+        CHECK( archive.quads().size() == 2 );
+        CHECK( archive.read( first ).value_or( "" ) == "new" );
+        CHECK( archive.read( second ).value_or( "" ) == "second" );
+    }
+
+    SECTION( "compaction keeps the newest records" ) {
+        map_segment_archive archive( path );
+        archive.compact();
+        CHECK( archive.read( first ).value_or( "" ) == "new" );
+        archive.append( second, "third" );
+        map_segment_archive reloaded( path );
+        CHECK( reloaded.read( first ).value_or( "" ) == "new" );
+        CHECK( reloaded.read( second ).value_or( "" ) == "third" );
+    }
+
+    SECTION( "a partially written record is dropped" ) {
+        std::string contents;
+        read_from_file( path, [&contents]( std::istream & fin ) {
+            contents.assign( std::istreambuf_iterator<char>( fin ), std::istreambuf_iterator<char>() );
+        } );
+        write_to_file( path, [&contents]( std::ostream & fout ) {
+            fout.write( contents.data(), contents.size() - 2 );
+        } );
+        map_segment_archive archive( path );
+        CHECK( archive.read( first ).value_or( "" ) == "old" );
+        CHECK( archive.needs_compaction() );
+        archive.append( first, "newest" );
+        map_segment_archive reloaded( path );
+        CHECK( reloaded.read( first ).value_or( "" ) == "newest" );
+        CHECK( reloaded.read( second ).value_or( "" ) == "second" );
+    }
+
+    SECTION( "an archive with a broken header is moved aside" ) {
+        write_to_file( path, []( std::ostream & fout ) {
+            fout << "not an archive";
+        } );
+        map_segment_archive archive( path );
+        CHECK_THROWS( archive.read( first ) );
+        // Looking the quad up again doesn't hit the broken file again.
+        CHECK_FALSE( archive.read( first ) );
+        archive.append( first, "generated again" );
+        map_segment_archive reloaded( path );
+        CHECK( reloaded.read( first ).value_or( "" ) == "generated again" );
+        CHECK_FALSE( reloaded.read( second ) );
+        std::string contents;
+        read_from_file( path + ".corrupt", [&contents]( std::istream & fin ) {
+            contents.assign( std::istreambuf_iterator<char>( fin ), std::istreambuf_iterator<char>() );
+        } );
+        CHECK( contents == "not an archive" );
+        remove_file( path + ".corrupt" );
+    }
+    remove_file( path );
+    remove_directory( path.substr( 0, path.find_last_of( '/' ) ) );
+}
+
+TEST_CASE( "only the most recently used map segment archives stay open", "[savegame]" )
+{
+    const std::string path = archive_test_path();
+    const std::string dir = path.substr( 0, path.find_last_of( '/' ) );
+    const tripoint quad( 1, 2, 0 );
+    std::vector<std::unique_ptr<map_segment_archive>> archives;
+    for( size_t i = 0; i < map_segment_archive::max_open_archives + 8; i++ ) {
+        archives.push_back( std::make_unique<map_segment_archive>(
+                                dir + "/" + std::to_string( i ) + ".0.0.seg" ) );
+        archives.back()->append( quad, "quad" );
+        CHECK( archives.back()->read( quad ).value_or( "" ) == "quad" );
+    }
+    CHECK( map_segment_archive::open_archive_count() == map_segment_archive::max_open_archives );
+    // Closed archives open their file again when needed.
+    CHECK( archives.front()->read( quad ).value_or( "" ) == "quad" );
+    CHECK( map_segment_archive::open_archive_count() == map_segment_archive::max_open_archives );
+
+    for( std::unique_ptr<map_segment_archive> &archive : archives ) {
+        const std::string archive_path = archive->path();
+        archive.reset();
+        remove_file( archive_path );
+    }
+    CHECK( map_segment_archive::open_archive_count() == 0 );
+    remove_directory( dir );
+}
+
+TEST_CASE( "quads are saved again after their archive turned out to be corrupt", "[savegame]" )
+{
+    restore_on_out_of_scope<bool> restore_mapgen( disable_mapgen );
+    disable_mapgen = false;
+    // Far away from anything the other tests load.
+    const tripoint sm_addr = omt_to_sm_copy( tripoint( 2000, 2000, 0 ) );
+    const tripoint segment_addr = omt_to_seg_copy( sm_to_omt_copy( sm_addr ) );
+    const std::string path = string_format( "%s/maps/%d.%d.%d.seg", g->get_world_base_save_path(),
+                                            segment_addr.x, segment_addr.y, segment_addr.z );
+    const auto save_quad = [&sm_addr]( mapbuffer & buffer, const ter_id & ter ) {
+        for( const point &offset : {
+                 point_zero, point_south, point_east, point_south_east
+             } ) {
+            std::unique_ptr<submap> sm = std::make_unique<submap>();
+            sm->set_ter( point_zero, ter );
+            REQUIRE( buffer.add_submap( sm_addr + offset, sm ) );
+        }
+        buffer.save();
+        buffer.flush_writes();
+    };
+
+    mapbuffer buffer;
+    save_quad( buffer, t_floor );
+    buffer.reset();
+    write_to_file( path, []( std::ostream & fout ) {
+        fout << "not an archive";
+    } );
+
+    // The first lookup reports the broken file, the game would generate the quad now.
+    const std::string error = capture_debugmsg_during( [&]() {
+        CHECK( buffer.lookup_submap( sm_addr ) == nullptr );
+    } );
+    CHECK_FALSE( error.empty() );
+    save_quad( buffer, t_wall );
+    buffer.reset();
+
+    // Loading the same quad again finds what was saved after the file was moved aside.
+    submap *const loaded = buffer.lookup_submap( sm_addr );
+    REQUIRE( loaded != nullptr );
+    CHECK( loaded->get_ter( point_zero ) == t_wall );
+
+    buffer.reset();
+    remove_file( path );
+    remove_file( path + ".corrupt" );
+}
+
+TEST_CASE( "prefetched quads are loaded like any other", "[savegame]" )
+{
+    restore_on_out_of_scope<bool> restore_mapgen( disable_mapgen );
+    disable_mapgen = false;
+    const tripoint sm_addr = omt_to_sm_copy( tripoint( 2010, 2000, 0 ) );
+    const tripoint segment_addr = omt_to_seg_copy( sm_to_omt_copy( sm_addr ) );
+    const std::string path = string_format( "%s/maps/%d.%d.%d.seg", g->get_world_base_save_path(),
+                                            segment_addr.x, segment_addr.y, segment_addr.z );
+    const auto save_quad = [&sm_addr]( mapbuffer & buffer, const ter_id & ter ) {
+        for( const point &offset : {
+                 point_zero, point_south, point_east, point_south_east
+             } ) {
+            std::unique_ptr<submap> sm = std::make_unique<submap>();
+            sm->set_ter( point_zero, ter );
+            REQUIRE( buffer.add_submap( sm_addr + offset, sm ) );
+        }
+        buffer.save();
+    };
+
+    mapbuffer buffer;
+    save_quad( buffer, t_wall );
+    buffer.reset();
+
+    SECTION( "the lookup takes the submaps loaded ahead" ) {
+        buffer.prefetch( sm_addr );
+        for( const point &offset : {
+                 point_zero, point_south, point_east, point_south_east
+             } ) {
+            submap *const loaded = buffer.lookup_submap( sm_addr + offset );
+            REQUIRE( loaded != nullptr );
+            CHECK( loaded->get_ter( point_zero ) == t_wall );
+        }
+    }
+    SECTION( "saving the quad again replaces what was loaded ahead" ) {
+        buffer.prefetch( sm_addr );
+        mapbuffer other;
+        save_quad( other, t_floor );
+        other.flush_writes();
+        buffer.flush_writes();
+        submap *const loaded = buffer.lookup_submap( sm_addr );
+        REQUIRE( loaded != nullptr );
+        CHECK( loaded->get_ter( point_zero ) == t_floor );
+        other.reset();
+    }
+
+    buffer.reset();
+    remove_file( path );
+}
@@ -0,0 +1,212 @@
+#include "catch/catch.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+#include "calendar.h"
+#include "field.h"
+#include "field_type.h"
+#include "map.h"
+#include "map_helpers.h"
+#include "map_iterator.h"
+#include "options_helpers.h"
+#include "point.h"
+#include "rng.h"
+#include "state_helpers.h"
+#include "type_id.h"
+
+TEST_CASE( "fields are processed on every tile they were added to", "[field]" )
+{
+    clear_all_state();
+    map &here = get_map();
+    const std::vector<tripoint> points = {
+        tripoint( 24, 24, 0 ), tripoint( 35, 24, 0 ), tripoint( 24, 35, 0 ), tripoint( 70, 90, 0 )
+    };
+    for( const tripoint &p : points ) {
+        REQUIRE( here.add_field( p, fd_blood, 1 ) );
+    }
+    here.process_fields();
+    here.process_fields();
+    for( const tripoint &p : points ) {
+        const field_entry *blood = here.get_field( p, fd_blood );
+        REQUIRE( blood != nullptr );
+        CHECK( blood->get_field_age() == 2_turns );
+    }
+
+    // Tiles that lost their fields don't keep fields elsewhere from being processed.
+    here.remove_field( points[0], fd_blood );
+    here.process_fields();
+    const tripoint later( 25, 24, 0 );
+    REQUIRE( here.add_field( later, fd_blood, 1 ) );
+    here.process_fields();
+    CHECK( here.get_field( points[0], fd_blood ) == nullptr );
+    CHECK( here.get_field( points[1], fd_blood )->get_field_age() == 4_turns );
+    CHECK( here.get_field( later, fd_blood )->get_field_age() == 1_turns );
+}
+
+TEST_CASE( "field entries stay in place", "[field]" )
+{
+    field fld;
+    REQUIRE( fld.add_field( fd_blood, 1 ) );
+    REQUIRE( fld.add_field( fd_smoke, 1 ) );
+    field_entry *blood = fld.find_field( fd_blood );
+    REQUIRE( blood != nullptr );
+    // Past the fields stored in the tile itself.
+    REQUIRE( fld.add_field( fd_fire, 1 ) );
+    REQUIRE( fld.add_field( fd_acid, 1 ) );
+    CHECK_FALSE( fld.add_field( fd_acid, 1 ) );
+    CHECK( fld.find_field( fd_blood ) == blood );
+    CHECK( fld.field_count() == 4 );
+    CHECK( fld.find_field( fd_acid )->get_field_intensity() == 2 );
+
+    const field copy = fld;
+    CHECK( copy.field_count() == 4 );
+    CHECK( copy.find_field( fd_fire ) != fld.find_field( fd_fire ) );
+
+    std::vector<field_type_id> removed;
+    for( auto it = fld.begin(); it != fld.end(); ) {
+        if( it->first == fd_smoke || it->first == fd_fire ) {
+            removed.push_back( it->first );
+            fld.remove_field( it++ );
+        } else {
+            ++it;
+        }
+    }
+    CHECK( removed.size() == 2 );
+    CHECK( fld.field_count() == 2 );
+    CHECK( fld.find_field( fd_blood ) == blood );
+    CHECK( fld.find_field( fd_fire ) == nullptr );
+    REQUIRE( fld.add_field( fd_smoke, 1 ) );
+    CHECK( fld.field_count() == 3 );
+    CHECK( fld.remove_field( fd_acid ) );
+    CHECK_FALSE( fld.remove_field( fd_acid ) );
+    CHECK( fld.field_count() == 2 );
+    CHECK( copy.field_count() == 4 );
+}
+
+// Lets @p type spread from @p sources for @p turns and returns the intensities on z-level 0.
+static std::vector<int> spread_gas( const field_type_id &type, const std::vector<tripoint> &sources,
+                                    const int turns )
+{
+    map &here = get_map();
+    clear_fields( 0 );
+    calendar::turn = calendar::start_of_cataclysm;
+    for( const tripoint &p : sources ) {
+        here.add_field( p, type, 3 );
+    }
+    for( int turn = 0; turn < turns; turn++ ) {
+        here.process_fields();
+        calendar::turn += 1_turns;
+    }
+    std::vector<int> intensities;
+    for( const tripoint &p : here.points_on_zlevel( 0 ) ) {
+        intensities.push_back( here.get_field_intensity( p, type ) );
+    }
+    return intensities;
+}
+
+static int count_gas_tiles( const std::vector<int> &intensities )
+{
+    return std::count_if( intensities.begin(), intensities.end(), []( int intensity ) {
+        return intensity > 0;
+    } );
+}
+
+TEST_CASE( "buffered gas spreading is reproducible", "[field]" )
+{
+    clear_all_state();
+    override_option buffered( "BUFFERED_FIELD_SPREAD", "true" );
+    const std::vector<tripoint> sources = {
+        tripoint( 40, 40, 0 ), tripoint( 43, 40, 0 ), tripoint( 60, 60, 0 )
+    };
+
+    const std::vector<int> first = spread_gas( fd_smoke, sources, 10 );
+    CHECK( count_gas_tiles( first ) > static_cast<int>( sources.size() ) );
+    // Whatever else used the RNG in between doesn't matter.
+    for( int i = 0; i < 17; i++ ) {
+        rng( 0, 100 );
+    }
+    CHECK( spread_gas( fd_smoke, sources, 10 ) == first );
+}
+
+TEST_CASE( "field entries are visited in type order", "[field]" )
+{
+    std::vector<field_type_id> types = { fd_smoke, fd_acid, fd_fire, fd_blood, fd_bile };
+    field fld;
+    for( const field_type_id &type : types ) {
+        REQUIRE( fld.add_field( type, 1 ) );
+    }
+    std::sort( types.begin(), types.end() );
+    std::vector<field_type_id> visited;
+    for( const auto &fd : fld ) {
+        visited.push_back( fd.first );
+    }
+    CHECK( visited == types );
+
+    // Removing and adding again doesn't change the order either.
+    REQUIRE( fld.remove_field( types.front() ) );
+    REQUIRE( fld.add_field( types.front(), 1 ) );
+    visited.clear();
+    for( const auto &fd : fld ) {
+        visited.push_back( fd.first );
+    }
+    CHECK( visited == types );
+}
+
+TEST_CASE( "buffered gas spreading keeps all of the gas", "[field]" )
+{
+    clear_all_state();
+    // Tear gas doesn't decay for much longer than this runs, so spreading is all that
+    // changes the amount. The sources sit next to submap borders and far from each other.
+    const std::vector<tripoint> sources = {
+        tripoint( 35, 35, 0 ), tripoint( 95, 35, 0 ), tripoint( 35, 95, 0 ), tripoint( 95, 95, 0 )
+    };
+    const int turns = 40;
+    std::vector<int> unbuffered;
+    std::vector<int> buffered;
+    {
+        override_option option( "BUFFERED_FIELD_SPREAD", "false" );
+        unbuffered = spread_gas( fd_tear_gas, sources, turns );
+    }
+    {
+        override_option option( "BUFFERED_FIELD_SPREAD", "true" );
+        buffered = spread_gas( fd_tear_gas, sources, turns );
+    }
+    const int unbuffered_total = std::accumulate( unbuffered.begin(), unbuffered.end(), 0 );
+    CHECK( unbuffered_total == 3 * static_cast<int>( sources.size() ) );
+    CHECK( std::accumulate( buffered.begin(), buffered.end(), 0 ) == unbuffered_total );
+    CHECK( count_gas_tiles( unbuffered ) > static_cast<int>( sources.size() ) );
+    CHECK( count_gas_tiles( buffered ) > static_cast<int>( sources.size() ) );
+}
+
+TEST_CASE( "process_fields_benchmark", "[.][field][benchmark]" )
+{
+    clear_all_state();
+    map &here = get_map();
+    const tripoint_range<tripoint> fire_area = here.points_in_rectangle( tripoint( 30, 30, 0 ),
+            tripoint( 90, 90, 0 ) );
+
+    BENCHMARK_ADVANCED( "scattered fires" )( Catch::Benchmark::Chronometer meter ) {
+        clear_fields( 0 );
+        for( const tripoint &p : fire_area ) {
+            if( ( p.x + p.y ) % 7 == 0 ) {
+                here.add_field( p, fd_fire, 2 );
+            }
+        }
+        meter.measure( [&]() {
+            here.process_fields();
+        } );
+    };
+    BENCHMARK_ADVANCED( "a few fields" )( Catch::Benchmark::Chronometer meter ) {
+        clear_fields( 0 );
+        for( const tripoint &p : fire_area ) {
+            if( p.x % 12 == 0 && p.y % 12 == 0 ) {
+                here.add_field( p, fd_blood, 1 );
+            }
+        }
+        meter.measure( [&]() {
+            here.process_fields();
+        } );
+    };
+}
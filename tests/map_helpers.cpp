@@ -10,6 +10,7 @@
 
 #include "avatar.h"
 #include "calendar.h"
+#include "distribution_grid.h"
 #include "field.h"
 #include "game.h"
 #include "game_constants.h"
@@ -94,6 +95,9 @@ void clear_overmap()
 {
     MAPBUFFER.reset();
     overmap_buffer.clear();
+    // The game map still points at the deleted submaps
+    g->m.load( tripoint( g->get_levx(), g->get_levy(), g->get_levz() ), false );
+    get_distribution_grid_tracker().load( g->m );
 }
 
 void clear_map()
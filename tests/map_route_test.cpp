@@ -0,0 +1,353 @@
+#include "catch/catch.hpp"
+
+#include <algorithm>
+#include <future>
+#include <queue>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "bucket_queue.h"
+#include "cata_utility.h"
+#include "flow_field.h"
+#include "game.h"
+#include "line.h"
+#include "map.h"
+#include "map_helpers.h"
+#include "optional.h"
+#include "pathfinding.h"
+#include "point.h"
+#include "type_id.h"
+
+static pathfinding_settings test_settings()
+{
+    return pathfinding_settings( 0, 100, 1000, 0, false, false, true, false, false );
+}
+
+// A floor split by a wall from north to south, with a single gap in it.
+static void build_wall_map()
+{
+    clear_map();
+    build_test_map( t_floor );
+    map &here = get_map();
+    for( int y = 0; y < MAPSIZE_Y; y++ ) {
+        here.ter_set( tripoint( 60, y, 0 ), t_wall );
+    }
+    here.ter_set( tripoint( 60, 72, 0 ), t_floor );
+}
+
+static void check_valid_route( const std::vector<tripoint> &route, const tripoint &from,
+                               const tripoint &to )
+{
+    REQUIRE_FALSE( route.empty() );
+    CHECK( route.back() == to );
+    tripoint prev = from;
+    for( const tripoint &p : route ) {
+        CHECK( square_dist( prev, p ) == 1 );
+        CHECK( get_map().ter( p ) != t_wall );
+        prev = p;
+    }
+}
+
+TEST_CASE( "bucket queue pops lowest priorities first", "[pathfinding]" )
+{
+    cata::bucket_queue<int> queue;
+    for( int i : {
+             5, 3, 9, 0, 3, 7
+         } ) {
+        queue.push( i, i );
+    }
+    queue.push( 2, 2 );
+    std::vector<int> popped;
+    popped.push_back( queue.pop() );
+    popped.push_back( queue.pop() );
+    // Lower than what was popped already.
+    queue.push( 1, 1 );
+    while( !queue.empty() ) {
+        popped.push_back( queue.pop() );
+    }
+    CHECK( popped == std::vector<int> { 0, 2, 1, 3, 3, 5, 7, 9 } );
+
+    queue.push( 4, 4 );
+    queue.push( 6, 6 );
+    queue.clear();
+    CHECK( queue.empty() );
+    queue.push( 8, 8 );
+    CHECK( queue.pop() == 8 );
+}
+
+TEST_CASE( "map route goes around walls", "[pathfinding]" )
+{
+    build_wall_map();
+    const tripoint from( 50, 60, 0 );
+    const tripoint to( 70, 60, 0 );
+    map &here = get_map();
+
+    const std::vector<tripoint> route = here.route( from, to, test_settings() );
+    check_valid_route( route, from, to );
+    CHECK( std::any_of( route.begin(), route.end(), []( const tripoint & p ) {
+        return p == tripoint( 60, 72, 0 );
+    } ) );
+
+    SECTION( "searches do not see data of earlier ones" ) {
+        here.ter_set( tripoint( 60, 72, 0 ), t_wall );
+        CHECK( here.route( from, to, test_settings() ).empty() );
+        here.ter_set( tripoint( 60, 72, 0 ), t_floor );
+        const std::vector<tripoint> reopened = here.route( from, to, test_settings() );
+        check_valid_route( reopened, from, to );
+        CHECK( std::count( reopened.begin(), reopened.end(), tripoint( 60, 72, 0 ) ) == 1 );
+    }
+
+    SECTION( "pre-closed tiles are avoided" ) {
+        const std::set<tripoint> pre_closed = { tripoint( 60, 72, 0 ) };
+        CHECK( here.route( from, to, test_settings(), pre_closed ).empty() );
+        CHECK( here.route( from, to, test_settings() ) == route );
+    }
+
+    SECTION( "other threads search with pathfinders of their own" ) {
+        // The caches are up to date after the search above, so nothing is written to the map.
+        std::future<std::vector<tripoint>> other = std::async( std::launch::async, [&]() {
+            return here.route( from, to, test_settings() );
+        } );
+        CHECK( other.get() == route );
+    }
+}
+
+TEST_CASE( "pathfinding cache only rebuilds changed submaps", "[pathfinding]" )
+{
+    build_wall_map();
+    map &here = get_map();
+    here.get_pathfinding_cache_ref( 0 );
+    here.take_pathfinding_cache_stats();
+
+    const tripoint p( 30, 30, 0 );
+    here.ter_set( p, t_wall );
+    CHECK( ( here.get_pathfinding_cache_ref( 0 ).special[p.x][p.y] & PF_WALL ) != 0 );
+    CHECK( ( here.get_pathfinding_cache_ref( 0 ).special[60][10] & PF_WALL ) != 0 );
+    const pathfinding_cache_stats stats = here.take_pathfinding_cache_stats();
+    CHECK( stats.full_rebuilds == 0 );
+    CHECK( stats.submaps_rebuilt == 1 );
+    CHECK( stats.submaps_kept == MAPSIZE * MAPSIZE - 1 );
+
+    here.ter_set( p, t_floor );
+    CHECK( ( here.get_pathfinding_cache_ref( 0 ).special[p.x][p.y] & PF_WALL ) == 0 );
+}
+
+TEST_CASE( "long routes are planned over the submaps", "[pathfinding]" )
+{
+    build_wall_map();
+    map &here = get_map();
+    const tripoint from( 10, 10, 0 );
+    const tripoint to( 105, 105, 0 );
+
+    const std::vector<tripoint> route = here.route( from, to, test_settings() );
+    check_valid_route( route, from, to );
+    CHECK( std::count( route.begin(), route.end(), tripoint( 60, 72, 0 ) ) == 1 );
+
+    here.ter_set( tripoint( 60, 72, 0 ), t_wall );
+    CHECK( here.route( from, to, test_settings() ).empty() );
+
+    SECTION( "changed submaps are built again" ) {
+        here.ter_set( tripoint( 60, 40, 0 ), t_floor );
+        const std::vector<tripoint> changed = here.route( from, to, test_settings() );
+        check_valid_route( changed, from, to );
+        CHECK( std::count( changed.begin(), changed.end(), tripoint( 60, 40, 0 ) ) == 1 );
+        here.ter_set( tripoint( 60, 40, 0 ), t_wall );
+        here.ter_set( tripoint( 60, 72, 0 ), t_floor );
+        CHECK( here.route( from, to, test_settings() ) == route );
+    }
+
+    SECTION( "steps across a border that no run of tiles covers are found" ) {
+        // Only a diagonal step from 59,72 to 60,73 gets across the wall now.
+        for( int y = 73; y < MAPSIZE_Y; y++ ) {
+            here.ter_set( tripoint( 59, y, 0 ), t_wall );
+        }
+        here.ter_set( tripoint( 60, 73, 0 ), t_floor );
+        const std::vector<tripoint> diagonal = here.route( from, to, test_settings() );
+        check_valid_route( diagonal, from, to );
+        CHECK( std::count( diagonal.begin(), diagonal.end(), tripoint( 59, 72, 0 ) ) == 1 );
+        CHECK( std::count( diagonal.begin(), diagonal.end(), tripoint( 60, 73, 0 ) ) == 1 );
+    }
+
+    SECTION( "stairs lead to other z-levels" ) {
+        REQUIRE( here.has_zlevels() );
+        for( int x = 0; x < MAPSIZE_X; x++ ) {
+            for( int y = 0; y < MAPSIZE_Y; y++ ) {
+                here.ter_set( tripoint( x, y, -1 ), t_floor );
+            }
+        }
+        here.ter_set( tripoint( 20, 20, 0 ), t_stairs_down );
+        here.ter_set( tripoint( 20, 20, -1 ), t_stairs_up );
+
+        const tripoint below( 100, 100, -1 );
+        const std::vector<tripoint> down = here.route( from, below, test_settings() );
+        check_valid_route( down, from, below );
+        CHECK( std::count( down.begin(), down.end(), tripoint( 20, 20, -1 ) ) == 1 );
+        // Back up and across the wall, which has no gap anymore.
+        CHECK( here.route( below, to, test_settings() ).empty() );
+        const std::vector<tripoint> up = here.route( below, from, test_settings() );
+        check_valid_route( up, below, from );
+        CHECK( std::count( up.begin(), up.end(), tripoint( 20, 20, 0 ) ) == 1 );
+    }
+}
+
+TEST_CASE( "flow fields are shared by creatures with the same target", "[pathfinding]" )
+{
+    build_wall_map();
+    map &here = get_map();
+    const tripoint target( 70, 60, 0 );
+    const pathfinding_settings settings = test_settings();
+
+    // Not worth it for single creatures.
+    CHECK( here.get_flow_field( target, settings ) == nullptr );
+    CHECK( here.get_flow_field( target, settings ) == nullptr );
+    const flow_field *field = here.get_flow_field( target, settings );
+    REQUIRE( field != nullptr );
+    CHECK( here.get_flow_field( target, settings ) == field );
+
+    for( const tripoint &from : {
+             tripoint( 50, 60, 0 ), tripoint( 40, 30, 0 ), tripoint( 80, 80, 0 )
+         } ) {
+        const cata::optional<std::vector<tripoint>> route = field->route_from( here, from );
+        REQUIRE( route );
+        check_valid_route( *route, from, target );
+    }
+    const cata::optional<std::vector<tripoint>> to_itself = field->route_from( here, target );
+    REQUIRE( to_itself );
+    CHECK( to_itself->empty() );
+
+    // Closing the gap changes the pathfinding cache, so the field has to be rebuilt.
+    here.ter_set( tripoint( 60, 72, 0 ), t_wall );
+    field = here.get_flow_field( target, settings );
+    REQUIRE( field != nullptr );
+    const cata::optional<std::vector<tripoint>> blocked = field->route_from( here,
+            tripoint( 50, 60, 0 ) );
+    REQUIRE( blocked );
+    CHECK( blocked->empty() );
+    const cata::optional<std::vector<tripoint>> route = field->route_from( here,
+            tripoint( 80, 80, 0 ) );
+    REQUIRE( route );
+    check_valid_route( *route, tripoint( 80, 80, 0 ), target );
+}
+
+// What map::route pays for a route, from the same step costs.
+static int route_cost( const tripoint &from, const std::vector<tripoint> &route,
+                       const pathfinding_settings &settings )
+{
+    map &here = get_map();
+    const pathfinding_cache &pf_cache = here.get_pathfinding_cache_ref( from.z );
+    int cost = 0;
+    tripoint prev = from;
+    for( const tripoint &p : route ) {
+        const route_step step = here.route_step_cost( pf_cache, prev, p, settings );
+        REQUIRE( step.what == route_step::kind::enter );
+        cost += step.cost + ( prev.x != p.x && prev.y != p.y ? 1 : 0 );
+        prev = p;
+    }
+    return cost;
+}
+
+TEST_CASE( "flow fields cost the same as map routes", "[pathfinding]" )
+{
+    build_wall_map();
+    map &here = get_map();
+    // Slow and unbashable tiles between the creatures and the target.
+    for( int y = 50; y < 70; y += 2 ) {
+        here.ter_set( tripoint( 64, y, 0 ), t_dirtmound );
+        here.ter_set( tripoint( 66, y + 1, 0 ), t_wall );
+    }
+    const tripoint target( 70, 60, 0 );
+    const pathfinding_settings settings = test_settings();
+    const flow_field field( here, target, settings );
+
+    // Further away map::route plans over the submaps first, which is never cheaper.
+    int compared = 0;
+    for( int x = 48; x <= 92; x += 4 ) {
+        for( int y = 38; y <= 82; y += 4 ) {
+            const tripoint from( x, y, 0 );
+            if( here.ter( from ) == t_wall ) {
+                continue;
+            }
+            CAPTURE( from );
+            const cata::optional<std::vector<tripoint>> shared = field.route_from( here, from );
+            const std::vector<tripoint> route = here.route( from, target, settings );
+            if( !shared ) {
+                continue;
+            }
+            compared++;
+            REQUIRE( shared->empty() == route.empty() );
+            if( !route.empty() ) {
+                check_valid_route( *shared, from, target );
+                CHECK( route_cost( from, *shared, settings ) == route_cost( from, route, settings ) );
+            }
+        }
+    }
+    CHECK( compared > 50 );
+}
+
+TEST_CASE( "map_route_benchmark", "[.][pathfinding][benchmark]" )
+{
+    build_wall_map();
+    map &here = get_map();
+    const pathfinding_settings settings = test_settings();
+
+    BENCHMARK( "straight line" ) {
+        return here.route( tripoint( 30, 30, 0 ), tripoint( 50, 50, 0 ), settings ).size();
+    };
+    BENCHMARK( "around a wall" ) {
+        return here.route( tripoint( 50, 60, 0 ), tripoint( 70, 60, 0 ), settings ).size();
+    };
+    BENCHMARK( "long route through the gap" ) {
+        return here.route( tripoint( 50, 60, 0 ), tripoint( 130, 130, 0 ), settings ).size();
+    };
+    BENCHMARK( "flow field for the whole map" ) {
+        const flow_field field( here, tripoint( 70, 60, 0 ), settings );
+        return field.route_from( here, tripoint( 50, 60, 0 ) )->size();
+    };
+}
+
+// Replays the pushes and pops of an A* search over open ground, which is what the open
+// list of map::route sees most of the time.
+template<typename Push, typename Pop>
+static int replay_open_list( Push push, Pop pop )
+{
+    int sum = 0;
+    int g = 0;
+    for( int step = 0; step < 2000; step++ ) {
+        for( int n = 0; n < 8; n++ ) {
+            push( g + 2 + n % 3 );
+        }
+        for( int n = 0; n < 7; n++ ) {
+            g = pop();
+            sum += g;
+        }
+    }
+    return sum;
+}
+
+TEST_CASE( "open_list_benchmark", "[.][pathfinding][benchmark]" )
+{
+    using entry = std::pair<int, tripoint>;
+    // The open list used by map::route before it was replaced with cata::bucket_queue.
+    BENCHMARK( "std::priority_queue" ) {
+        std::priority_queue<entry, std::vector<entry>, pair_greater_cmp_first> open;
+        return replay_open_list( [&]( int score ) {
+            open.push( std::make_pair( score, tripoint_zero ) );
+        }, [&]() {
+            const int score = open.top().first;
+            open.pop();
+            return score;
+        } );
+    };
+    cata::bucket_queue<tripoint> reused;
+    BENCHMARK( "cata::bucket_queue" ) {
+        reused.clear();
+        return replay_open_list( [&]( int score ) {
+            reused.push( score, tripoint_zero );
+        }, [&]() {
+            const int score = reused.top_priority();
+            reused.pop();
+            return score;
+        } );
+    };
+}
@@ -1,6 +1,29 @@
 #include "catch/catch.hpp"
 
+#include <algorithm>
+#include <map>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "calendar.h"
+#include "debug.h"
+#include "cata_utility.h"
+#include "coordinates.h"
+#include "map.h"
+#include "map_helpers.h"
+#include "mapbuffer.h"
 #include "mapgen.h"
+#include "mapgen_functions.h"
+#include "omdata.h"
+#include "overmap.h"
+#include "overmapbuffer.h"
+#include "regional_settings.h"
+#include "rng.h"
+#include "state_helpers.h"
+#include "submap.h"
 #include "type_id.h"
 
 TEST_CASE( "connects_to", "[mapgen][connects]" )
@@ -88,3 +111,236 @@ TEST_CASE( "connects_to", "[mapgen][connects]" )
         CHECK( connects_to( oter_id( "sewer_nesw" ), west ) );
     }
 }
+
+static std::vector<std::pair<ter_id, furn_id>> quad_tiles( const tripoint &p )
+{
+    std::vector<std::pair<ter_id, furn_id>> tiles;
+    for( const point &sm_offset : { point_zero, point_east, point_south, point_south_east } ) {
+        const submap *sm = MAPBUFFER.lookup_submap( p + sm_offset );
+        REQUIRE( sm != nullptr );
+        for( int x = 0; x < SEEX; x++ ) {
+            for( int y = 0; y < SEEY; y++ ) {
+                tiles.emplace_back( sm->get_ter( point( x, y ) ), sm->get_furn( point( x, y ) ) );
+            }
+        }
+    }
+    return tiles;
+}
+
+// Places the terrains next to each other in the first overmap, returns their quads.
+static std::vector<tripoint> place_quads( const std::vector<oter_id> &terrains )
+{
+    overmap &om = overmap_buffer.get( point_abs_om() );
+    std::vector<tripoint> quads;
+    for( size_t i = 0; i < terrains.size(); i++ ) {
+        const tripoint_om_omt p( 10 + 2 * static_cast<int>( i % 80 ), 10 + 2 * static_cast<int>( i / 80 ),
+                                 0 );
+        om.ter_set( p, terrains[i] );
+        quads.push_back( project_combine( om.pos(), project_to<coords::sm>( p ) ).raw() );
+    }
+    return quads;
+}
+
+TEST_CASE( "quads drawn on workers don't depend on the quads drawn with them", "[mapgen]" )
+{
+    clear_all_state();
+    restore_on_out_of_scope<bool> restore_mapgen( disable_mapgen );
+    disable_mapgen = false;
+
+    // The rivers are drawn on the thread pool (two of them rotated), the houses on the game thread.
+    const std::vector<oter_id> terrains = {
+        oter_id( "river_center" ), oter_id( "river_east" ), oter_id( "house_01_north" ),
+        oter_id( "river_se" ), oter_id( "river_c_not_nw" ), oter_id( "house_01_north" )
+    };
+    const auto generate = [&]( bool reversed, unsigned int seed ) {
+        clear_overmap();
+        std::vector<tripoint> quads = place_quads( terrains );
+        if( reversed ) {
+            std::reverse( quads.begin(), quads.end() );
+        }
+        rng_set_engine_seed( seed );
+        map::generate_quads( quads, calendar::turn );
+        std::map<tripoint, std::vector<std::pair<ter_id, furn_id>>> rivers;
+        for( const tripoint &p : quads ) {
+            const std::vector<std::pair<ter_id, furn_id>> tiles = quad_tiles( p );
+            const oter_id ter = overmap_buffer.ter( tripoint_abs_omt( sm_to_omt_copy( p ) ) );
+            if( mapgen_is_thread_safe( ter->get_mapgen_id() ) ) {
+                rivers.emplace( p, tiles );
+            }
+        }
+        return rivers;
+    };
+
+    const std::map<tripoint, std::vector<std::pair<ter_id, furn_id>>> forward = generate( false, 1234 );
+    const std::map<tripoint, std::vector<std::pair<ter_id, furn_id>>> backward = generate( true, 4321 );
+    CHECK( forward.size() == 4 );
+    CHECK( backward == forward );
+    clear_overmap();
+}
+
+TEST_CASE( "quads drawn on the game thread use the game's rng", "[mapgen]" )
+{
+    clear_all_state();
+    restore_on_out_of_scope<bool> restore_mapgen( disable_mapgen );
+    disable_mapgen = false;
+
+    const auto generate = [&]( bool batched, unsigned int seed ) {
+        clear_overmap();
+        const tripoint quad = place_quads( { oter_id( "river_east" ) } ).front();
+        rng_set_engine_seed( seed );
+        if( batched ) {
+            map::generate_quads( { quad }, calendar::turn );
+        } else {
+            tinymap tm;
+            tm.generate( quad, calendar::turn );
+        }
+        return quad_tiles( quad );
+    };
+
+    const std::vector<std::pair<ter_id, furn_id>> alone = generate( false, 1234 );
+    CHECK( generate( true, 1234 ) == alone );
+    CHECK( generate( false, 4321 ) != alone );
+    clear_overmap();
+}
+
+TEST_CASE( "mapgen drawn on workers only draws terrain and furniture", "[mapgen]" )
+{
+    clear_all_state();
+    restore_on_out_of_scope<bool> restore_mapgen( disable_mapgen );
+    disable_mapgen = false;
+    // Map extras are placed on the game thread and may place anything.
+    auto &extras = region_settings_map["default"].region_extras;
+    restore_on_out_of_scope<std::unordered_map<std::string, map_extras>> restore_extras( extras );
+    extras.clear();
+
+    // One terrain for every mapgen id that mapgen_function::is_thread_safe lets onto the workers.
+    std::set<std::string> mapgen_ids;
+    std::vector<oter_id> terrains;
+    for( const oter_t &ter : overmap_terrains::get_all() ) {
+        const std::string mapgen_id = ter.get_mapgen_id();
+        if( mapgen_is_thread_safe( mapgen_id ) && mapgen_ids.insert( mapgen_id ).second ) {
+            terrains.push_back( ter.id.id() );
+        }
+    }
+    REQUIRE( terrains.size() > 1 );
+
+    clear_overmap();
+    const std::vector<tripoint> quads = place_quads( terrains );
+    // A worker that reaches debugmsg, or the overmap buffer (which debugmsgs), fails this.
+    CHECK( capture_debugmsg_during( [&quads]() {
+        map::generate_quads( quads, calendar::turn );
+    } ).empty() );
+    for( const tripoint &p : quads ) {
+        for( const point &sm_offset : { point_zero, point_east, point_south, point_south_east } ) {
+            const submap *sm = MAPBUFFER.lookup_submap( p + sm_offset );
+            REQUIRE( sm != nullptr );
+            INFO( overmap_buffer.ter( tripoint_abs_omt( sm_to_omt_copy( p ) ) ).id().str() );
+            CHECK( sm->vehicles.empty() );
+            CHECK( sm->active_furniture.empty() );
+            CHECK( sm->field_count == 0 );
+            CHECK( sm->camp == nullptr );
+            bool has_items_or_computers = false;
+            for( int x = 0; x < SEEX; x++ ) {
+                for( int y = 0; y < SEEY; y++ ) {
+                    has_items_or_computers |= !sm->get_items( point( x, y ) ).empty() ||
+                                              sm->has_computer( point( x, y ) );
+                }
+            }
+            CHECK_FALSE( has_items_or_computers );
+        }
+    }
+    clear_overmap();
+}
+
+TEST_CASE( "lowered json mapgen generates the expected map", "[mapgen]" )
+{
+    clear_all_state();
+    restore_on_out_of_scope<bool> restore_mapgen( disable_mapgen );
+    disable_mapgen = false;
+
+    // test_lowered_mapgen from data/mods/TEST_DATA/mapgen.json: the rows, followed by the
+    // setmaps (a line of dirt, a rack), a wall over the first chair, a door and a bookcase.
+    const std::vector<std::string> expected = {
+        "############+###########",
+        "#......................#",
+        "#.tt...................#",
+        "#......................#",
+        "#......................#",
+        "#....#.................#",
+        "#......................#",
+        "#......................#",
+        "#......................#",
+        "#......................#",
+        "#._______..............#",
+        "#......................#",
+        "#......................#",
+        "#......................#",
+        "#......................#",
+        "#..............b.......#",
+        "#......................#",
+        "#......................#",
+        "#..................c...#",
+        "#......................#",
+        "#...................r..#",
+        "#......................#",
+        "#......................#",
+        "########################",
+    };
+    const std::map<char, std::pair<ter_str_id, furn_str_id>> legend = {
+        { '#', { ter_str_id( "t_wall" ), furn_str_id( "f_null" ) } },
+        { '.', { ter_str_id( "t_floor" ), furn_str_id( "f_null" ) } },
+        { '_', { ter_str_id( "t_dirt" ), furn_str_id( "f_null" ) } },
+        { '+', { ter_str_id( "t_door_c" ), furn_str_id( "f_null" ) } },
+        { 't', { ter_str_id( "t_floor" ), furn_str_id( "f_table" ) } },
+        { 'c', { ter_str_id( "t_floor" ), furn_str_id( "f_chair" ) } },
+        { 'b', { ter_str_id( "t_floor" ), furn_str_id( "f_bookcase" ) } },
+        { 'r', { ter_str_id( "t_floor" ), furn_str_id( "f_rack" ) } },
+    };
+
+    overmap &om = overmap_buffer.get( point_abs_om() );
+    const tripoint_om_omt p( 90, 90, 0 );
+    om.ter_set( p, oter_id( "test_lowered_mapgen" ) );
+    const tripoint sm_pos = project_combine( om.pos(), project_to<coords::sm>( p ) ).raw();
+    tinymap tm;
+    tm.generate( sm_pos, calendar::turn );
+
+    for( int y = 0; y < SEEY * 2; y++ ) {
+        for( int x = 0; x < SEEX * 2; x++ ) {
+            const submap *sm = MAPBUFFER.lookup_submap( sm_pos + point( x / SEEX, y / SEEY ) );
+            REQUIRE( sm != nullptr );
+            const point local( x % SEEX, y % SEEY );
+            const std::pair<ter_str_id, furn_str_id> &tile = legend.at( expected[y][x] );
+            INFO( "x " << x << " y " << y );
+            CHECK( sm->get_ter( local ) == tile.first.id() );
+            CHECK( sm->get_furn( local ) == tile.second.id() );
+        }
+    }
+    clear_overmap();
+}
+
+TEST_CASE( "json_mapgen_benchmark", "[.][mapgen][benchmark]" )
+{
+    clear_all_state();
+    restore_on_out_of_scope<bool> restore_mapgen( disable_mapgen );
+    disable_mapgen = false;
+    overmap &om = overmap_buffer.get( point_abs_om() );
+
+    // Every run generates a fresh overmap terrain, so nothing is loaded from the map buffer.
+    int next = 0;
+    const auto generate = [&]( const oter_id & terrain ) {
+        const tripoint_om_omt p( next % OMAPX, next / OMAPX % OMAPY, 0 );
+        next++;
+        om.ter_set( p, terrain );
+        tinymap tm;
+        tm.load( project_combine( om.pos(), project_to<coords::sm>( p ) ), false );
+        return tm.ter( point_zero );
+    };
+
+    BENCHMARK( "house" ) {
+        return generate( oter_id( "house_01_north" ) );
+    };
+    BENCHMARK( "restaurant" ) {
+        return generate( oter_id( "s_restaurant_north" ) );
+    };
+    clear_all_state();
+}
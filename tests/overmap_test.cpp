@@ -2,11 +2,16 @@
 
 #include <algorithm>
 #include <memory>
+#include <string>
 #include <vector>
 
 #include "calendar.h"
+#include "cata_utility.h"
+#include "debug.h"
 #include "enums.h"
+#include "filesystem.h"
 #include "game_constants.h"
+#include "map_helpers.h"
 #include "numeric_interval.h"
 #include "omdata.h"
 #include "overmap.h"
@@ -14,6 +19,7 @@
 #include "overmap_types.h"
 #include "overmapbuffer.h"
 #include "point.h"
+#include "rng.h"
 #include "state_helpers.h"
 #include "type_id.h"
 
@@ -217,3 +223,165 @@ TEST_CASE( "is_ot_match", "[overmap][terrain]" )
         CHECK_FALSE( is_ot_match( "forestry", oter_id( "forest" ), ot_match_type::contains ) );
     }
 }
+
+TEST_CASE( "find_closest and find_all use the terrain index", "[overmap][terrain]" )
+{
+    clear_all_state();
+    overmap_special_batch no_specials( point_abs_om{} );
+    overmap_buffer.create_custom_overmap( point_abs_om{}, no_specials );
+
+    const oter_id cabin( "cabin_north" );
+    const tripoint_abs_omt origin( 90, 90, 0 );
+    const tripoint_abs_omt near( 94, 87, 0 );
+    const tripoint_abs_omt below( 85, 91, -2 );
+    const tripoint_abs_omt far( 130, 90, 0 );
+    for( const tripoint_abs_omt &p : {
+             near, below, far
+         } ) {
+        overmap_buffer.ter_set( p, cabin );
+    }
+
+    omt_find_params params;
+    params.types = { { "cabin", ot_match_type::type } };
+    params.existing_only = true;
+    CHECK( overmap_buffer.find_closest( origin, params ) == near );
+    CHECK( overmap_buffer.find_all( origin, params ) == std::vector<tripoint_abs_omt> { near, far } );
+
+    params.min_distance = 5;
+    CHECK( overmap_buffer.find_closest( origin, params ) == below );
+    params.min_distance = 0;
+
+    // The index follows changes of the terrain.
+    overmap_buffer.ter_set( near, oter_id( "field" ) );
+    CHECK( overmap_buffer.find_closest( origin, params ) == below );
+    const tripoint_abs_omt closer( 88, 91, -1 );
+    overmap_buffer.ter_set( closer, cabin );
+    CHECK( overmap_buffer.find_closest( origin, params ) == closer );
+
+    // Default terrain is not indexed, it is still found by checking every location.
+    overmap_buffer.ter_set( origin + tripoint_below, oter_id( "empty_rock" ) );
+    params.types = { { "empty_rock", ot_match_type::type } };
+    CHECK( overmap_buffer.find_closest( origin, params ) == origin + tripoint_below );
+}
+
+TEST_CASE( "overmaps do not depend on what was drawn from the rng before",
+           "[overmap][slow]" )
+{
+    const point_abs_om center{};
+    const auto surface = []( const overmap & om ) {
+        std::vector<oter_id> result;
+        for( int x = 0; x < OMAPX; x++ ) {
+            for( int y = 0; y < OMAPY; y++ ) {
+                result.push_back( om.ter( { x, y, 0 } ) );
+            }
+        }
+        return result;
+    };
+
+    clear_all_state();
+    clear_overmap();
+    const std::vector<oter_id> first = surface( overmap_buffer.get( center ) );
+
+    clear_overmap();
+    for( int i = 0; i < 100; i++ ) {
+        rng( 0, 100 );
+    }
+    const std::vector<oter_id> second = surface( overmap_buffer.get( center ) );
+    CHECK( std::equal( first.begin(), first.end(), second.begin() ) );
+    clear_overmap();
+}
+
+TEST_CASE( "overmaps generated in the background match those generated one by one",
+           "[overmap][slow]" )
+{
+    const point_abs_om center{};
+    // The order generate_around uses
+    const std::vector<point_abs_om> around = {
+        center + point_north, center + point_east, center + point_south, center + point_west,
+        center + point_north_east, center + point_south_east, center + point_south_west,
+        center + point_north_west
+    };
+    const auto terrain = []( const overmap & om ) {
+        std::vector<oter_id> result;
+        for( int z = -1; z <= 0; z++ ) {
+            for( int x = 0; x < OMAPX; x++ ) {
+                for( int y = 0; y < OMAPY; y++ ) {
+                    result.push_back( om.ter( { x, y, z } ) );
+                }
+            }
+        }
+        return result;
+    };
+
+    clear_all_state();
+    clear_overmap();
+    overmap_buffer.get( center );
+    std::vector<std::vector<oter_id>> one_by_one;
+    for( const point_abs_om &p : around ) {
+        one_by_one.push_back( terrain( overmap_buffer.get( p ) ) );
+    }
+
+    clear_overmap();
+    overmap_buffer.get( center );
+    std::vector<std::vector<oter_id>> generated;
+    // Workers that debugmsg, or touch the overmap buffer (which debugmsgs), fail this.
+    CHECK( capture_debugmsg_during( [&]() {
+        overmap_buffer.generate_around( center );
+        for( const point_abs_om &p : around ) {
+            generated.push_back( terrain( overmap_buffer.get( p ) ) );
+        }
+    } ).empty() );
+    for( size_t i = 0; i < around.size(); i++ ) {
+        CAPTURE( around[i] );
+        CHECK( generated[i] == one_by_one[i] );
+    }
+    clear_overmap();
+}
+
+TEST_CASE( "only changed overmaps are saved", "[overmap]" )
+{
+    clear_all_state();
+    // Nothing else may be in the buffer, or it would be saved into the test world too.
+    overmap_buffer.clear();
+    // Far away from the overmaps other tests use, its files are removed again below.
+    const point_abs_om pos( 40, 40 );
+    const std::string terrain_file = overmapbuffer::terrain_filename( pos );
+    const std::string view_file = overmapbuffer::player_filename( pos );
+    on_out_of_scope remove_files( [&]() {
+        remove_directory( terrain_file );
+        remove_file( terrain_file );
+        remove_file( view_file );
+        clear_overmap();
+    } );
+    overmap_special_batch no_specials( pos );
+    overmap_buffer.create_custom_overmap( pos, no_specials );
+    overmap &om = *overmap_buffer.get_existing( pos );
+    REQUIRE( om.get_npcs().empty() );
+    CHECK( om.needs_saving() );
+    overmap_buffer.save();
+    CHECK_FALSE( om.needs_saving() );
+    CHECK( file_exist( terrain_file ) );
+
+    // Unchanged overmaps are not written again.
+    remove_file( terrain_file );
+    overmap_buffer.save();
+    CHECK_FALSE( file_exist( terrain_file ) );
+
+    const tripoint_om_omt p( 10, 10, 0 );
+    om.set_seen( p, om.seen( p ) );
+    CHECK_FALSE( om.needs_saving() );
+    om.set_seen( p, !om.seen( p ) );
+    CHECK( om.needs_saving() );
+    overmap_buffer.save();
+    CHECK( file_exist( terrain_file ) );
+    om.ter_set( p, oter_id( "field" ) );
+    CHECK( om.needs_saving() );
+
+    SECTION( "a failed write fails the save and keeps the overmap changed" ) {
+        // A directory where the file should be can't be written to.
+        remove_file( terrain_file );
+        REQUIRE( assure_dir_exist( terrain_file ) );
+        CHECK_THROWS( overmap_buffer.save() );
+        CHECK( om.needs_saving() );
+    }
+}
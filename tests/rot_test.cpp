@@ -1,5 +1,6 @@
 #include "catch/catch.hpp"
 
+#include <cmath>
 #include <memory>
 
 #include "calendar.h"
@@ -9,7 +10,9 @@
 #include "map_helpers.h"
 #include "game.h" // Just for get_convection_temperature(), TODO: Remove
 #include "point.h"
+#include "rot.h"
 #include "weather.h"
+#include "weather_gen.h"
 
 static const furn_str_id f_atomic_freezer( "f_atomic_freezer" );
 
@@ -194,3 +197,62 @@ TEST_CASE( "Items don't rot away on map load if in a freezer" )
     auto normal_stack_after = m.i_at( normal_pnt );
     REQUIRE( normal_stack_after.empty() );
 }
+
+// Rot of food at pos processed from `from` to `to` one hour at a time, stopping when it rots away.
+static time_duration rot_hour_by_hour( const weather_manager &weather, const item &food,
+                                       const tripoint &pos, const time_point &from, const time_point &to, temperature_flag flag )
+{
+    const weather_generator &wgen = weather.get_cur_weather_gen();
+    const tripoint_abs_ms location( get_map().getabs( pos ) );
+    time_duration rot = food.get_rot();
+    time_point time = from;
+    while( to - time > 1_hours ) {
+        const time_duration time_delta = std::min( 1_hours, to - 1_hours - time );
+        time += time_delta;
+        const units::temperature temperature = rot::clip_by_temperature_flag(
+                wgen.get_weather_temperature( location, time, calendar::config, g->get_seed() ), flag );
+        rot += rot::rot_over( time_delta,
+                              static_cast<int>( std::round( units::to_fahrenheit<float>( temperature ) ) ), 1.0f );
+        if( rot / food.get_shelf_life() > 2.0 ) {
+            return rot;
+        }
+    }
+    const units::temperature temperature = rot::clip_by_temperature_flag(
+            units::from_fahrenheit( weather.get_temperature( pos ) ), flag );
+    return rot + rot::rot_over( to - time,
+                                static_cast<int>( std::round( units::to_fahrenheit<float>( temperature ) ) ), 1.0f );
+}
+
+TEST_CASE( "Rot outside the reality bubble matches hourly processing" )
+{
+    weather_manager weather;
+    set_map_temperature( weather, 65 );
+    ensure_no_temperature_mods( tripoint_zero );
+    if( calendar::turn <= calendar::start_of_cataclysm ) {
+        calendar::turn = calendar::start_of_cataclysm + 1_minutes;
+    }
+    const time_point start = calendar::turn;
+
+    SECTION( "Food that lasts" ) {
+        item food( "hardtack" );
+        food.process( nullptr, tripoint_zero, false, temperature_flag::TEMP_NORMAL, weather );
+        calendar::turn = start + 30_days + 25_minutes;
+        const time_duration expected = rot_hour_by_hour( weather, food, tripoint_zero, start,
+                                       calendar::turn, temperature_flag::TEMP_NORMAL );
+        CHECK_FALSE( food.process_rot( false, tripoint_zero, nullptr, temperature_flag::TEMP_NORMAL,
+                                       weather ) );
+        CHECK( food.get_rot() == expected );
+    }
+
+    SECTION( "Food that rots away" ) {
+        item food( "meat_cooked" );
+        food.process( nullptr, tripoint_zero, false, temperature_flag::TEMP_HEATER, weather );
+        calendar::turn = start + 30_days + 25_minutes;
+        const time_duration expected = rot_hour_by_hour( weather, food, tripoint_zero, start,
+                                       calendar::turn, temperature_flag::TEMP_HEATER );
+        REQUIRE( expected / food.get_shelf_life() > 2.0 );
+        CHECK( food.process_rot( false, tripoint_zero, nullptr, temperature_flag::TEMP_HEATER,
+                                 weather ) );
+        CHECK( food.get_rot() == expected );
+    }
+}
@@ -1,10 +1,18 @@
 
 #include "scent_map.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+
 #include "catch/catch.hpp"
 #include "map.h"
 #include "map_helpers.h"
 #include "game.h"
+#include "rng.h"
 #include "state_helpers.h"
+#include "units.h"
+#include "vehicle.h"
 
 void old_scent_map_update( const tripoint &center, map &m,
                            std::array<std::array<int, MAPSIZE_Y>, MAPSIZE_X> &grscent );
@@ -170,3 +178,171 @@ TEST_CASE( "scent_matches_old", "[.]" )
     }
 }
 
+using int_scent_array = std::array<std::array<int, MAPSIZE_Y>, MAPSIZE_X>;
+
+// scent_map::update before it was rearranged for vectorization and scent was stored in 16 bits.
+static void scalar_scent_map_update( const tripoint &center, map &m, int_scent_array &grscent )
+{
+    std::array<std::array<char, MAPSIZE_Y>, MAPSIZE_X> scent_transfer;
+
+    std::array < std::array < int, 3 + SCENT_RADIUS * 2 >, 1 + SCENT_RADIUS * 2 > new_scent;
+    std::array < std::array < int, 3 + SCENT_RADIUS * 2 >, 1 + SCENT_RADIUS * 2 > sum_3_scent_y;
+    std::array < std::array < char, 3 + SCENT_RADIUS * 2 >, 1 + SCENT_RADIUS * 2 > squares_used_y;
+
+    diagonal_blocks( &blocked_cache )[MAPSIZE_X][MAPSIZE_Y] = m.access_cache(
+                center.z ).vehicle_obstructed_cache;
+
+    const int scentmap_minx = center.x - SCENT_RADIUS;
+    const int scentmap_maxx = center.x + SCENT_RADIUS;
+    const int scentmap_miny = center.y - SCENT_RADIUS;
+    const int scentmap_maxy = center.y + SCENT_RADIUS;
+
+    m.scent_blockers( scent_transfer, point( scentmap_minx - 1, scentmap_miny - 1 ),
+                      point( scentmap_maxx + 1, scentmap_maxy + 1 ) );
+
+    for( int x = 0; x < SCENT_RADIUS * 2 + 3; ++x ) {
+        for( int y = 0; y < SCENT_RADIUS * 2 + 1; ++y ) {
+            point abs( x + scentmap_minx - 1, y + scentmap_miny );
+            sum_3_scent_y[y][x] = 0;
+            squares_used_y[y][x] = 0;
+            for( int i = abs.y - 1; i <= abs.y + 1; ++i ) {
+                sum_3_scent_y[y][x] += scent_transfer[abs.x][i] * grscent[abs.x][i];
+                squares_used_y[y][x] += scent_transfer[abs.x][i];
+            }
+        }
+    }
+
+    for( int x = 1; x < SCENT_RADIUS * 2 + 2; ++x ) {
+        for( int y = 0; y < SCENT_RADIUS * 2 + 1; ++y ) {
+            const point abs( x + scentmap_minx - 1, y + scentmap_miny );
+
+            int squares_used = squares_used_y[y][x - 1] + squares_used_y[y][x] + squares_used_y[y][x + 1];
+            int total = sum_3_scent_y[y][x - 1] + sum_3_scent_y[y][x] + sum_3_scent_y[y][x + 1];
+
+            if( blocked_cache[abs.x][abs.y].nw && scent_transfer[abs.x + 1][abs.y + 1] == 5 ) {
+                squares_used -= 4;
+                total -= 4 * grscent[abs.x + 1][abs.y + 1];
+            }
+            if( blocked_cache[abs.x][abs.y].ne && scent_transfer[abs.x - 1][abs.y + 1] == 5 ) {
+                squares_used -= 4;
+                total -= 4 * grscent[abs.x - 1][abs.y + 1];
+            }
+            if( blocked_cache[abs.x - 1][abs.y - 1].nw && scent_transfer[abs.x - 1][abs.y - 1] == 5 ) {
+                squares_used -= 4;
+                total -= 4 * grscent[abs.x - 1][abs.y - 1];
+            }
+            if( blocked_cache[abs.x + 1][abs.y - 1].ne && scent_transfer[abs.x + 1][abs.y - 1] == 5 ) {
+                squares_used -= 4;
+                total -= 4 * grscent[abs.x + 1][abs.y - 1];
+            }
+
+            int temp_scent =  grscent[abs.x][abs.y] * ( 250 - squares_used  *
+                              scent_transfer[abs.x][abs.y] ) ;
+            temp_scent -=  grscent[abs.x][abs.y] * scent_transfer[abs.x][abs.y] *
+                           ( 45 - squares_used ) / 5;
+
+            new_scent[y][x] = ( temp_scent + total * scent_transfer[abs.x][abs.y] ) / 250;
+        }
+    }
+    for( int x = 1; x < SCENT_RADIUS * 2 + 2; ++x ) {
+        for( int y = 0; y < SCENT_RADIUS * 2 + 1; ++y ) {
+            grscent[x + scentmap_minx - 1 ][y + scentmap_miny] = new_scent[y][x];
+        }
+    }
+}
+
+// Gives one tile in five a scent between @p lo and @p hi, in @ref g->scent and in @p expected.
+static void seed_scent( int_scent_array &expected, const int lo, const int hi )
+{
+    g->scent.reset();
+    for( int x = 0; x < MAPSIZE_X; x++ ) {
+        for( int y = 0; y < MAPSIZE_Y; y++ ) {
+            const int value = one_in( 5 ) ? rng( lo, hi ) : 0;
+            g->scent.set( { x, y, 0 }, value, scenttype_id( "sc_human" ) );
+            // Scent is stored in 16 bits, so more than that is cut off when it's set.
+            expected[x][y] = std::min<int>( value, std::numeric_limits<int16_t>::max() );
+        }
+    }
+}
+
+static void check_scent_matches_scalar_update( const tripoint &origin, map &here,
+        int_scent_array &expected )
+{
+    for( int turn = 0; turn < 5; turn++ ) {
+        g->scent.update( origin, here );
+        scalar_scent_map_update( origin, here, expected );
+    }
+    for( int x = 0; x < MAPSIZE_X; x++ ) {
+        for( int y = 0; y < MAPSIZE_Y; y++ ) {
+            INFO( x );
+            INFO( y );
+            CHECK( g->scent.get( { x, y, 0 } ) == expected[x][y] );
+        }
+    }
+}
+
+TEST_CASE( "scent_matches_scalar_update", "[scent]" )
+{
+    clear_all_state();
+    const tripoint origin( 60, 60, 0 );
+    g->place_player( origin );
+    map &here = get_map();
+    int_scent_array expected;
+
+    SECTION( "random walls" ) {
+        for( int i = 0; i < 400; i++ ) {
+            const tripoint p( rng( 15, 105 ), rng( 15, 105 ), 0 );
+            here.ter_set( p, one_in( 2 ) ? t_brick_wall : t_door_b );
+        }
+        seed_scent( expected, 0, 5000 );
+        check_scent_matches_scalar_update( origin, here, expected );
+    }
+
+    SECTION( "scent close to what fits into 16 bits" ) {
+        for( int i = 0; i < 200; i++ ) {
+            here.ter_set( tripoint( rng( 15, 105 ), rng( 15, 105 ), 0 ), t_brick_wall );
+        }
+        seed_scent( expected, 30000, 40000 );
+        check_scent_matches_scalar_update( origin, here, expected );
+    }
+
+    SECTION( "vehicles and walls with holes" ) {
+        // Parts of vehicles turned by 45 degrees block diagonal moves between them.
+        here.add_vehicle( vproto_id( "apc" ), origin + point( -12, -12 ), -45_degrees, 0, 0 );
+        here.add_vehicle( vproto_id( "car" ), origin + point( 12, 8 ), 0_degrees, 0, 0 );
+        // A wall around the player with a gap in every side and a door in one corner.
+        for( int i = -20; i <= 20; i++ ) {
+            if( i % 7 != 0 ) {
+                here.ter_set( origin + point( i, -20 ), t_brick_wall );
+                here.ter_set( origin + point( i, 20 ), t_brick_wall );
+                here.ter_set( origin + point( -20, i ), t_brick_wall );
+                here.ter_set( origin + point( 20, i ), t_brick_wall );
+            }
+        }
+        here.ter_set( origin + point( 20, 20 ), t_door_b );
+        here.build_map_cache( 0 );
+        seed_scent( expected, 0, 32767 );
+        check_scent_matches_scalar_update( origin, here, expected );
+    }
+}
+
+TEST_CASE( "scent_update_benchmark", "[.][scent][benchmark]" )
+{
+    clear_all_state();
+    const tripoint origin( 60, 60, 0 );
+    g->place_player( origin );
+    map &here = get_map();
+    g->scent.reset();
+    g->scent.set( origin, 1000, scenttype_id( "sc_human" ) );
+    int_scent_array reference = {};
+    reference[origin.x][origin.y] = 1000;
+
+    BENCHMARK( "scent_map::update" ) {
+        g->scent.update( origin, here );
+        return g->scent.get( origin );
+    };
+    BENCHMARK( "scalar update with int scent" ) {
+        scalar_scent_map_update( origin, here, reference );
+        return reference[origin.x][origin.y];
+    };
+}
@@ -1,7 +1,9 @@
 #include "catch/catch.hpp"
 
+#include <algorithm>
 #include <array>
 #include <chrono>
+#include <cmath>
 #include <cstdio>
 #include <functional>
 #include <memory>
@@ -670,3 +672,160 @@ TEST_CASE( "bresenham_vs_shadowcasting", "[.]" )
     clear_all_state();
     shadowcasting_runoff( 1, true );
 }
+
+// castLight before the intensity was calculated once per distance in a row, to compare against.
+template<int xx, int xy, int yx, int yy>
+static void perTileCastLight( float ( &output_cache )[MAPSIZE_X][MAPSIZE_Y],
+                              const float ( &input_array )[MAPSIZE_X][MAPSIZE_Y],
+                              const diagonal_blocks( &blocked_array )[MAPSIZE_X][MAPSIZE_Y],
+                              const point offset, const int row = 1, float start = 1.0f,
+                              const float end = 0.0f,
+                              const float cumulative_transparency = LIGHT_TRANSPARENCY_OPEN_AIR )
+{
+    constexpr int qx = -xx - xy;
+    constexpr int qy = -yx - yy;
+    const auto check_blocked = [&blocked_array]( point p ) {
+        if( qx > 0 ) {
+            return qy > 0 ? blocked_array[p.x][p.y].nw :
+                   p.x > 1 && p.y < MAPSIZE_Y - 1 && blocked_array[p.x - 1][p.y + 1].ne;
+        }
+        return qy > 0 ? blocked_array[p.x][p.y].ne :
+               p.x < MAPSIZE_X - 1 && p.y < MAPSIZE_Y - 1 && blocked_array[p.x + 1][p.y + 1].nw;
+    };
+
+    float newStart = 0.0f;
+    const float radius = 60.0f;
+    if( start < end ) {
+        return;
+    }
+    float cumulative = cumulative_transparency;
+    float last_intensity = 0.0f;
+    tripoint delta;
+    for( int distance = row; distance <= radius; distance++ ) {
+        delta.y = -distance;
+        bool started_row = false;
+        float current_transparency = 0.0f;
+        const float away = start - ( -distance + 0.5f ) / ( -distance - 0.5f );
+        delta.x = -distance + std::max( static_cast<int>( std::ceil( away * ( -distance - 0.5f ) ) ), 0 );
+
+        for( ; delta.x <= 0; delta.x++ ) {
+            const point current( offset.x + delta.x * xx + delta.y * xy,
+                                 offset.y + delta.x * yx + delta.y * yy );
+            const float trailingEdge = ( delta.x - 0.5f ) / ( delta.y + 0.5f );
+            const float leadingEdge = ( delta.x + 0.5f ) / ( delta.y - 0.5f );
+
+            if( !( current.x >= 0 && current.y >= 0 && current.x < MAPSIZE_X &&
+                   current.y < MAPSIZE_Y ) ) {
+                continue;
+            } else if( end > trailingEdge ) {
+                break;
+            }
+            if( check_blocked( current ) ) {
+                continue;
+            }
+            if( !started_row ) {
+                started_row = true;
+                current_transparency = input_array[current.x][current.y];
+            }
+
+            const int dist = rl_dist( tripoint_zero, delta );
+            last_intensity = sight_calc( VISIBILITY_FULL, cumulative, dist );
+
+            const float new_transparency = input_array[current.x][current.y];
+            update_light( output_cache[current.x][current.y], last_intensity, quadrant::default_ );
+
+            if( new_transparency == current_transparency ) {
+                newStart = leadingEdge;
+                continue;
+            }
+            if( sight_check( current_transparency, last_intensity ) ) {
+                perTileCastLight<xx, xy, yx, yy>( output_cache, input_array, blocked_array, offset,
+                                                  distance + 1, start, trailingEdge,
+                                                  accumulate_transparency( cumulative, current_transparency, distance ) );
+            }
+            if( !sight_check( current_transparency, last_intensity ) ) {
+                start = newStart;
+            } else {
+                start = trailingEdge;
+            }
+            if( start < end ) {
+                return;
+            }
+            current_transparency = new_transparency;
+            newStart = leadingEdge;
+        }
+        if( !sight_check( current_transparency, last_intensity ) ) {
+            break;
+        }
+        cumulative = accumulate_transparency( cumulative, current_transparency, distance );
+    }
+}
+
+static void perTileCastLightAll( float ( &output_cache )[MAPSIZE_X][MAPSIZE_Y],
+                                 const float ( &input_array )[MAPSIZE_X][MAPSIZE_Y],
+                                 const diagonal_blocks( &blocked_array )[MAPSIZE_X][MAPSIZE_Y],
+                                 const point offset )
+{
+    perTileCastLight<0, 1, 1, 0>( output_cache, input_array, blocked_array, offset );
+    perTileCastLight<1, 0, 0, 1>( output_cache, input_array, blocked_array, offset );
+    perTileCastLight < 0, -1, 1, 0 > ( output_cache, input_array, blocked_array, offset );
+    perTileCastLight < -1, 0, 0, 1 > ( output_cache, input_array, blocked_array, offset );
+    perTileCastLight < 0, 1, -1, 0 > ( output_cache, input_array, blocked_array, offset );
+    perTileCastLight < 1, 0, 0, -1 > ( output_cache, input_array, blocked_array, offset );
+    perTileCastLight < 0, -1, -1, 0 > ( output_cache, input_array, blocked_array, offset );
+    perTileCastLight < -1, 0, 0, -1 > ( output_cache, input_array, blocked_array, offset );
+}
+
+static void benchmark_castLightAll( const unsigned int numerator, const unsigned int denominator )
+{
+    static float seen_squares[MAPSIZE * SEEX][MAPSIZE * SEEY];
+    static float per_tile_squares[MAPSIZE * SEEX][MAPSIZE * SEEY];
+    static float transparency_cache[MAPSIZE * SEEX][MAPSIZE * SEEY];
+    static diagonal_blocks blocked_cache[MAPSIZE * SEEX][MAPSIZE * SEEY];
+    randomly_fill_transparency( transparency_cache, numerator, denominator );
+    std::uninitialized_fill_n( &blocked_cache[0][0], MAPSIZE * SEEX * MAPSIZE * SEEY,
+                               diagonal_blocks{ false, false } );
+    const point origin( 65, 65 );
+
+    // Both versions have to agree exactly for the comparison to mean anything.
+    std::uninitialized_fill_n( &seen_squares[0][0], MAPSIZE * SEEX * MAPSIZE * SEEY,
+                               LIGHT_TRANSPARENCY_SOLID );
+    std::uninitialized_fill_n( &per_tile_squares[0][0], MAPSIZE * SEEX * MAPSIZE * SEEY,
+                               LIGHT_TRANSPARENCY_SOLID );
+    castLightAll<float, float, sight_calc, sight_check, update_light, accumulate_transparency>(
+        seen_squares, transparency_cache, blocked_cache, origin, 0 );
+    perTileCastLightAll( per_tile_squares, transparency_cache, blocked_cache, origin );
+    for( int x = 0; x < MAPSIZE * SEEX; ++x ) {
+        for( int y = 0; y < MAPSIZE * SEEY; ++y ) {
+            REQUIRE( seen_squares[x][y] == per_tile_squares[x][y] );
+        }
+    }
+
+    BENCHMARK( "castLightAll" ) {
+        std::uninitialized_fill_n( &seen_squares[0][0], MAPSIZE * SEEX * MAPSIZE * SEEY,
+                                   LIGHT_TRANSPARENCY_SOLID );
+        castLightAll<float, float, sight_calc, sight_check, update_light, accumulate_transparency>(
+            seen_squares, transparency_cache, blocked_cache, origin, 0 );
+        return seen_squares[0][0];
+    };
+    BENCHMARK( "castLightAll, intensity per tile" ) {
+        std::uninitialized_fill_n( &seen_squares[0][0], MAPSIZE * SEEX * MAPSIZE * SEEY,
+                                   LIGHT_TRANSPARENCY_SOLID );
+        perTileCastLightAll( seen_squares, transparency_cache, blocked_cache, origin );
+        return seen_squares[0][0];
+    };
+}
+
+TEST_CASE( "shadowcasting_benchmark", "[.][shadowcasting][benchmark]" )
+{
+    clear_all_state();
+    SECTION( "open map" ) {
+        benchmark_castLightAll( 0, 1 );
+    }
+    SECTION( "sparse walls" ) {
+        benchmark_castLightAll( NUMERATOR, DENOMINATOR );
+    }
+    SECTION( "dense walls" ) {
+        benchmark_castLightAll( 1, 3 );
+    }
+}
@@ -1,9 +1,17 @@
 #include "catch/catch.hpp"
 
+#include <sstream>
+#include <string>
+
 #include "submap.h"
+#include "calendar.h"
+#include "fstream_utils.h"
+#include "game.h"
 #include "game_constants.h"
 #include "int_id.h"
+#include "json.h"
 #include "point.h"
+#include "string_id.h"
 #include "type_id.h"
 
 TEST_CASE( "submap rotation", "[submap]" )
@@ -90,3 +98,104 @@ TEST_CASE( "submap rotation", "[submap]" )
         }
     }
 }
+
+static std::string submap_as_json( const submap &sm )
+{
+    return serialize_wrapper( [&sm]( JsonOut & jsout ) {
+        jsout.start_object();
+        sm.store( jsout );
+        jsout.end_object();
+    } );
+}
+
+static void fill_test_submap( submap &sm )
+{
+    sm.set_all_ter( ter_id( "t_dirt" ) );
+    sm.set_ter( point( 3, 4 ), ter_id( "t_grass" ) );
+    sm.set_ter( point( SEEX - 1, SEEY - 1 ), ter_id( "t_grass" ) );
+    sm.set_furn( point( 5, 6 ), furn_str_id( "f_chair" ) );
+    sm.set_trap( point( 7, 8 ), trap_str_id( "tr_bubblewrap" ).id() );
+    sm.set_radiation( point( 9, 1 ), 42 );
+    sm.set_radiation( point( SEEX - 1, SEEY - 1 ), 7 );
+    sm.set_temperature( 13 );
+}
+
+static void check_same_tiles( const submap &a, const submap &b )
+{
+    for( int x = 0; x < SEEX; x++ ) {
+        for( int y = 0; y < SEEY; y++ ) {
+            const point p( x, y );
+            CAPTURE( p );
+            CHECK( a.get_ter( p ) == b.get_ter( p ) );
+            CHECK( a.get_furn( p ) == b.get_furn( p ) );
+            CHECK( a.get_trap( p ) == b.get_trap( p ) );
+            CHECK( a.get_radiation( p ) == b.get_radiation( p ) );
+        }
+    }
+}
+
+TEST_CASE( "submap JSON serialization round trip", "[submap][savegame]" )
+{
+    submap sm;
+    fill_test_submap( sm );
+
+    submap loaded;
+    deserialize_wrapper( [&loaded]( JsonIn & jsin ) {
+        jsin.start_object();
+        while( !jsin.end_object() ) {
+            const std::string member_name = jsin.get_member_name();
+            loaded.load( jsin, member_name, savegame_version );
+        }
+    }, submap_as_json( sm ) );
+
+    check_same_tiles( sm, loaded );
+    CHECK( submap_as_json( sm ) == submap_as_json( loaded ) );
+}
+
+TEST_CASE( "submap binary serialization round trip", "[submap][savegame]" )
+{
+    submap sm;
+    fill_test_submap( sm );
+
+    std::stringstream buf;
+    sm.store_binary( buf );
+    submap loaded;
+    loaded.load_binary( buf, savegame_version );
+
+    check_same_tiles( sm, loaded );
+    CHECK( loaded.get_temperature() == 13 );
+    CHECK( submap_as_json( sm ) == submap_as_json( loaded ) );
+
+    SECTION( "truncated data is rejected" ) {
+        const std::string data = buf.str();
+        std::stringstream truncated( data.substr( 0, data.size() / 2 ) );
+        submap broken;
+        CHECK_THROWS( broken.load_binary( truncated, savegame_version ) );
+    }
+}
+
+TEST_CASE( "submap tracks changes since the last save", "[submap][savegame]" )
+{
+    submap sm;
+    CHECK( sm.needs_saving() );
+    sm.mark_saved();
+    CHECK_FALSE( sm.needs_saving() );
+
+    sm.set_ter( point( 3, 4 ), ter_id( "t_grass" ) );
+    CHECK( sm.needs_saving() );
+    sm.mark_saved();
+    CHECK_FALSE( sm.needs_saving() );
+
+    sm.set_radiation( point_zero, 5 );
+    CHECK( sm.needs_saving() );
+    sm.mark_saved();
+    CHECK_FALSE( sm.needs_saving() );
+
+    // Actualize effects are applied again on load unless the new time is saved.
+    sm.set_last_touched( sm.last_touched );
+    CHECK_FALSE( sm.needs_saving() );
+    sm.set_last_touched( sm.last_touched + 1_turns );
+    CHECK( sm.needs_saving() );
+    sm.mark_saved();
+    CHECK_FALSE( sm.needs_saving() );
+}
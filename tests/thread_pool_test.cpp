@@ -0,0 +1,29 @@
+#include "catch/catch.hpp"
+
+#include <future>
+#include <stdexcept>
+#include <vector>
+
+#include "thread_pool.h"
+
+TEST_CASE( "thread pool runs submitted tasks", "[thread_pool]" )
+{
+    thread_pool pool( 2 );
+    std::vector<std::future<int>> results;
+    for( int i = 0; i < 100; i++ ) {
+        results.push_back( pool.submit( [i]() {
+            return i * i;
+        } ) );
+    }
+    for( int i = 0; i < 100; i++ ) {
+        CHECK( results[i].get() == i * i );
+    }
+}
+
+TEST_CASE( "thread pool passes exceptions to the future", "[thread_pool]" )
+{
+    std::future<void> result = get_thread_pool().submit( []() {
+        throw std::runtime_error( "task failed" );
+    } );
+    CHECK_THROWS_AS( result.get(), std::runtime_error );
+}
@@ -241,3 +241,30 @@ TEST_CASE( "Vehicle charging station", "[vehicle][power]" )
     }
 
 }
+
+TEST_CASE( "vehicles_returning_after_long_absence_benchmark", "[.][vehicle][power][benchmark]" )
+{
+    clear_all_state();
+    build_test_map( ter_id( "t_pavement" ) );
+    map &here = get_map();
+    get_weather().weather_override = weather_type_id::NULL_ID();
+
+    std::vector<vehicle *> vehicles;
+    for( int x = 10; x < 60; x += 8 ) {
+        for( int y = 10; y < 60; y += 8 ) {
+            vehicle *veh_ptr = here.add_vehicle( vproto_id( "solar_panel_test" ), tripoint( x, y, 0 ),
+                                                 0_degrees, 0, 0 );
+            REQUIRE( veh_ptr != nullptr );
+            vehicles.push_back( veh_ptr );
+        }
+    }
+
+    const time_point left = calendar::turn_zero + calendar::season_length();
+    BENCHMARK( "30 days away" ) {
+        for( vehicle *veh : vehicles ) {
+            veh->last_update = left;
+            veh->update_time( left + 30_days );
+        }
+        return vehicles.front()->fuel_left( fuel_type_battery );
+    };
+}
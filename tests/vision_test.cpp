@@ -11,6 +11,7 @@
 #include <vector>
 
 #include "calendar.h"
+#include "cata_utility.h"
 #include "character.h"
 #include "field.h"
 #include "game.h"
@@ -21,8 +22,10 @@
 #include "map_helpers.h"
 #include "player_helpers.h"
 #include "point.h"
+#include "rng.h"
 #include "shadowcasting.h"
 #include "state_helpers.h"
+#include "thread_pool.h"
 #include "type_id.h"
 #include "weather.h"
 #include "vehicle.h"
@@ -717,3 +720,69 @@ TEST_CASE( "vision_see_into_vehicle", "[shadowcasting][vision]" )
 
     t.test();
 }
+
+TEST_CASE( "seen cache updates match a full rebuild", "[shadowcasting][vision]" )
+{
+    clear_all_state();
+    const bool old_fov_3d = fov_3d;
+    fov_3d = false;
+    map &here = get_map();
+    const tripoint origin = get_player_character().pos();
+    build_test_map( t_floor );
+    here.build_map_cache( origin.z );
+
+    const level_cache &cache = here.access_cache( origin.z );
+    std::vector<float> updated( MAPSIZE_X * MAPSIZE_Y );
+    for( int i = 0; i < 30; i++ ) {
+        const tripoint p = origin + point( rng( -20, 20 ), rng( -20, 20 ) );
+        if( p == origin ) {
+            continue;
+        }
+        here.ter_set( p, here.ter( p ) == t_floor ? t_wall : t_floor );
+        here.build_map_cache( origin.z );
+        REQUIRE( cache.seen_cache_origin == origin );
+        std::copy_n( &cache.seen_cache[0][0], updated.size(), updated.begin() );
+
+        here.set_seen_cache_dirty( origin.z );
+        here.build_map_cache( origin.z );
+        INFO( "changed " << p );
+        CHECK( std::equal( updated.begin(), updated.end(), &cache.seen_cache[0][0] ) );
+    }
+    fov_3d = old_fov_3d;
+}
+
+TEST_CASE( "light sources cast in parallel match casting them serially", "[shadowcasting][vision]" )
+{
+    clear_all_state();
+    map &here = get_map();
+    const tripoint origin = get_player_character().pos();
+    const ter_id t_utility_light( "t_utility_light" );
+    build_test_map( t_floor );
+    // Enough overlapping sources and walls between them that every batch gets some.
+    for( int i = 0; i < 400; i++ ) {
+        const tripoint p = origin + point( rng( -40, 40 ), rng( -40, 40 ) );
+        here.ter_set( p, one_in( 3 ) ? t_utility_light : t_wall );
+    }
+    here.ter_set( origin, t_floor );
+    if( get_thread_pool().size() == 0 ) {
+        WARN( "No worker threads, both lightmaps are cast serially." );
+    }
+
+    restore_on_out_of_scope<bool> restore_parallel( parallel_light_sources );
+    const level_cache &cache = here.access_cache( origin.z );
+    parallel_light_sources = false;
+    here.build_map_cache( origin.z );
+    std::vector<four_quadrants> serial( &cache.lm[0][0], &cache.lm[0][0] + MAPSIZE_X * MAPSIZE_Y );
+
+    parallel_light_sources = true;
+    here.build_map_cache( origin.z );
+    for( int x = 0; x < MAPSIZE_X; x++ ) {
+        for( int y = 0; y < MAPSIZE_Y; y++ ) {
+            const four_quadrants &expected = serial[x * MAPSIZE_Y + y];
+            INFO( x << ", " << y );
+            for( quadrant q : { quadrant::NE, quadrant::SE, quadrant::SW, quadrant::NW } ) {
+                CHECK( cache.lm[x][y][q] == expected[q] );
+            }
+        }
+    }
+}
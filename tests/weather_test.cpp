@@ -6,6 +6,7 @@
 
 #include "calendar.h"
 #include "point.h"
+#include "type_id.h"
 #include "weather.h"
 #include "weather_gen.h"
 
@@ -328,3 +329,31 @@ TEST_CASE( "local wind chill calculation", "[weather][wind_chill]" )
         }
     }
 }
+
+TEST_CASE( "weather sums don't depend on how the time is split", "[weather]" )
+{
+    get_weather().weather_override = weather_type_id::NULL_ID();
+    const tripoint location( 1000, 2000, 0 );
+    const time_point start = calendar::turn_zero + 3_days + 17_minutes + 5_turns;
+    const time_point middle = start + 2_days + 41_turns;
+    const time_point end = middle + 3_days + 7_hours;
+
+    const weather_sum whole = sum_conditions( start, end, location );
+    const weather_sum first = sum_conditions( start, middle, location );
+    const weather_sum second = sum_conditions( middle, end, location );
+    CHECK( first.rain_amount + second.rain_amount == whole.rain_amount );
+    CHECK( first.acid_amount + second.acid_amount == whole.acid_amount );
+    CHECK( first.sunlight + second.sunlight == Approx( whole.sunlight ) );
+    CHECK( first.wind_amount + second.wind_amount == whole.wind_amount );
+
+    // Longer sums nearby extend the remembered history in both directions
+    sum_conditions( start - 20_days, end + 1_days, location + point_east );
+    const weather_sum again = sum_conditions( start, end, location );
+    CHECK( again.rain_amount == whole.rain_amount );
+    CHECK( again.acid_amount == whole.acid_amount );
+    CHECK( again.sunlight == Approx( whole.sunlight ) );
+
+    const weather_sum nothing = sum_conditions( end, end, location );
+    CHECK( nothing.rain_amount == 0 );
+    CHECK( nothing.sunlight == 0.0f );
+}